@@ -0,0 +1,121 @@
+#include "crypto.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+/* This benchmark compares the crypto backends uvgRTP has been built with.
+ *
+ * Every SRTP packet is protected with either AES-CM and a 80-bit HMAC-SHA1
+ * tag or with AES-GCM. This program measures the per-packet cost of these
+ * transforms on each backend for typical RTP payload sizes, from audio
+ * frames to full-MTU video packets.
+ *
+ * Usage: crypto_backends [packets per measurement] */
+
+
+constexpr size_t RTP_HEADER_SIZE = 12;
+constexpr size_t AUTH_TAG_SIZE   = 10;
+constexpr size_t GCM_TAG_SIZE    = 16;
+
+constexpr int DEFAULT_PACKETS = 200000;
+
+const size_t PAYLOAD_SIZES[] = { 64, 160, 512, 1200, 1400 };
+
+template <typename F>
+static double measure_ns(int packets, F&& protect)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < packets; ++i) {
+        protect((uint32_t)i);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / packets;
+}
+
+static void print_result(const char *transform, size_t size, double ns)
+{
+    std::cout << "  " << std::left << std::setw(20) << transform
+              << std::right << std::setw(6) << size << " B"
+              << std::setw(12) << std::fixed << std::setprecision(1) << ns << " ns/packet"
+              << std::setw(12) << std::fixed << std::setprecision(1) << (size * 1000.0 / ns) << " MB/s"
+              << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    int packets = argc > 1 ? atoi(argv[1]) : DEFAULT_PACKETS;
+
+    if (packets <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [packets per measurement]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<uvgrtp::crypto::backend::library *> libs = uvgrtp::crypto::backend::available();
+
+    if (libs.empty()) {
+        std::cerr << "uvgRTP has been built without crypto, nothing to benchmark" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint8_t key[16]  = { 0 };
+    uint8_t salt[16] = { 0 };
+    uint8_t tag[GCM_TAG_SIZE];
+
+    for (size_t i = 0; i < sizeof(key); ++i) {
+        key[i]  = (uint8_t)(i * 7 + 1);
+        salt[i] = (uint8_t)(i * 13 + 5);
+    }
+
+    for (uvgrtp::crypto::backend::library *lib : libs) {
+        std::cout << lib->name() << ", " << packets << " packets per measurement" << std::endl;
+
+        auto ctr  = lib->aes_ctr(key, sizeof(key), salt);
+        auto hmac = lib->hmac_sha1(key, sizeof(key));
+        auto gcm  = lib->aes_gcm(key, sizeof(key));
+
+        for (size_t size : PAYLOAD_SIZES) {
+            std::vector<uint8_t> packet(RTP_HEADER_SIZE + size + GCM_TAG_SIZE, 0xab);
+            uint8_t *header  = packet.data();
+            uint8_t *payload = packet.data() + RTP_HEADER_SIZE;
+
+            /* The IV changes with the packet index like it does in SRTP */
+            uint8_t iv[16];
+            memcpy(iv, salt, sizeof(iv));
+
+            double aes_cm = measure_ns(packets, [&](uint32_t index) {
+                memcpy(&iv[10], &index, sizeof(index));
+                ctr->set_iv(iv);
+                ctr->encrypt(payload, payload, size);
+            });
+
+            double hmac_sha1 = measure_ns(packets, [&](uint32_t index) {
+                hmac->update(packet.data(), RTP_HEADER_SIZE + size);
+                hmac->update((uint8_t *)&index, sizeof(index));
+                hmac->final(payload + size, AUTH_TAG_SIZE);
+            });
+
+            double aes_gcm = measure_ns(packets, [&](uint32_t index) {
+                memcpy(&iv[6], &index, sizeof(index));
+                gcm->set_iv(iv, 12);
+                gcm->authenticate(header, RTP_HEADER_SIZE);
+                gcm->encrypt(payload, payload, size);
+                gcm->final(tag, GCM_TAG_SIZE);
+            });
+
+            print_result("AES-CM",              size, aes_cm);
+            print_result("HMAC-SHA1-80",        size, hmac_sha1);
+            print_result("AES-CM+HMAC-SHA1-80", size, aes_cm + hmac_sha1);
+            print_result("AEAD_AES_128_GCM",    size, aes_gcm);
+        }
+
+        std::cout << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
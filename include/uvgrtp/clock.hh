@@ -45,6 +45,14 @@ namespace uvgrtp {
              * \return Difference of the timestamps in milliseconds
              */
             uint64_t diff_now(uint64_t then);
+
+            /// \cond DO_NOT_DOCUMENT
+            /* convert a UNIX time, such as a kernel timestamp, to NTP units */
+            uint64_t from_unix(uint64_t seconds, uint64_t nanoseconds);
+
+            /* the elapsed time between the NTP timestamps in units of "clock_rate", e.g. an RTP clock */
+            uint64_t diff_clock(uint64_t older, uint64_t newer, uint32_t clock_rate);
+            /// \endcond
         }
 
         /// \cond DO_NOT_DOCUMENT
@@ -3,12 +3,14 @@
 #include "util.hh"
 
 #include <map>
+#include <memory>
 #include <string>
 
 
 namespace uvgrtp {
 
     class session;
+    class reactor;
 
     /**
      * \brief Provides CNAME isolation and can be used to create uvgrtp::session objects
@@ -73,6 +75,33 @@ namespace uvgrtp {
              */
             rtp_error_t destroy_session(uvgrtp::session *session);
 
+            /**
+             * \brief Receive the RTP packets of this context on a shared pool of I/O threads
+             *
+             * \details By default every media_stream receives and processes packets using threads
+             * of its own. After the reactor has been enabled, media streams of sessions created
+             * with this context register their RTP sockets to a fixed pool of epoll(7) threads instead
+             * and each packet is processed by the thread that received it, like with @ref RCE_RUN_TO_COMPLETION.
+             * Sessions created before the call keep using their own threads.
+             *
+             * The RTCP sockets and report timer of @ref RCE_RTCP and the keep-alive timer of
+             * @ref RCE_HOLEPUNCH_KEEPALIVE are served by the same threads, so the number of threads
+             * does not grow with the number of media streams.
+             *
+             * Receive hooks are called from the I/O threads, so they should return quickly and
+             * must not destroy media streams.
+             *
+             * \param threads Number of I/O threads, 0 uses the number of hardware threads
+             *
+             * \return RTP error code
+             *
+             * \retval RTP_OK                On success
+             * \retval RTP_INVALID_VALUE     If the reactor has already been enabled
+             * \retval RTP_NOT_SUPPORTED     If the platform does not support epoll(7)
+             * \retval RTP_GENERIC_ERROR     If starting the I/O threads failed
+             */
+            rtp_error_t enable_reactor(unsigned int threads = 0);
+
             /// \cond DO_NOT_DOCUMENT
             std::string& get_cname();
             /// \endcond
@@ -91,6 +120,9 @@ namespace uvgrtp {
 
             /* CNAME is the same for all connections */
             std::string cname_;
+
+            /* I/O threads shared by the media streams, see enable_reactor() */
+            std::shared_ptr<uvgrtp::reactor> reactor_;
         };
 }
 
@@ -22,6 +22,9 @@
 
 namespace uvgrtp {
     namespace frame {
+        /// \cond DO_NOT_DOCUMENT
+        struct rx_buffer;
+        /// \endcond
 
         enum RTCP_FRAME_TYPE {
             RTCP_FT_SR   = 200, /* Sender report */
@@ -49,6 +52,12 @@ namespace uvgrtp {
             uint8_t *data = nullptr;
         });
 
+        /** \brief Part of a payload which is stored in several pieces of memory, see RCE_H26X_SCATTER_GATHER */
+        struct payload_fragment {
+            uint8_t *data = nullptr;
+            size_t len = 0;
+        };
+
         /** \brief See <a href="https://www.rfc-editor.org/rfc/rfc3550#section-5" target="_blank">RFC 3550 section 5</a> */
         struct rtp_frame {
             struct rtp_header header;
@@ -64,9 +73,28 @@ namespace uvgrtp {
             size_t payload_len = 0; 
             uint8_t* payload = nullptr;
 
+            /** \brief Arrival time of the packet as an NTP timestamp
+            *
+            *   \details Taken from the kernel receive timestamp of the datagram if the platform supports it,
+            *   otherwise the time uvgRTP read the datagram from the socket. For frames reassembled from
+            *   several packets, this is the arrival time of the packet that completed the frame
+            */
+            uint64_t arrival_ntp = 0;
+
+            /** \brief Ordered pieces of a NAL unit reassembled from fragmentation units
+            *
+            *   \details Only set with RCE_H26X_SCATTER_GATHER. The first fragment is the payload of the frame
+            *   (the start code and the NAL header) and the rest point to the payloads of the received packets.
+            *   The NAL unit is the concatenation of all fragments. Frames received in one packet have
+            *   no fragments and their NAL unit is in the payload. The memory is freed by frame::dealloc_frame()
+            */
+            payload_fragment *fragments = nullptr;
+            size_t fragment_count = 0;
+
             /// \cond DO_NOT_DOCUMENT
             uint8_t *dgram = nullptr;      /* pointer to the UDP datagram (for internal use only) */
             size_t   dgram_size = 0;       /* size of the UDP datagram */
+            rx_buffer *owner = nullptr;    /* refcounted receive buffer holding the payload (RCE_ZERO_COPY_RECEIVE) */
             /// \endcond
         };
 
@@ -24,6 +24,7 @@ namespace uvgrtp {
     class srtcp;
 
     class reception_flow;
+    class reactor;
     class holepuncher;
     class socket;
 
@@ -50,7 +51,7 @@ namespace uvgrtp {
         public:
             /// \cond DO_NOT_DOCUMENT
             media_stream(std::string cname, std::string remote_addr, std::string local_addr, uint16_t src_port, uint16_t dst_port,
-                rtp_format_t fmt, int rce_flags);
+                rtp_format_t fmt, int rce_flags, std::shared_ptr<uvgrtp::reactor> reactor = nullptr);
             ~media_stream();
 
             /* Initialize traditional RTP session
@@ -83,7 +84,7 @@ namespace uvgrtp {
              * to push_frame() will fail.
              *
              * \param key SRTP master key, default is 128-bit long
-             * \param salt 112-bit long salt
+             * \param salt 112-bit long salt, of which only the first 96 bits are used with RCE_SRTP_AEAD_AES_GCM
              *
              * \return RTP error code
              *
@@ -335,6 +336,9 @@ namespace uvgrtp {
             /* RTP packet reception flow. Dispatches packets to other components */
             std::unique_ptr<uvgrtp::reception_flow> reception_flow_;
 
+            /* I/O reactor of the context, if enabled. Receives RTP packets instead of reception flow threads */
+            std::shared_ptr<uvgrtp::reactor> reactor_;
+
             /* Media object associated with this media stream. */
             std::unique_ptr<uvgrtp::formats::media> media_;
 
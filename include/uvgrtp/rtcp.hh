@@ -19,6 +19,7 @@ namespace uvgrtp {
     class rtp;
     class srtcp;
     class socket;
+    class reactor;
 
     typedef std::vector<std::pair<size_t, uint8_t*>> buf_vec; // also defined in socket.hh
 
@@ -113,10 +114,11 @@ namespace uvgrtp {
             rtcp(std::shared_ptr<uvgrtp::rtp> rtp, std::shared_ptr<std::atomic<std::uint32_t>> ssrc, std::string cname, std::shared_ptr<uvgrtp::srtcp> srtcp, int rce_flags);
             ~rtcp();
 
-            /* start the RTCP runner thread
+            /* start the RTCP runner thread. If "reactor" is given, the reports are generated and
+             * the RTCP sockets read by its I/O threads instead
              *
              * return RTP_OK on success and RTP_MEMORY_ERROR if the allocation fails */
-            rtp_error_t start();
+            rtp_error_t start(std::shared_ptr<uvgrtp::reactor> reactor = nullptr);
 
             /* End the RTCP session and send RTCP BYE to all participants
              *
@@ -412,6 +414,15 @@ namespace uvgrtp {
 
             static void rtcp_runner(rtcp *rtcp, int interval);
 
+            /* Register the report timer and the RTCP sockets to "reactor_"
+             *
+             * Return RTP_OK on success
+             * Return RTP_GENERIC_ERROR if any of them could not be registered */
+            rtp_error_t start_on_reactor();
+
+            /* Read and handle the RTCP packets waiting in "socket", called by the reactor */
+            rtp_error_t read_socket(uvgrtp::socket& socket);
+
             /* when we start the RTCP instance, we don't know what the SSRC of the remote is
              * when an RTP packet is received, we must check if we've already received a packet
              * from this sender and if not, create new entry to receiver_stats_ map */
@@ -562,6 +573,12 @@ namespace uvgrtp {
 
             std::unique_ptr<std::thread> report_generator_;
 
+            /* I/O reactor serving the RTCP sockets and the report timer instead of "report_generator_",
+             * the keys of the registered sources and the buffer the packets are read to */
+            std::shared_ptr<uvgrtp::reactor> reactor_;
+            std::vector<uint64_t> reactor_keys_;
+            std::unique_ptr<uint8_t[]> reactor_buffer_;
+
             bool is_active() const
             {
                 return active_;
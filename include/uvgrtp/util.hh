@@ -274,9 +274,86 @@ enum RTP_CTX_ENABLE_FLAGS {
 
     /** Paces the sending of frame fragments within frame interval (default 1/30 s) */
     RCE_PACE_FRAGMENT_SENDING       = 1 << 20,
-    
+
+    /** Do not copy the payload of received RTP packets. Receiver side flag.
+     *
+     * The payload of the returned frame points directly to the reception buffer
+     * which is kept reserved until the frame is deallocated with uvgrtp::frame::dealloc_frame().
+     * Reduces the CPU usage of the receiver, but holding onto frames consumes more memory
+     * since each frame keeps a whole datagram buffer reserved */
+    RCE_ZERO_COPY_RECEIVE           = 1 << 21,
+
+    /** Process received packets in the thread that reads them from the socket. Receiver side flag.
+     *
+     * By default packets are handed from a receiver thread to a separate processing thread.
+     * With this flag, the packets are processed right after they have been read and the
+     * frames are returned from the receiving thread, which reduces latency and the number of threads.
+     * The receive hook must return quickly, since no packets are read while it is running */
+    RCE_RUN_TO_COMPLETION           = 1 << 22,
+
+    /** Use io_uring for socket I/O if uvgRTP was built with it and the kernel supports it.
+     *
+     * Received packets are read with a multishot recvmsg directly into the reception
+     * ring buffer, together with their UDP GRO segment sizes and kernel timestamps, and fragmented
+     * frames are sent as linked send requests, reducing the number of system calls at high packet rates. If io_uring is not available, the regular
+     * system calls are used. Not used for streams served by the context reactor */
+    RCE_IO_URING                    = 1 << 23,
+
+    /** Let the kernel coalesce received datagrams with UDP generic receive offload. Receiver side flag.
+     *
+     * Consecutive equally sized datagrams of the stream are read from the socket at once
+     * and split back into RTP packets by uvgRTP, reducing the per-packet cost of bursty high-bitrate
+     * streams. Each reception buffer slot is 64 KB so that a coalesced read fits in it.
+     * Only supported on Linux */
+    RCE_UDP_GRO                     = 1 << 24,
+
+    /** Send fragmented frames with UDP generic segmentation offload. Sender side flag.
+     *
+     * Consecutive equally sized packets of a frame are handed to the kernel as one buffer
+     * which is split into datagrams by the kernel or the network card, so an intra frame takes
+     * a few system calls instead of one per packet. uvgRTP falls back to sending the packets
+     * one by one if the kernel rejects GSO. Not used together with RCE_IO_URING. Only supported on Linux */
+    RCE_UDP_GSO                     = 1 << 25,
+
+    /** Scan large H26x frames for start codes on several threads. Sender side flag.
+     *
+     * Frames of at least 1 MB are split into chunks which are scanned by a pool of worker threads
+     * shared by all streams. The NAL units found are packetized and aggregated the same way as
+     * without this flag. Reduces the time it takes to send a large intra frame */
+    RCE_PARALLEL_SCL                = 1 << 26,
+
+    /** Deliver H26x NAL units reassembled from fragmentation units as a list of fragments
+     * instead of copying them into one buffer. Receiver side flag.
+     *
+     * The frame holds on to the received packets and rtp_frame::fragments points to their payloads
+     * in order, so decoders that accept scatter lists can read the NAL unit without any copies.
+     * The received packets stay allocated until the frame is deallocated, which with
+     * RCE_ZERO_COPY_RECEIVE also keeps their reception buffers in use */
+    RCE_H26X_SCATTER_GATHER         = 1 << 27,
+
+    /** Protect SRTP and SRTCP packets with AEAD_AES_128_GCM or AEAD_AES_256_GCM (RFC 7714)
+     * instead of AES-CM and HMAC-SHA1.
+     *
+     * The payload is encrypted and authenticated in one pass and each packet carries a 16-byte
+     * authentication tag, so RCE_SRTP_AUTHENTICATE_RTP is implied. The 256-bit transform is selected
+     * with RCE_SRTP_KEYSIZE_256. Cannot be used with RCE_SRTP_KEYSIZE_192 or RCE_SRTP_NULL_CIPHER.
+     *
+     * RFC 7714 master salts are 96 bits long, so only the first 12 bytes of the salt given
+     * to media_stream::add_srtp_ctx() are used and the last two are ignored.
+     *
+     * NOTE: this flag must be coupled with RCE_SRTP and used by both participants */
+    RCE_SRTP_AEAD_AES_GCM           = 1 << 28,
+
+    /** Encrypt and authenticate the packets of large frames on several threads. Sender side flag.
+     *
+     * The packets of a frame of at least 64 packets are split into batches which are protected
+     * by a pool of worker threads shared by all streams. A batch is sent while the next one
+     * is still being protected and the packets are sent in their original order.
+     * Only has an effect with RCE_SRTP */
+    RCE_PARALLEL_SRTP               = 1 << 29,
+
     /// \cond DO_NOT_DOCUMENT
-    RCE_LAST                        = 1 << 21
+    RCE_LAST                        = 1 << 30
    /// \endcond
 }; // maximum is 1 << 30 for int
 
@@ -323,7 +400,9 @@ enum RTP_CTX_CONFIGURATION_FLAGS {
      * Default is 500 milliseconds
      *
      * This is valid only for fragmented frames,
-     * i.e. RTP_FORMAT_H26X and RTP_FORMAT_GENERIC with RCE_FRAGMENT_GENERIC (TODO) */
+     * i.e. RTP_FORMAT_H26X and RTP_FORMAT_GENERIC with RCE_FRAGMENT_GENERIC.
+     * Frames are dropped earlier if the stream moves more than 64 packets past
+     * the newest fragment of an unfinished frame */
     RCC_PKT_MAX_DELAY    = 4,
 
     /** Change uvgRTP's default payload number in RTP header */
@@ -369,9 +448,58 @@ enum RTP_CTX_CONFIGURATION_FLAGS {
     */
     RCC_SSRC = 10,
 
+    /** How many received frames are held for uvgrtp::media_stream::pull_frame()
+     *
+     * Default is 1024 frames
+     *
+     * If the application does not pull frames fast enough, frames are dropped
+     * according to RCC_FRAME_QUEUE_POLICY. Not used if a receive hook has been installed */
+    RCC_FRAME_QUEUE_SIZE = 11,
+
+    /** Which frame is dropped when the frame queue is full, see RTP_FRAME_QUEUE_POLICY
+     *
+     * Default is RFQ_DROP_OLDEST */
+    RCC_FRAME_QUEUE_POLICY = 12,
+
+    /** How many bytes of fragments are held while waiting for the rest of the fragments of a frame
+     *
+     * Default is 64 MB
+     *
+     * When the limit is exceeded, the oldest unfinished frames are dropped.
+     * Valid only for RTP_FORMAT_GENERIC with RCE_FRAGMENT_GENERIC */
+    RCC_REASSEMBLY_MEMORY_LIMIT = 13,
+
+    /** How many packets the SRTP and SRTCP replay window covers, between 64 and 1024
+     *
+     * Default is 128 packets
+     *
+     * Authenticated packets older than the window are discarded along with replayed packets.
+     * Valid only with RCE_SRTP_REPLAY_PROTECTION */
+    RCC_SRTP_REPLAY_WINDOW = 14,
+
+    /** For how many upcoming packets the SRTP keystream is computed ahead of time, at most 4096
+     *
+     * Default is 0, which computes the keystream of each packet when it is sent
+     *
+     * The keystream is generated by a worker thread while the stream is idle, so encrypting
+     * a packet only XORs it with its keystream. Each packet takes the current payload size
+     * of memory, and packets with a larger payload are encrypted normally. Must be set after
+     * the SRTP context has been created. Valid only with RCE_SRTP when AES-CM is used */
+    RCC_SRTP_KEYSTREAM_PACKETS = 15,
+
     /// \cond DO_NOT_DOCUMENT
     RCC_LAST
     /// \endcond
 };
 
+/**
+ * \enum RTP_FRAME_QUEUE_POLICY
+ *
+ * \brief Values for RCC_FRAME_QUEUE_POLICY
+ */
+enum RTP_FRAME_QUEUE_POLICY {
+    RFQ_DROP_OLDEST = 0, ///< Drop the oldest queued frame to make room for the new one
+    RFQ_DROP_NEWEST = 1  ///< Drop the new frame, keeping the already queued frames
+};
+
 extern thread_local rtp_error_t rtp_errno;
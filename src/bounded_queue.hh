@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#ifndef UVGRTP_CACHE_LINE_SIZE
+#define UVGRTP_CACHE_LINE_SIZE 64
+#endif
+
+namespace uvgrtp {
+
+    /* Bounded lock-free queue based on Dmitry Vyukov's bounded MPMC queue
+     *
+     * Each cell carries a sequence number which tells whether the cell is ready to be
+     * written or read for the current lap of the ring, so producers and consumers only
+     * contend on their own position counter. The ring is rounded up to a power of two,
+     * but a separate count keeps the number of items at the exact capacity asked for.
+     *
+     * Reception flow uses this for the frames returned through pull_frame(). Frames are
+     * pushed by the thread processing packets and popped by the application. The producer
+     * may also pop when it has to drop the oldest frame, which is why the queue is MPMC safe. */
+    template <typename T>
+    class bounded_queue {
+        public:
+            explicit bounded_queue(size_t capacity):
+                cells_(),
+                mask_(0),
+                limit_(capacity),
+                count_(0),
+                enqueue_pos_(0),
+                dequeue_pos_(0)
+            {
+                size_t size = 2;
+                while (size < capacity)
+                    size <<= 1;
+
+                cells_ = std::unique_ptr<cell[]>(new cell[size]);
+                mask_  = size - 1;
+
+                for (size_t i = 0; i < size; ++i)
+                    cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            /* Return true if "item" was added to the queue
+             * Return false if the queue is full */
+            bool push(const T& item)
+            {
+                // the ring never holds more items than "count_" so a reserved push always finds a cell
+                if (count_.fetch_add(1, std::memory_order_acq_rel) >= limit_) {
+                    count_.fetch_sub(1, std::memory_order_acq_rel);
+                    return false;
+                }
+
+                cell *c;
+                size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+
+                for (;;) {
+                    c = &cells_[pos & mask_];
+                    size_t seq = c->sequence.load(std::memory_order_acquire);
+                    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+                    if (diff == 0) {
+                        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                            break;
+                    } else if (diff < 0) {
+                        count_.fetch_sub(1, std::memory_order_acq_rel);
+                        return false;
+                    } else {
+                        pos = enqueue_pos_.load(std::memory_order_relaxed);
+                    }
+                }
+
+                c->data = item;
+                c->sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+
+            /* Return true and write the oldest item to "item" on success
+             * Return false if the queue is empty */
+            bool pop(T& item)
+            {
+                cell *c;
+                size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+
+                for (;;) {
+                    c = &cells_[pos & mask_];
+                    size_t seq = c->sequence.load(std::memory_order_acquire);
+                    intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+                    if (diff == 0) {
+                        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                            break;
+                    } else if (diff < 0) {
+                        return false;
+                    } else {
+                        pos = dequeue_pos_.load(std::memory_order_relaxed);
+                    }
+                }
+
+                item = c->data;
+                c->sequence.store(pos + mask_ + 1, std::memory_order_release);
+                count_.fetch_sub(1, std::memory_order_acq_rel);
+                return true;
+            }
+
+            /* Approximate number of items in the queue, exact when there are no concurrent operations */
+            size_t size() const
+            {
+                size_t enqueued = enqueue_pos_.load(std::memory_order_acquire);
+                size_t dequeued = dequeue_pos_.load(std::memory_order_acquire);
+
+                return (enqueued > dequeued) ? enqueued - dequeued : 0;
+            }
+
+            size_t capacity() const
+            {
+                return limit_;
+            }
+
+        private:
+            struct cell {
+                std::atomic<size_t> sequence;
+                T data;
+            };
+
+            std::unique_ptr<cell[]> cells_;
+            size_t mask_;
+            size_t limit_;
+
+            // items pushed and not yet popped, at most "limit_"
+            alignas(UVGRTP_CACHE_LINE_SIZE) std::atomic<size_t> count_;
+
+            alignas(UVGRTP_CACHE_LINE_SIZE) std::atomic<size_t> enqueue_pos_;
+            alignas(UVGRTP_CACHE_LINE_SIZE) std::atomic<size_t> dequeue_pos_;
+    };
+}
+
+namespace uvg_rtp = uvgrtp;
@@ -57,6 +57,25 @@ uint64_t uvgrtp::clock::ntp::diff_now(uint64_t then)
     return ntp_diff_ms(then, now);
 }
 
+uint64_t uvgrtp::clock::ntp::from_unix(uint64_t seconds, uint64_t nanoseconds)
+{
+    uint64_t ntp_seconds  = seconds + EPOCH;
+    uint64_t ntp_fraction = (nanoseconds * NTP_SCALE_FRAC) / 1000000000ULL;
+
+    return (ntp_seconds << 32) | (ntp_fraction & 0xffffffff);
+}
+
+uint64_t uvgrtp::clock::ntp::diff_clock(uint64_t older, uint64_t newer, uint32_t clock_rate)
+{
+    if (older > newer)
+        return 0;
+
+    // the seconds and the fraction are scaled separately so that long sessions do not overflow
+    uint64_t elapsed = newer - older;
+
+    return (elapsed >> 32) * clock_rate + (((elapsed & 0xffffffff) * clock_rate) >> 32);
+}
+
 uvgrtp::clock::hrc::hrc_t uvgrtp::clock::hrc::now()
 {
     return std::chrono::high_resolution_clock::now();
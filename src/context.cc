@@ -5,6 +5,7 @@
 
 #include "crypto.hh"
 #include "debug.hh"
+#include "reactor.hh"
 #include "hostname.hh"
 #include "random.hh"
 
@@ -32,7 +33,8 @@ static inline std::string generate_string(size_t length)
     return str;
 }
 
-uvgrtp::context::context()
+uvgrtp::context::context():
+    reactor_(nullptr)
 {
     UVG_LOG_INFO("uvgRTP version: %s", uvgrtp::get_version().c_str());
 
@@ -64,7 +66,7 @@ uvgrtp::session *uvgrtp::context::create_session(std::string address)
         return nullptr;
     }
 
-    return new uvgrtp::session(get_cname(), address);
+    return new uvgrtp::session(get_cname(), address, reactor_);
 }
 
 uvgrtp::session *uvgrtp::context::create_session(std::string remote_addr, std::string local_addr)
@@ -75,7 +77,7 @@ uvgrtp::session *uvgrtp::context::create_session(std::string remote_addr, std::s
         return nullptr;
     }
 
-    return new uvgrtp::session(get_cname(), remote_addr, local_addr);
+    return new uvgrtp::session(get_cname(), remote_addr, local_addr, reactor_);
 }
 
 rtp_error_t uvgrtp::context::destroy_session(uvgrtp::session *session)
@@ -88,6 +90,28 @@ rtp_error_t uvgrtp::context::destroy_session(uvgrtp::session *session)
     return RTP_OK;
 }
 
+rtp_error_t uvgrtp::context::enable_reactor(unsigned int threads)
+{
+    if (reactor_)
+    {
+        UVG_LOG_ERROR("Reactor has already been enabled");
+        return RTP_INVALID_VALUE;
+    }
+
+    std::shared_ptr<uvgrtp::reactor> reactor = std::make_shared<uvgrtp::reactor>(threads);
+
+    rtp_error_t ret = reactor->start();
+    if (ret != RTP_OK)
+    {
+        return ret;
+    }
+
+    /* Sessions and media streams hold a reference to the reactor,
+     * so the I/O threads are stopped when the last of them is destroyed */
+    reactor_ = reactor;
+    return RTP_OK;
+}
+
 std::string uvgrtp::context::generate_cname() const
 {
     std::string host = uvgrtp::hostname::get_hostname();
@@ -2,17 +2,60 @@
 
 #include "debug.hh"
 
+#include <cstring>
+
+
+static void crypto_missing()
+{
+    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
+    exit(EXIT_FAILURE);
+}
+
+/* Return the selected backend or exit if uvgRTP has been built without crypto */
+static uvgrtp::crypto::backend::library& get_backend()
+{
+    uvgrtp::crypto::backend::library *lib = uvgrtp::crypto::backend::selected();
+
+    if (!lib)
+        crypto_missing();
+
+    return *lib;
+}
+
+/* ***************** backends ***************** */
+
+uvgrtp::crypto::backend::library *uvgrtp::crypto::backend::selected()
+{
+#if !defined(__RTP_CRYPTO__)
+    return nullptr;
+#elif defined(UVGRTP_CRYPTO_OPENSSL)
+    return openssl();
+#else
+    return cryptopp() ? cryptopp() : openssl();
+#endif
+}
+
+std::vector<uvgrtp::crypto::backend::library *> uvgrtp::crypto::backend::available()
+{
+    std::vector<library *> libs;
+
+    if (library *lib = selected())
+        libs.push_back(lib);
+
+    for (library *lib : { cryptopp(), openssl() }) {
+        if (lib && lib != selected())
+            libs.push_back(lib);
+    }
+
+    return libs;
+}
 
 /* ***************** hmac-sha1 ***************** */
 
 uvgrtp::crypto::hmac::sha1::sha1(const uint8_t *key, size_t key_size)
-#ifdef __RTP_CRYPTO__
-    :hmac_(key, key_size)
-#endif
 {
-#ifndef __RTP_CRYPTO__
-    (void)key, (void)key_size;
-#endif
+    if (backend::selected())
+        hmac_ = backend::selected()->hmac_sha1(key, key_size);
 }
 
 uvgrtp::crypto::hmac::sha1::~sha1()
@@ -21,53 +64,34 @@ uvgrtp::crypto::hmac::sha1::~sha1()
 
 void uvgrtp::crypto::hmac::sha1::update(const uint8_t *data, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    hmac_.Update(data, len);
-#else
-    (void)data, (void)len;
+    if (!hmac_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    hmac_->update(data, len);
 }
 
 void uvgrtp::crypto::hmac::sha1::final(uint8_t *digest)
 {
-#ifdef __RTP_CRYPTO__
-    hmac_.Final(digest);
-#else
-    (void)digest;
+    if (!hmac_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    hmac_->final(digest, hmac_->size());
 }
 
 void uvgrtp::crypto::hmac::sha1::final(uint8_t *digest, size_t size)
 {
-#ifdef __RTP_CRYPTO__
-    uint8_t d[20] = { 0 };
-
-    hmac_.Final(d);
-    memcpy(digest, d, size);
-#else
-    (void)digest, (void)size;
+    if (!hmac_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    hmac_->final(digest, size);
 }
 
 /* ***************** hmac-sha256 ***************** */
 
 uvgrtp::crypto::hmac::sha256::sha256(const uint8_t *key, size_t key_size)
-#ifdef __RTP_CRYPTO__
-    :hmac_(key, key_size)
-#endif
 {
-#ifndef __RTP_CRYPTO__
-    (void)key, (void)key_size;
-#endif
+    if (backend::selected())
+        hmac_ = backend::selected()->hmac_sha256(key, key_size);
 }
 
 uvgrtp::crypto::hmac::sha256::~sha256()
@@ -76,35 +100,26 @@ uvgrtp::crypto::hmac::sha256::~sha256()
 
 void uvgrtp::crypto::hmac::sha256::update(const uint8_t *data, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    hmac_.Update(data, len);
-#else
-    (void)data, (void)len;
+    if (!hmac_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    hmac_->update(data, len);
 }
 
 void uvgrtp::crypto::hmac::sha256::final(uint8_t *digest)
 {
-#ifdef __RTP_CRYPTO__
-    hmac_.Final(digest);
-#else
-    (void)digest;
+    if (!hmac_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    hmac_->final(digest, hmac_->size());
 }
 
 /* ***************** sha256 ***************** */
 
 uvgrtp::crypto::sha256::sha256()
-#ifdef __RTP_CRYPTO__
-    :sha_()
-#endif
 {
+    if (backend::selected())
+        sha_ = backend::selected()->sha256();
 }
 
 uvgrtp::crypto::sha256::~sha256()
@@ -113,78 +128,112 @@ uvgrtp::crypto::sha256::~sha256()
 
 void uvgrtp::crypto::sha256::update(const uint8_t *data, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    sha_.Update(data, len);
-#else
-    (void)data, (void)len;
+    if (!sha_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    sha_->update(data, len);
 }
 
 void uvgrtp::crypto::sha256::final(uint8_t *digest)
 {
-#ifdef __RTP_CRYPTO__
-    sha_.Final(digest);
-#else
-    (void)digest;
+    if (!sha_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    sha_->final(digest, sha_->size());
 }
 
 /* ***************** aes-128 ***************** */
 
 uvgrtp::crypto::aes::ctr::ctr(const uint8_t *key, size_t key_size, const uint8_t *iv)
-#ifdef __RTP_CRYPTO__
-    :enc_(key, key_size, iv),
-    dec_(key, key_size, iv)
-#endif
 {
-#ifndef __RTP_CRYPTO__
-    (void)key, (void)key_size, (void)iv;
-#endif
+    if (backend::selected())
+        cipher_ = backend::selected()->aes_ctr(key, key_size, iv);
 }
 
 uvgrtp::crypto::aes::ctr::~ctr()
 {
 }
 
+void uvgrtp::crypto::aes::ctr::set_iv(const uint8_t *iv)
+{
+    if (!cipher_)
+        crypto_missing();
+
+    cipher_->set_iv(iv);
+}
+
 void uvgrtp::crypto::aes::ctr::encrypt(uint8_t *output, const uint8_t *input, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    enc_.ProcessData(output, input, len);
-#else
-    (void)output, (void)input, (void)len;
+    if (!cipher_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    cipher_->encrypt(output, input, len);
 }
 
 void uvgrtp::crypto::aes::ctr::decrypt(uint8_t *output, const uint8_t *input, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    dec_.ProcessData(output, input, len);
-#else
-    (void)output, (void)input, (void)len;
+    if (!cipher_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    cipher_->decrypt(output, input, len);
+}
+
+uvgrtp::crypto::aes::gcm::gcm(const uint8_t *key, size_t key_size)
+{
+    if (backend::selected())
+        aead_ = backend::selected()->aes_gcm(key, key_size);
+}
+
+uvgrtp::crypto::aes::gcm::~gcm()
+{
+}
+
+void uvgrtp::crypto::aes::gcm::set_iv(const uint8_t *iv, size_t iv_len)
+{
+    if (!aead_)
+        crypto_missing();
+
+    aead_->set_iv(iv, iv_len);
+}
+
+void uvgrtp::crypto::aes::gcm::authenticate(const uint8_t *aad, size_t len)
+{
+    if (!aead_)
+        crypto_missing();
+
+    aead_->authenticate(aad, len);
+}
+
+void uvgrtp::crypto::aes::gcm::encrypt(uint8_t *output, const uint8_t *input, size_t len)
+{
+    if (!aead_)
+        crypto_missing();
+
+    aead_->encrypt(output, input, len);
+}
+
+void uvgrtp::crypto::aes::gcm::final(uint8_t *tag, size_t tag_len)
+{
+    if (!aead_)
+        crypto_missing();
+
+    aead_->final(tag, tag_len);
+}
+
+bool uvgrtp::crypto::aes::gcm::decrypt(uint8_t *output, const uint8_t *input, size_t len,
+    const uint8_t *iv, size_t iv_len, const uint8_t *aad, size_t aad_len,
+    const uint8_t *tag, size_t tag_len)
+{
+    if (!aead_)
+        crypto_missing();
+
+    return aead_->decrypt(output, input, len, iv, iv_len, aad, aad_len, tag, tag_len);
 }
 
 uvgrtp::crypto::aes::cfb::cfb(const uint8_t *key, size_t key_size, const uint8_t *iv)
-#ifdef __RTP_CRYPTO__
-    :enc_(key, key_size, iv),
-    dec_(key, key_size, iv)
-#endif
 {
-#ifndef __RTP_CRYPTO__
-    (void)key, (void)key_size, (void)iv;
-#endif
+    if (backend::selected())
+        cipher_ = backend::selected()->aes_cfb(key, key_size, iv);
 }
 
 uvgrtp::crypto::aes::cfb::~cfb()
@@ -193,37 +242,24 @@ uvgrtp::crypto::aes::cfb::~cfb()
 
 void uvgrtp::crypto::aes::cfb::encrypt(uint8_t *output, const uint8_t *input, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    enc_.ProcessData(output, input, len);
-#else
-    (void)output, (void)input, (void)len;
+    if (!cipher_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    cipher_->encrypt(output, input, len);
 }
 
 void uvgrtp::crypto::aes::cfb::decrypt(uint8_t *output, const uint8_t *input, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    dec_.ProcessData(output, input, len);
-#else
-    (void)output, (void)input, (void)len;
+    if (!cipher_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    cipher_->decrypt(output, input, len);
 }
 
 uvgrtp::crypto::aes::ecb::ecb(const uint8_t *key, size_t key_size)
-#ifdef __RTP_CRYPTO__
-    :enc_(key, key_size),
-    dec_(key, key_size)
-#endif
 {
-#ifndef __RTP_CRYPTO__
-    (void)key, (void)key_size;
-#endif
+    if (backend::selected())
+        cipher_ = backend::selected()->aes_ecb(key, key_size);
 }
 
 uvgrtp::crypto::aes::ecb::~ecb()
@@ -232,64 +268,25 @@ uvgrtp::crypto::aes::ecb::~ecb()
 
 void uvgrtp::crypto::aes::ecb::encrypt(uint8_t *output, const uint8_t *input, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    enc_.ProcessData(output, input, len);
-#else
-    (void)output, (void)input, (void)len;
+    if (!cipher_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    cipher_->encrypt(output, input, len);
 }
 
 void uvgrtp::crypto::aes::ecb::decrypt(uint8_t *output, const uint8_t *input, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    dec_.ProcessData(output, input, len);
-#else
-    (void)output, (void)input, (void)len;
+    if (!cipher_)
+        crypto_missing();
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    cipher_->decrypt(output, input, len);
 }
 
 /* ***************** diffie-hellman 3072 ***************** */
 
-uvgrtp::crypto::dh::dh()
-#ifdef __RTP_CRYPTO__
-    :prng_(),
-    dh_(),
-    rpk_()
-#endif
+uvgrtp::crypto::dh::dh():
+    dh_(get_backend().dh3072())
 {
-#ifdef __RTP_CRYPTO__
-    CryptoPP::Integer p(
-        "0xFFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD1"
-        "29024E088A67CC74020BBEA63B139B22514A08798E3404DD"
-        "EF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245"
-        "E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7ED"
-        "EE386BFB5A899FA5AE9F24117C4B1FE649286651ECE45B3D"
-        "C2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F"
-        "83655D23DCA3AD961C62F356208552BB9ED529077096966D"
-        "670C354E4ABC9804F1746C08CA18217C32905E462E36CE3B"
-        "E39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9"
-        "DE2BCBF6955817183995497CEA956AE515D2261898FA0510"
-        "15728E5A8AAAC42DAD33170D04507A33A85521ABDF1CBA64"
-        "ECFB850458DBEF0A8AEA71575D060C7DB3970F85A6E1E4C7"
-        "ABF5AE8CDB0933D71E8C94E04A25619DCEE3D2261AD2EE6B"
-        "F12FFA06D98A0864D87602733EC86A64521F2B18177B200C"
-        "BBE117577A615D6C770988C0BAD946E208E24FA074E5AB31"
-        "43DB5BFCE0FD108E4B82D120A93AD2CAFFFFFFFFFFFFFFFF"
-    );
-
-    CryptoPP::Integer g("0x02");
-
-    dh_.AccessGroupParameters().Initialize(p, g);
-#else
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
 }
 
 uvgrtp::crypto::dh::~dh()
@@ -298,81 +295,31 @@ uvgrtp::crypto::dh::~dh()
 
 void uvgrtp::crypto::dh::generate_keys()
 {
-#ifdef __RTP_CRYPTO__
-    CryptoPP::SecByteBlock t1(dh_.PrivateKeyLength()), t2(dh_.PublicKeyLength());
-    dh_.GenerateKeyPair(prng_, t1, t2);
-
-    sk_ = CryptoPP::Integer(t1, t1.size());
-    pk_ = CryptoPP::Integer(t2, t2.size());
-#else
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    dh_->generate_keys();
 }
 
 void uvgrtp::crypto::dh::get_pk(uint8_t *pk, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    pk_.Encode(pk, len);
-#else
-    (void)pk, (void)len;
-
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    dh_->get_pk(pk, len);
 }
 
 void uvgrtp::crypto::dh::set_remote_pk(uint8_t *pk, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    rpk_.Decode(pk, len);
-#else
-    (void)pk, (void)len;
-
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    dh_->set_remote_pk(pk, len);
 }
 
 void uvgrtp::crypto::dh::get_shared_secret(uint8_t *ss, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    CryptoPP::Integer p(
-        "0xFFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD1"
-        "29024E088A67CC74020BBEA63B139B22514A08798E3404DD"
-        "EF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245"
-        "E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7ED"
-        "EE386BFB5A899FA5AE9F24117C4B1FE649286651ECE45B3D"
-        "C2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F"
-        "83655D23DCA3AD961C62F356208552BB9ED529077096966D"
-        "670C354E4ABC9804F1746C08CA18217C32905E462E36CE3B"
-        "E39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9"
-        "DE2BCBF6955817183995497CEA956AE515D2261898FA0510"
-        "15728E5A8AAAC42DAD33170D04507A33A85521ABDF1CBA64"
-        "ECFB850458DBEF0A8AEA71575D060C7DB3970F85A6E1E4C7"
-        "ABF5AE8CDB0933D71E8C94E04A25619DCEE3D2261AD2EE6B"
-        "F12FFA06D98A0864D87602733EC86A64521F2B18177B200C"
-        "BBE117577A615D6C770988C0BAD946E208E24FA074E5AB31"
-        "43DB5BFCE0FD108E4B82D120A93AD2CAFFFFFFFFFFFFFFFF"
-    );
-
-    CryptoPP::ModularArithmetic ma(p);
-    CryptoPP::Integer dhres = ma.Exponentiate(rpk_, sk_);
-
-    dhres.Encode(ss, len);
-#else
-    (void)ss, (void)len;
-
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    dh_->get_shared_secret(ss, len);
 }
 
 /* ***************** base32 ***************** */
+
+/* The encoding does not depend on the backend. Same alphabet as the default one
+ * of the Crypto++ Base32Encoder, which leaves out L and O, without padding */
+static const char B32_ALPHABET[] = "ABCDEFGHIJKMNPQRSTUVWXYZ23456789";
+
 uvgrtp::crypto::b32::b32()
-#ifdef __RTP_CRYPTO__
-    :enc_()
-#endif
 {
 }
 
@@ -382,89 +329,83 @@ uvgrtp::crypto::b32::~b32()
 
 void uvgrtp::crypto::b32::encode(const uint8_t *input, uint8_t *output, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    enc_.Put(input, len);
-    enc_.MessageEnd();
+    /* "len" characters are written to "output", or fewer if the encoding is shorter */
+    uint32_t bits  = 0;
+    int bit_count  = 0;
+    size_t written = 0;
 
-    CryptoPP::word64 max_ret = enc_.MaxRetrievable();
+    for (size_t i = 0; i < len && written < len; ++i) {
+        bits = (bits << 8) | input[i];
+        bit_count += 8;
 
-    if (max_ret) {
-        enc_.Get(output, len);
+        while (bit_count >= 5 && written < len) {
+            bit_count -= 5;
+            output[written++] = B32_ALPHABET[(bits >> bit_count) & 0x1f];
+        }
     }
-#else
-    (void)input, (void)output, (void)len;
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    if (bit_count > 0 && written < len)
+        output[written++] = B32_ALPHABET[(bits << (5 - bit_count)) & 0x1f];
 }
 
 /* ***************** random ***************** */
 
 void uvgrtp::crypto::random::generate_random(uint8_t *out, size_t len)
 {
-#ifdef __RTP_CRYPTO__
     /* do not block ever */
-    CryptoPP::OS_GenerateRandomBlock(false, out, len);
-#else
-    (void)out, (void)len;
-
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    get_backend().random(out, len);
 }
 
 /* ***************** crc32 ***************** */
 
-void uvgrtp::crypto::crc32::get_crc32(const uint8_t *input, size_t len, uint32_t *output)
+/* CRC-32 of ZRTP messages does not depend on the backend. The table is for the reflected
+ * polynomial 0xedb88320 and the result is stored in little-endian byte order */
+static const uint32_t *crc32_table()
 {
-#ifdef __RTP_CRYPTO__
-    CryptoPP::CRC32 crc32;
+    static const struct crc_table {
+        uint32_t entries[256];
 
-    crc32.Update(input, len);
-    crc32.TruncatedFinal((uint8_t *)output, sizeof(uint32_t));
-#else
-    (void)input, (void)len, (void)output;
+        crc_table()
+        {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+
+                entries[i] = c;
+            }
+        }
+    } table;
+
+    return table.entries;
 }
 
 uint32_t uvgrtp::crypto::crc32::calculate_crc32(const uint8_t *input, size_t len)
 {
-#ifdef __RTP_CRYPTO__
-    CryptoPP::CRC32 crc32;
-    uint32_t out;
+    const uint32_t *table = crc32_table();
+    uint32_t crc = 0xffffffff;
+
+    for (size_t i = 0; i < len; ++i)
+        crc = table[(crc ^ input[i]) & 0xff] ^ (crc >> 8);
+
+    crc ^= 0xffffffff;
 
-    crc32.Update(input, len);
-    crc32.TruncatedFinal((uint8_t *)&out, sizeof(uint32_t));
+    uint8_t bytes[4] = { (uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24) };
+    uint32_t out;
 
+    memcpy(&out, bytes, sizeof(uint32_t));
     return out;
-#else
-    (void)input, (void)len;
+}
 
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+void uvgrtp::crypto::crc32::get_crc32(const uint8_t *input, size_t len, uint32_t *output)
+{
+    *output = calculate_crc32(input, len);
 }
 
 bool uvgrtp::crypto::crc32::verify_crc32(const uint8_t *input, size_t len, uint32_t old_crc)
 {
-#ifdef __RTP_CRYPTO__
-    CryptoPP::CRC32 crc32;
-    uint32_t new_crc;
-
-    crc32.Update(input, len);
-    crc32.TruncatedFinal((uint8_t *)&new_crc, sizeof(uint32_t));
-
-    return new_crc == old_crc;
-#else
-    (void)input, (void)len, (void)old_crc;
-
-    UVG_LOG_ERROR("Recompile uvgRTP with -D__RTP_CRYPTO__");
-    exit(EXIT_FAILURE);
-#endif
+    return calculate_crc32(input, len) == old_crc;
 }
 
 bool uvgrtp::crypto::enabled()
@@ -1,53 +1,42 @@
 #pragma once
 
+/* Crypto++ is detected from its headers. OpenSSL is used if it has been
+ * selected with UVGRTP_CRYPTO_BACKEND in CMake, which defines UVGRTP_HAVE_OPENSSL */
+#ifndef __RTP_NO_CRYPTO__
 #if __cplusplus >= 201703L || _MSC_VER >= 1911
 #if __has_include(<cryptopp/aes.h>) && \
-    __has_include(<cryptopp/base32.h>) && \
     __has_include(<cryptopp/cryptlib.h>) && \
     __has_include(<cryptopp/dh.h>) && \
+    __has_include(<cryptopp/gcm.h>) && \
     __has_include(<cryptopp/hmac.h>) && \
     __has_include(<cryptopp/modes.h>) && \
     __has_include(<cryptopp/osrng.h>) && \
-    __has_include(<cryptopp/sha.h>) && \
-    __has_include(<cryptopp/crc.h>) && \
-    !defined(__RTP_NO_CRYPTO__)
-
-#define __RTP_CRYPTO__
+    __has_include(<cryptopp/sha.h>)
 
-#include <cryptopp/aes.h>
-#include <cryptopp/base32.h>
-#include <cryptopp/cryptlib.h>
-#include <cryptopp/dh.h>
-#include <cryptopp/hmac.h>
-#include <cryptopp/modes.h>
-#include <cryptopp/osrng.h>
-#include <cryptopp/sha.h>
-#include <cryptopp/crc.h>
+#define UVGRTP_HAVE_CRYPTOPP
 
 #endif
-#else // __cplusplus < 201703L
-#ifndef __RTP_NO_CRYPTO__
-#define __RTP_CRYPTO__
-
-#include <cryptopp/aes.h>
-#include <cryptopp/base32.h>
-#include <cryptopp/cryptlib.h>
-#include <cryptopp/dh.h>
-#include <cryptopp/hmac.h>
-#include <cryptopp/modes.h>
-#include <cryptopp/osrng.h>
-#include <cryptopp/sha.h>
-#include <cryptopp/crc.h>
+#elif !defined(UVGRTP_HAVE_OPENSSL) // __cplusplus < 201703L
+#define UVGRTP_HAVE_CRYPTOPP
+#endif // __cplusplus
 
+#if defined(UVGRTP_HAVE_CRYPTOPP) || defined(UVGRTP_HAVE_OPENSSL)
+#define __RTP_CRYPTO__
 #endif
-#endif // __cplusplus
+#endif // __RTP_NO_CRYPTO__
+
+#include "crypto/backend.hh"
 
-#include <iostream>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 
 namespace uvgrtp {
 
     namespace crypto {
 
+        /* The classes below use the backend selected when uvgRTP was built, see crypto/backend.hh */
+
         /* hash-based message authentication code */
         namespace hmac {
             class sha1 {
@@ -55,16 +44,20 @@ namespace uvgrtp {
                     sha1(const uint8_t *key, size_t key_size);
                     ~sha1();
 
+                    sha1(sha1&&) = default;
+                    sha1& operator=(sha1&&) = default;
+
                     void update(const uint8_t *data, size_t len);
+
+                    /* final() resets the object for the next message. The padded key is kept,
+                     * so the same object can authenticate any number of messages */
                     void final(uint8_t *digest);
 
                     /* truncate digest to "size" bytes */
                     void final(uint8_t *digest, size_t size);
 
                 private:
-#ifdef __RTP_CRYPTO__
-                    CryptoPP::HMAC<CryptoPP::SHA1> hmac_;
-#endif
+                    std::unique_ptr<backend::digest> hmac_;
             };
 
             class sha256 {
@@ -72,13 +65,14 @@ namespace uvgrtp {
                     sha256(const uint8_t *key, size_t key_size);
                     ~sha256();
 
+                    sha256(sha256&&) = default;
+                    sha256& operator=(sha256&&) = default;
+
                     void update(const uint8_t *data, size_t len);
                     void final(uint8_t *digest);
 
                 private:
-#ifdef __RTP_CRYPTO__
-                    CryptoPP::HMAC<CryptoPP::SHA256> hmac_;
-#endif
+                    std::unique_ptr<backend::digest> hmac_;
             };
         }
 
@@ -91,9 +85,7 @@ namespace uvgrtp {
                 void final(uint8_t *digest);
 
             private:
-#ifdef __RTP_CRYPTO__
-                CryptoPP::SHA256 sha_;
-#endif
+                std::unique_ptr<backend::digest> sha_;
         };
 
         namespace aes {
@@ -107,10 +99,7 @@ namespace uvgrtp {
                     void decrypt(uint8_t *output, const uint8_t *input, size_t len);
 
                 private:
-#ifdef __RTP_CRYPTO__
-                    CryptoPP::ECB_Mode<CryptoPP::AES>::Encryption enc_;
-                    CryptoPP::ECB_Mode<CryptoPP::AES>::Decryption dec_;
-#endif
+                    std::unique_ptr<backend::cipher> cipher_;
             };
 
             class cfb {
@@ -122,10 +111,7 @@ namespace uvgrtp {
                     void decrypt(uint8_t *output, const uint8_t *input, size_t len);
 
                 private:
-#ifdef __RTP_CRYPTO__
-                    CryptoPP::CFB_Mode<CryptoPP::AES>::Encryption enc_;
-                    CryptoPP::CFB_Mode<CryptoPP::AES>::Decryption dec_;
-#endif
+                    std::unique_ptr<backend::cipher> cipher_;
             };
 
             class ctr {
@@ -133,14 +119,38 @@ namespace uvgrtp {
                     ctr(const uint8_t *key, size_t key_size, const uint8_t *iv);
                     ~ctr();
 
+                    /* Restart the keystream from "iv" without expanding the key again */
+                    void set_iv(const uint8_t *iv);
+
                     void encrypt(uint8_t *output, const uint8_t *input, size_t len);
                     void decrypt(uint8_t *output, const uint8_t *input, size_t len);
 
                 private:
-#ifdef __RTP_CRYPTO__
-                    CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption enc_;
-                    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec_;
-#endif
+                    std::unique_ptr<backend::cipher> cipher_;
+            };
+
+            /* Galois/Counter Mode, encrypts and authenticates in one pass */
+            class gcm {
+                public:
+                    gcm(const uint8_t *key, size_t key_size);
+                    ~gcm();
+
+                    /* A message is encrypted in steps since it may consist of several buffers:
+                     * set_iv(), authenticate() for the additional authenticated data,
+                     * encrypt() for each part of the message and final() for the tag */
+                    void set_iv(const uint8_t *iv, size_t iv_len);
+                    void authenticate(const uint8_t *aad, size_t len);
+                    void encrypt(uint8_t *output, const uint8_t *input, size_t len);
+                    void final(uint8_t *tag, size_t tag_len);
+
+                    /* Decrypt "len" bytes of "input" to "output" and verify "tag" over them and "aad".
+                     * Return false if the tag does not match, in which case "output" must be discarded */
+                    bool decrypt(uint8_t *output, const uint8_t *input, size_t len,
+                                 const uint8_t *iv, size_t iv_len, const uint8_t *aad, size_t aad_len,
+                                 const uint8_t *tag, size_t tag_len);
+
+                private:
+                    std::unique_ptr<backend::aead> aead_;
             };
         }
 
@@ -156,11 +166,7 @@ namespace uvgrtp {
                 void get_shared_secret(uint8_t *ss, size_t len);
 
             private:
-#ifdef __RTP_CRYPTO__
-                CryptoPP::AutoSeededRandomPool prng_;
-                CryptoPP::DH dh_;
-                CryptoPP::Integer sk_, pk_, rpk_;
-#endif
+                std::unique_ptr<backend::key_exchange> dh_;
         };
 
         /* base32 */
@@ -170,11 +176,6 @@ namespace uvgrtp {
                 ~b32();
 
                 void encode(const uint8_t *input, uint8_t *output, size_t len);
-
-            private:
-#ifdef __RTP_CRYPTO__
-                CryptoPP::Base32Encoder enc_;
-#endif
         };
 
         namespace random {
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace uvgrtp {
+
+    namespace crypto {
+
+        /* Libraries that implement the primitives of crypto.hh
+         *
+         * uvgRTP can be built with Crypto++, OpenSSL 3 or both. Each of them implements the interfaces
+         * below and the one selected with UVGRTP_CRYPTO_BACKEND in CMake is used by the classes of
+         * crypto.hh. The others can still be used directly, for example to compare their performance.
+         *
+         * The objects created by a backend are not thread-safe, but different objects may be used
+         * from different threads at the same time */
+        namespace backend {
+
+            /* Block cipher in a fixed mode of operation with the key expanded once */
+            class cipher {
+                public:
+                    virtual ~cipher() {}
+
+                    /* Restart the mode from "iv" without expanding the key again.
+                     * Only used with the modes that have an IV */
+                    virtual void set_iv(const uint8_t *iv) = 0;
+
+                    virtual void encrypt(uint8_t *output, const uint8_t *input, size_t len) = 0;
+                    virtual void decrypt(uint8_t *output, const uint8_t *input, size_t len) = 0;
+            };
+
+            /* Authenticated encryption with associated data, see crypto::aes::gcm */
+            class aead {
+                public:
+                    virtual ~aead() {}
+
+                    virtual void set_iv(const uint8_t *iv, size_t iv_len) = 0;
+                    virtual void authenticate(const uint8_t *aad, size_t len) = 0;
+                    virtual void encrypt(uint8_t *output, const uint8_t *input, size_t len) = 0;
+                    virtual void final(uint8_t *tag, size_t tag_len) = 0;
+
+                    virtual bool decrypt(uint8_t *output, const uint8_t *input, size_t len,
+                                         const uint8_t *iv, size_t iv_len, const uint8_t *aad, size_t aad_len,
+                                         const uint8_t *tag, size_t tag_len) = 0;
+            };
+
+            /* Hash function or keyed message authentication code.
+             * final() resets the object for the next message, keeping the key */
+            class digest {
+                public:
+                    virtual ~digest() {}
+
+                    virtual void update(const uint8_t *data, size_t len) = 0;
+
+                    /* Write the first "len" bytes of the digest to "out", at most size() bytes */
+                    virtual void final(uint8_t *out, size_t len) = 0;
+
+                    virtual size_t size() const = 0;
+            };
+
+            /* Finite field Diffie-Hellman in the 3072-bit MODP group of RFC 3526 */
+            class key_exchange {
+                public:
+                    virtual ~key_exchange() {}
+
+                    virtual void generate_keys() = 0;
+
+                    /* The keys and the shared secret are big-endian numbers padded to "len" bytes */
+                    virtual void get_pk(uint8_t *pk, size_t len) = 0;
+                    virtual void set_remote_pk(const uint8_t *pk, size_t len) = 0;
+                    virtual void get_shared_secret(uint8_t *ss, size_t len) = 0;
+            };
+
+            class library {
+                public:
+                    virtual ~library() {}
+
+                    virtual const char *name() const = 0;
+
+                    /* "key_size" is 16, 24 or 32 bytes and the IV of CFB and CTR is 16 bytes */
+                    virtual std::unique_ptr<cipher> aes_ecb(const uint8_t *key, size_t key_size) = 0;
+                    virtual std::unique_ptr<cipher> aes_cfb(const uint8_t *key, size_t key_size, const uint8_t *iv) = 0;
+                    virtual std::unique_ptr<cipher> aes_ctr(const uint8_t *key, size_t key_size, const uint8_t *iv) = 0;
+                    virtual std::unique_ptr<aead>   aes_gcm(const uint8_t *key, size_t key_size) = 0;
+
+                    virtual std::unique_ptr<digest> hmac_sha1(const uint8_t *key, size_t key_size) = 0;
+                    virtual std::unique_ptr<digest> hmac_sha256(const uint8_t *key, size_t key_size) = 0;
+                    virtual std::unique_ptr<digest> sha256() = 0;
+
+                    virtual std::unique_ptr<key_exchange> dh3072() = 0;
+
+                    /* Fill "out" with "len" bytes from a cryptographically secure generator without blocking */
+                    virtual void random(uint8_t *out, size_t len) = 0;
+            };
+
+            /* Return the backend selected when uvgRTP was built, nullptr if uvgRTP was built without crypto */
+            library *selected();
+
+            /* Return the backends uvgRTP was built with, the selected one first */
+            std::vector<library *> available();
+
+            /* Return the backend if uvgRTP was built with it, nullptr otherwise */
+            library *cryptopp();
+            library *openssl();
+        }
+    }
+}
+
+namespace uvg_rtp = uvgrtp;
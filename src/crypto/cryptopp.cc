@@ -0,0 +1,274 @@
+#include "../crypto.hh"
+
+#ifdef UVGRTP_HAVE_CRYPTOPP
+
+#include <cryptopp/aes.h>
+#include <cryptopp/cryptlib.h>
+#include <cryptopp/dh.h>
+#include <cryptopp/gcm.h>
+#include <cryptopp/hmac.h>
+#include <cryptopp/modes.h>
+#include <cryptopp/osrng.h>
+#include <cryptopp/sha.h>
+
+#include <cstring>
+
+namespace {
+
+    using namespace uvgrtp::crypto::backend;
+
+    const char *MODP_3072_PRIME =
+        "0xFFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD1"
+        "29024E088A67CC74020BBEA63B139B22514A08798E3404DD"
+        "EF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245"
+        "E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7ED"
+        "EE386BFB5A899FA5AE9F24117C4B1FE649286651ECE45B3D"
+        "C2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F"
+        "83655D23DCA3AD961C62F356208552BB9ED529077096966D"
+        "670C354E4ABC9804F1746C08CA18217C32905E462E36CE3B"
+        "E39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9"
+        "DE2BCBF6955817183995497CEA956AE515D2261898FA0510"
+        "15728E5A8AAAC42DAD33170D04507A33A85521ABDF1CBA64"
+        "ECFB850458DBEF0A8AEA71575D060C7DB3970F85A6E1E4C7"
+        "ABF5AE8CDB0933D71E8C94E04A25619DCEE3D2261AD2EE6B"
+        "F12FFA06D98A0864D87602733EC86A64521F2B18177B200C"
+        "BBE117577A615D6C770988C0BAD946E208E24FA074E5AB31"
+        "43DB5BFCE0FD108E4B82D120A93AD2CAFFFFFFFFFFFFFFFF";
+
+    /* ECB and CFB keep separate objects for each direction since their state differs */
+    template <typename Enc, typename Dec>
+    class cryptopp_cipher : public cipher {
+        public:
+            cryptopp_cipher(const uint8_t *key, size_t key_size):
+                enc_(key, key_size),
+                dec_(key, key_size)
+            {
+            }
+
+            cryptopp_cipher(const uint8_t *key, size_t key_size, const uint8_t *iv):
+                enc_(key, key_size, iv),
+                dec_(key, key_size, iv)
+            {
+            }
+
+            void set_iv(const uint8_t *iv)
+            {
+                enc_.Resynchronize(iv);
+                dec_.Resynchronize(iv);
+            }
+
+            void encrypt(uint8_t *output, const uint8_t *input, size_t len)
+            {
+                enc_.ProcessData(output, input, len);
+            }
+
+            void decrypt(uint8_t *output, const uint8_t *input, size_t len)
+            {
+                dec_.ProcessData(output, input, len);
+            }
+
+        private:
+            Enc enc_;
+            Dec dec_;
+    };
+
+    class cryptopp_gcm : public aead {
+        public:
+            cryptopp_gcm(const uint8_t *key, size_t key_size):
+                enc_(),
+                dec_()
+            {
+                enc_.SetKey(key, key_size);
+                dec_.SetKey(key, key_size);
+            }
+
+            void set_iv(const uint8_t *iv, size_t iv_len)
+            {
+                enc_.Resynchronize(iv, (int)iv_len);
+            }
+
+            void authenticate(const uint8_t *aad, size_t len)
+            {
+                enc_.Update(aad, len);
+            }
+
+            void encrypt(uint8_t *output, const uint8_t *input, size_t len)
+            {
+                enc_.ProcessData(output, input, len);
+            }
+
+            void final(uint8_t *tag, size_t tag_len)
+            {
+                enc_.TruncatedFinal(tag, tag_len);
+            }
+
+            bool decrypt(uint8_t *output, const uint8_t *input, size_t len,
+                         const uint8_t *iv, size_t iv_len, const uint8_t *aad, size_t aad_len,
+                         const uint8_t *tag, size_t tag_len)
+            {
+                return dec_.DecryptAndVerify(output, tag, tag_len, iv, (int)iv_len, aad, aad_len, input, len);
+            }
+
+        private:
+            CryptoPP::GCM<CryptoPP::AES>::Encryption enc_;
+            CryptoPP::GCM<CryptoPP::AES>::Decryption dec_;
+    };
+
+    /* HashTransformation::Final() restarts the hash, and HMAC keeps its padded key */
+    template <typename T>
+    class cryptopp_digest : public digest {
+        public:
+            cryptopp_digest():
+                hash_()
+            {
+            }
+
+            cryptopp_digest(const uint8_t *key, size_t key_size):
+                hash_(key, key_size)
+            {
+            }
+
+            void update(const uint8_t *data, size_t len)
+            {
+                hash_.Update(data, len);
+            }
+
+            void final(uint8_t *out, size_t len)
+            {
+                hash_.TruncatedFinal(out, len);
+            }
+
+            size_t size() const
+            {
+                return T::DIGESTSIZE;
+            }
+
+        private:
+            T hash_;
+    };
+
+    class cryptopp_dh : public key_exchange {
+        public:
+            cryptopp_dh():
+                prng_(),
+                dh_(),
+                p_(MODP_3072_PRIME),
+                sk_(),
+                pk_(),
+                rpk_()
+            {
+                dh_.AccessGroupParameters().Initialize(p_, CryptoPP::Integer("0x02"));
+            }
+
+            void generate_keys()
+            {
+                CryptoPP::SecByteBlock t1(dh_.PrivateKeyLength()), t2(dh_.PublicKeyLength());
+                dh_.GenerateKeyPair(prng_, t1, t2);
+
+                sk_ = CryptoPP::Integer(t1, t1.size());
+                pk_ = CryptoPP::Integer(t2, t2.size());
+            }
+
+            void get_pk(uint8_t *pk, size_t len)
+            {
+                pk_.Encode(pk, len);
+            }
+
+            void set_remote_pk(const uint8_t *pk, size_t len)
+            {
+                rpk_.Decode(pk, len);
+            }
+
+            void get_shared_secret(uint8_t *ss, size_t len)
+            {
+                CryptoPP::ModularArithmetic ma(p_);
+                CryptoPP::Integer dhres = ma.Exponentiate(rpk_, sk_);
+
+                dhres.Encode(ss, len);
+            }
+
+        private:
+            CryptoPP::AutoSeededRandomPool prng_;
+            CryptoPP::DH dh_;
+            CryptoPP::Integer p_;
+            CryptoPP::Integer sk_;
+            CryptoPP::Integer pk_;
+            CryptoPP::Integer rpk_;
+    };
+
+    class cryptopp_library : public library {
+        public:
+            const char *name() const
+            {
+                return "Crypto++";
+            }
+
+            std::unique_ptr<cipher> aes_ecb(const uint8_t *key, size_t key_size)
+            {
+                return std::unique_ptr<cipher>(new cryptopp_cipher<
+                    CryptoPP::ECB_Mode<CryptoPP::AES>::Encryption,
+                    CryptoPP::ECB_Mode<CryptoPP::AES>::Decryption>(key, key_size));
+            }
+
+            std::unique_ptr<cipher> aes_cfb(const uint8_t *key, size_t key_size, const uint8_t *iv)
+            {
+                return std::unique_ptr<cipher>(new cryptopp_cipher<
+                    CryptoPP::CFB_Mode<CryptoPP::AES>::Encryption,
+                    CryptoPP::CFB_Mode<CryptoPP::AES>::Decryption>(key, key_size, iv));
+            }
+
+            std::unique_ptr<cipher> aes_ctr(const uint8_t *key, size_t key_size, const uint8_t *iv)
+            {
+                return std::unique_ptr<cipher>(new cryptopp_cipher<
+                    CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption,
+                    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption>(key, key_size, iv));
+            }
+
+            std::unique_ptr<aead> aes_gcm(const uint8_t *key, size_t key_size)
+            {
+                return std::unique_ptr<aead>(new cryptopp_gcm(key, key_size));
+            }
+
+            std::unique_ptr<digest> hmac_sha1(const uint8_t *key, size_t key_size)
+            {
+                return std::unique_ptr<digest>(
+                    new cryptopp_digest<CryptoPP::HMAC<CryptoPP::SHA1>>(key, key_size));
+            }
+
+            std::unique_ptr<digest> hmac_sha256(const uint8_t *key, size_t key_size)
+            {
+                return std::unique_ptr<digest>(
+                    new cryptopp_digest<CryptoPP::HMAC<CryptoPP::SHA256>>(key, key_size));
+            }
+
+            std::unique_ptr<digest> sha256()
+            {
+                return std::unique_ptr<digest>(new cryptopp_digest<CryptoPP::SHA256>());
+            }
+
+            std::unique_ptr<key_exchange> dh3072()
+            {
+                return std::unique_ptr<key_exchange>(new cryptopp_dh());
+            }
+
+            void random(uint8_t *out, size_t len)
+            {
+                CryptoPP::OS_GenerateRandomBlock(false, out, len);
+            }
+    };
+}
+
+uvgrtp::crypto::backend::library *uvgrtp::crypto::backend::cryptopp()
+{
+    static cryptopp_library lib;
+    return &lib;
+}
+
+#else
+
+uvgrtp::crypto::backend::library *uvgrtp::crypto::backend::cryptopp()
+{
+    return nullptr;
+}
+
+#endif // UVGRTP_HAVE_CRYPTOPP
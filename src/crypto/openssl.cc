@@ -0,0 +1,478 @@
+#include "../crypto.hh"
+
+#ifdef UVGRTP_HAVE_OPENSSL
+
+#include "../debug.hh"
+
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include <cstring>
+
+namespace {
+
+    using namespace uvgrtp::crypto::backend;
+
+    enum AES_MODE {
+        AES_ECB = 0,
+        AES_CFB = 1,
+        AES_CTR = 2,
+        AES_GCM = 3,
+        AES_MODES
+    };
+
+    /* Ciphers and digests are fetched from the default provider once when the backend is first used,
+     * so that creating a context does not have to look them up again */
+    class openssl_algorithms {
+        public:
+            openssl_algorithms():
+                ciphers_(),
+                sha256_(EVP_MD_fetch(nullptr, "SHA256", nullptr)),
+                hmac_(EVP_MAC_fetch(nullptr, "HMAC", nullptr))
+            {
+                const char *names[AES_MODES][3] = {
+                    { "AES-128-ECB", "AES-192-ECB", "AES-256-ECB" },
+                    { "AES-128-CFB", "AES-192-CFB", "AES-256-CFB" },
+                    { "AES-128-CTR", "AES-192-CTR", "AES-256-CTR" },
+                    { "AES-128-GCM", "AES-192-GCM", "AES-256-GCM" },
+                };
+
+                for (int mode = 0; mode < AES_MODES; ++mode) {
+                    for (int i = 0; i < 3; ++i)
+                        ciphers_[mode][i] = EVP_CIPHER_fetch(nullptr, names[mode][i], nullptr);
+                }
+            }
+
+            ~openssl_algorithms()
+            {
+                for (int mode = 0; mode < AES_MODES; ++mode) {
+                    for (int i = 0; i < 3; ++i)
+                        EVP_CIPHER_free(ciphers_[mode][i]);
+                }
+
+                EVP_MD_free(sha256_);
+                EVP_MAC_free(hmac_);
+            }
+
+            const EVP_CIPHER *aes(AES_MODE mode, size_t key_size) const
+            {
+                switch (key_size) {
+                    case 16: return ciphers_[mode][0];
+                    case 24: return ciphers_[mode][1];
+                    case 32: return ciphers_[mode][2];
+                }
+
+                UVG_LOG_ERROR("Invalid AES key size: %zu", key_size);
+                return nullptr;
+            }
+
+            EVP_CIPHER *ciphers_[AES_MODES][3];
+            EVP_MD *sha256_;
+            EVP_MAC *hmac_;
+    };
+
+    void log_failure(const char *what)
+    {
+        UVG_LOG_ERROR("OpenSSL: %s failed", what);
+    }
+
+    /* ECB and CFB keep separate contexts for each direction since their state differs.
+     * In CTR mode the IV is applied lazily, when the context is next used in that direction,
+     * so that a packet protected with set_iv() + encrypt() restarts only one context */
+    class openssl_cipher : public cipher {
+        public:
+            openssl_cipher(const EVP_CIPHER *type, const uint8_t *key, const uint8_t *iv):
+                enc_(EVP_CIPHER_CTX_new()),
+                dec_(EVP_CIPHER_CTX_new()),
+                iv_(),
+                enc_iv_pending_(false),
+                dec_iv_pending_(false)
+            {
+                if (!type || !enc_ || !dec_ ||
+                    !EVP_EncryptInit_ex(enc_, type, nullptr, key, iv) ||
+                    !EVP_DecryptInit_ex(dec_, type, nullptr, key, iv)) {
+                    log_failure("Cipher initialization");
+                    return;
+                }
+
+                /* ECB is used for single blocks only */
+                EVP_CIPHER_CTX_set_padding(enc_, 0);
+                EVP_CIPHER_CTX_set_padding(dec_, 0);
+            }
+
+            ~openssl_cipher()
+            {
+                EVP_CIPHER_CTX_free(enc_);
+                EVP_CIPHER_CTX_free(dec_);
+            }
+
+            void set_iv(const uint8_t *iv)
+            {
+                memcpy(iv_, iv, sizeof(iv_));
+                enc_iv_pending_ = dec_iv_pending_ = true;
+            }
+
+            void encrypt(uint8_t *output, const uint8_t *input, size_t len)
+            {
+                if (enc_iv_pending_) {
+                    EVP_EncryptInit_ex(enc_, nullptr, nullptr, nullptr, iv_);
+                    enc_iv_pending_ = false;
+                }
+
+                int out_len = 0;
+
+                if (!EVP_EncryptUpdate(enc_, output, &out_len, input, (int)len))
+                    log_failure("Encryption");
+            }
+
+            void decrypt(uint8_t *output, const uint8_t *input, size_t len)
+            {
+                if (dec_iv_pending_) {
+                    EVP_DecryptInit_ex(dec_, nullptr, nullptr, nullptr, iv_);
+                    dec_iv_pending_ = false;
+                }
+
+                int out_len = 0;
+
+                if (!EVP_DecryptUpdate(dec_, output, &out_len, input, (int)len))
+                    log_failure("Decryption");
+            }
+
+        private:
+            EVP_CIPHER_CTX *enc_;
+            EVP_CIPHER_CTX *dec_;
+
+            uint8_t iv_[16];
+            bool enc_iv_pending_;
+            bool dec_iv_pending_;
+    };
+
+    class openssl_gcm : public aead {
+        public:
+            openssl_gcm(const EVP_CIPHER *type, const uint8_t *key):
+                enc_(EVP_CIPHER_CTX_new()),
+                dec_(EVP_CIPHER_CTX_new())
+            {
+                if (!type || !enc_ || !dec_ ||
+                    !EVP_EncryptInit_ex(enc_, type, nullptr, key, nullptr) ||
+                    !EVP_DecryptInit_ex(dec_, type, nullptr, key, nullptr)) {
+                    log_failure("AES-GCM initialization");
+                }
+            }
+
+            ~openssl_gcm()
+            {
+                EVP_CIPHER_CTX_free(enc_);
+                EVP_CIPHER_CTX_free(dec_);
+            }
+
+            void set_iv(const uint8_t *iv, size_t iv_len)
+            {
+                if (!EVP_CIPHER_CTX_ctrl(enc_, EVP_CTRL_GCM_SET_IVLEN, (int)iv_len, nullptr) ||
+                    !EVP_EncryptInit_ex(enc_, nullptr, nullptr, nullptr, iv)) {
+                    log_failure("AES-GCM IV setup");
+                }
+            }
+
+            void authenticate(const uint8_t *aad, size_t len)
+            {
+                int out_len = 0;
+
+                if (!EVP_EncryptUpdate(enc_, nullptr, &out_len, aad, (int)len))
+                    log_failure("AES-GCM authentication");
+            }
+
+            void encrypt(uint8_t *output, const uint8_t *input, size_t len)
+            {
+                int out_len = 0;
+
+                if (!EVP_EncryptUpdate(enc_, output, &out_len, input, (int)len))
+                    log_failure("AES-GCM encryption");
+            }
+
+            void final(uint8_t *tag, size_t tag_len)
+            {
+                uint8_t unused[16];
+                int out_len = 0;
+
+                if (!EVP_EncryptFinal_ex(enc_, unused, &out_len) ||
+                    !EVP_CIPHER_CTX_ctrl(enc_, EVP_CTRL_GCM_GET_TAG, (int)tag_len, tag)) {
+                    log_failure("AES-GCM tag generation");
+                }
+            }
+
+            bool decrypt(uint8_t *output, const uint8_t *input, size_t len,
+                         const uint8_t *iv, size_t iv_len, const uint8_t *aad, size_t aad_len,
+                         const uint8_t *tag, size_t tag_len)
+            {
+                uint8_t unused[16];
+                int out_len = 0;
+
+                if (!EVP_CIPHER_CTX_ctrl(dec_, EVP_CTRL_GCM_SET_IVLEN, (int)iv_len, nullptr) ||
+                    !EVP_DecryptInit_ex(dec_, nullptr, nullptr, nullptr, iv))
+                    return false;
+
+                if (aad_len && !EVP_DecryptUpdate(dec_, nullptr, &out_len, aad, (int)aad_len))
+                    return false;
+
+                if (len && !EVP_DecryptUpdate(dec_, output, &out_len, input, (int)len))
+                    return false;
+
+                if (!EVP_CIPHER_CTX_ctrl(dec_, EVP_CTRL_GCM_SET_TAG, (int)tag_len, (void *)tag))
+                    return false;
+
+                return EVP_DecryptFinal_ex(dec_, unused, &out_len) > 0;
+            }
+
+        private:
+            EVP_CIPHER_CTX *enc_;
+            EVP_CIPHER_CTX *dec_;
+    };
+
+    /* Initializing the context again without a key restarts HMAC with the key it already has */
+    class openssl_hmac : public digest {
+        public:
+            openssl_hmac(EVP_MAC *mac, const char *md, size_t md_size, const uint8_t *key, size_t key_size):
+                ctx_(EVP_MAC_CTX_new(mac)),
+                size_(md_size)
+            {
+                OSSL_PARAM params[] = {
+                    OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char *)md, 0),
+                    OSSL_PARAM_construct_end()
+                };
+
+                if (!ctx_ || !EVP_MAC_init(ctx_, key, key_size, params))
+                    log_failure("HMAC initialization");
+            }
+
+            ~openssl_hmac()
+            {
+                EVP_MAC_CTX_free(ctx_);
+            }
+
+            void update(const uint8_t *data, size_t len)
+            {
+                EVP_MAC_update(ctx_, data, len);
+            }
+
+            void final(uint8_t *out, size_t len)
+            {
+                uint8_t mac[EVP_MAX_MD_SIZE];
+                size_t mac_len = 0;
+
+                if (!EVP_MAC_final(ctx_, mac, &mac_len, sizeof(mac))) {
+                    log_failure("HMAC");
+                    return;
+                }
+
+                memcpy(out, mac, len < mac_len ? len : mac_len);
+                EVP_MAC_init(ctx_, nullptr, 0, nullptr);
+            }
+
+            size_t size() const
+            {
+                return size_;
+            }
+
+        private:
+            EVP_MAC_CTX *ctx_;
+            size_t size_;
+    };
+
+    class openssl_hash : public digest {
+        public:
+            openssl_hash(const EVP_MD *md):
+                ctx_(EVP_MD_CTX_new()),
+                md_(md)
+            {
+                if (!md_ || !ctx_ || !EVP_DigestInit_ex(ctx_, md_, nullptr))
+                    log_failure("Hash initialization");
+            }
+
+            ~openssl_hash()
+            {
+                EVP_MD_CTX_free(ctx_);
+            }
+
+            void update(const uint8_t *data, size_t len)
+            {
+                EVP_DigestUpdate(ctx_, data, len);
+            }
+
+            void final(uint8_t *out, size_t len)
+            {
+                uint8_t hash[EVP_MAX_MD_SIZE];
+                unsigned int hash_len = 0;
+
+                if (!EVP_DigestFinal_ex(ctx_, hash, &hash_len)) {
+                    log_failure("Hash");
+                    return;
+                }
+
+                memcpy(out, hash, len < hash_len ? len : hash_len);
+                EVP_DigestInit_ex(ctx_, md_, nullptr);
+            }
+
+            size_t size() const
+            {
+                return (size_t)EVP_MD_get_size(md_);
+            }
+
+        private:
+            EVP_MD_CTX *ctx_;
+            const EVP_MD *md_;
+    };
+
+    /* The private key is chosen from [1, (p - 1) / 2) like Crypto++ does for a safe prime */
+    class openssl_dh : public key_exchange {
+        public:
+            openssl_dh():
+                ctx_(BN_CTX_new()),
+                p_(BN_get_rfc3526_prime_3072(nullptr)),
+                q_(BN_new()),
+                g_(BN_new()),
+                sk_(BN_secure_new()),
+                pk_(BN_new()),
+                rpk_(BN_new()),
+                mont_(BN_MONT_CTX_new())
+            {
+                if (!ctx_ || !p_ || !q_ || !g_ || !sk_ || !pk_ || !rpk_ || !mont_ ||
+                    !BN_rshift1(q_, p_) ||
+                    !BN_set_word(g_, 2) ||
+                    !BN_MONT_CTX_set(mont_, p_, ctx_)) {
+                    log_failure("Diffie-Hellman initialization");
+                }
+            }
+
+            ~openssl_dh()
+            {
+                BN_MONT_CTX_free(mont_);
+                BN_free(rpk_);
+                BN_free(pk_);
+                BN_clear_free(sk_);
+                BN_free(g_);
+                BN_free(q_);
+                BN_free(p_);
+                BN_CTX_free(ctx_);
+            }
+
+            void generate_keys()
+            {
+                do {
+                    if (!BN_priv_rand_range(sk_, q_)) {
+                        log_failure("Diffie-Hellman key generation");
+                        return;
+                    }
+                } while (BN_is_zero(sk_));
+
+                if (!BN_mod_exp_mont_consttime(pk_, g_, sk_, p_, ctx_, mont_))
+                    log_failure("Diffie-Hellman key generation");
+            }
+
+            void get_pk(uint8_t *pk, size_t len)
+            {
+                BN_bn2binpad(pk_, pk, (int)len);
+            }
+
+            void set_remote_pk(const uint8_t *pk, size_t len)
+            {
+                BN_bin2bn(pk, (int)len, rpk_);
+            }
+
+            void get_shared_secret(uint8_t *ss, size_t len)
+            {
+                BIGNUM *dhres = BN_secure_new();
+
+                if (!dhres || !BN_mod_exp_mont_consttime(dhres, rpk_, sk_, p_, ctx_, mont_))
+                    log_failure("Diffie-Hellman key agreement");
+                else
+                    BN_bn2binpad(dhres, ss, (int)len);
+
+                BN_clear_free(dhres);
+            }
+
+        private:
+            BN_CTX *ctx_;
+            BIGNUM *p_;
+            BIGNUM *q_;
+            BIGNUM *g_;
+            BIGNUM *sk_;
+            BIGNUM *pk_;
+            BIGNUM *rpk_;
+            BN_MONT_CTX *mont_;
+    };
+
+    class openssl_library : public library {
+        public:
+            const char *name() const
+            {
+                return "OpenSSL";
+            }
+
+            std::unique_ptr<cipher> aes_ecb(const uint8_t *key, size_t key_size)
+            {
+                return std::unique_ptr<cipher>(new openssl_cipher(algs_.aes(AES_ECB, key_size), key, nullptr));
+            }
+
+            std::unique_ptr<cipher> aes_cfb(const uint8_t *key, size_t key_size, const uint8_t *iv)
+            {
+                return std::unique_ptr<cipher>(new openssl_cipher(algs_.aes(AES_CFB, key_size), key, iv));
+            }
+
+            std::unique_ptr<cipher> aes_ctr(const uint8_t *key, size_t key_size, const uint8_t *iv)
+            {
+                return std::unique_ptr<cipher>(new openssl_cipher(algs_.aes(AES_CTR, key_size), key, iv));
+            }
+
+            std::unique_ptr<aead> aes_gcm(const uint8_t *key, size_t key_size)
+            {
+                return std::unique_ptr<aead>(new openssl_gcm(algs_.aes(AES_GCM, key_size), key));
+            }
+
+            std::unique_ptr<digest> hmac_sha1(const uint8_t *key, size_t key_size)
+            {
+                return std::unique_ptr<digest>(new openssl_hmac(algs_.hmac_, "SHA1", 20, key, key_size));
+            }
+
+            std::unique_ptr<digest> hmac_sha256(const uint8_t *key, size_t key_size)
+            {
+                return std::unique_ptr<digest>(new openssl_hmac(algs_.hmac_, "SHA256", 32, key, key_size));
+            }
+
+            std::unique_ptr<digest> sha256()
+            {
+                return std::unique_ptr<digest>(new openssl_hash(algs_.sha256_));
+            }
+
+            std::unique_ptr<key_exchange> dh3072()
+            {
+                return std::unique_ptr<key_exchange>(new openssl_dh());
+            }
+
+            void random(uint8_t *out, size_t len)
+            {
+                if (RAND_bytes(out, (int)len) != 1)
+                    log_failure("Random number generation");
+            }
+
+        private:
+            openssl_algorithms algs_;
+    };
+}
+
+uvgrtp::crypto::backend::library *uvgrtp::crypto::backend::openssl()
+{
+    static openssl_library lib;
+    return &lib;
+}
+
+#else
+
+uvgrtp::crypto::backend::library *uvgrtp::crypto::backend::openssl()
+{
+    return nullptr;
+}
+
+#endif // UVGRTP_HAVE_OPENSSL
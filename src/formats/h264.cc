@@ -2,6 +2,8 @@
 
 #include "../frame_queue.hh"
 #include "../rtp.hh"
+#include "../rx_buffer.hh"
+#include "../pool.hh"
 
 #include "debug.hh"
 
@@ -40,11 +42,6 @@ uint8_t uvgrtp::formats::h264::get_fu_header_size() const
     return HEADER_SIZE_H264_FU;
 }
 
-uint8_t uvgrtp::formats::h264::get_start_code_range() const
-{
-    return 1; // H264 can have three byte start codes and therefore we must scan one byte at a time
-}
-
 uvgrtp::formats::FRAG_TYPE uvgrtp::formats::h264::get_fragment_type(uvgrtp::frame::rtp_frame* frame) const
 {
     bool first_frag = frame->payload[1] & 0x80;
@@ -148,6 +145,9 @@ rtp_error_t uvgrtp::formats::h264::fu_division(uint8_t* data, size_t data_len, s
     initialize_fu_headers(get_nal_type(data), headers->fu_headers);
 
     uvgrtp::buf_vec* buffers = fqueue_->get_buffer_vector();
+
+    // the buffers of a previous fragmented NAL unit of the frame are not used anymore
+    buffers->clear();
     buffers->push_back(std::make_pair(sizeof(headers->fu_indicator), headers->fu_indicator));
     buffers->push_back(std::make_pair(sizeof(uint8_t), &headers->fu_headers[0]));
     buffers->push_back(std::make_pair(payload_size, nullptr));
@@ -171,7 +171,7 @@ uvgrtp::frame::rtp_frame* uvgrtp::formats::h264::allocate_rtp_frame_with_startco
         complete->payload_len += 3;
     }
 
-    complete->payload = new uint8_t[complete->payload_len];
+    uvgrtp::frame::alloc_payload(complete, complete->payload_len);
 
     if (add_start_code && complete->payload_len >= 3) {
         complete->payload[0] = 0;
@@ -188,16 +188,19 @@ uvgrtp::frame::rtp_frame* uvgrtp::formats::h264::allocate_rtp_frame_with_startco
 void uvgrtp::formats::h264::prepend_start_code(int rce_flags, uvgrtp::frame::rtp_frame** out)
 {
     if (!(rce_flags & RCE_NO_H26X_PREPEND_SC)) {
-        uint8_t* pl = new uint8_t[(*out)->payload_len + 3];
+        if (prepend_start_code_in_place(*out, 3))
+            return;
+
+        uvgrtp::frame::detach_rx_buffer(*out);
+
+        if (prepend_start_code_in_place(*out, 3))
+            return;
+
+        uint8_t* pl = uvgrtp::frame::move_payload(*out, (*out)->payload_len + 3, 3);
 
         pl[0] = 0;
         pl[1] = 0;
         pl[2] = 1;
-
-        std::memcpy(pl + 3, (*out)->payload, (*out)->payload_len);
-        delete[](*out)->payload;
-
-        (*out)->payload = pl;
         (*out)->payload_len += 3;
     }
 }
@@ -43,11 +43,6 @@ uint8_t uvgrtp::formats::h265::get_fu_header_size() const
     return HEADER_SIZE_H265_FU;
 }
 
-uint8_t uvgrtp::formats::h265::get_start_code_range() const
-{
-    return 4;
-}
-
 uvgrtp::formats::NAL_TYPE uvgrtp::formats::h265::get_nal_type(uvgrtp::frame::rtp_frame* frame) const
 {
     // see https://datatracker.ietf.org/doc/html/rfc7798#section-4.4.3
@@ -173,6 +168,9 @@ rtp_error_t uvgrtp::formats::h265::fu_division(uint8_t* data, size_t data_len, s
 
     uvgrtp::buf_vec* buffers = fqueue_->get_buffer_vector();
 
+    // the buffers of a previous fragmented NAL unit of the frame are not used anymore
+    buffers->clear();
+
     // the default structure of one fragment
     buffers->push_back(std::make_pair(sizeof(headers->payload_header), headers->payload_header));
     buffers->push_back(std::make_pair(sizeof(uint8_t), &headers->fu_headers[0])); // first fragment
@@ -44,11 +44,6 @@ uint8_t uvgrtp::formats::h266::get_fu_header_size() const
     return HEADER_SIZE_H266_FU;
 }
 
-uint8_t uvgrtp::formats::h266::get_start_code_range() const
-{
-    return 4;
-}
-
 uvgrtp::formats::NAL_TYPE uvgrtp::formats::h266::get_nal_type(uvgrtp::frame::rtp_frame* frame) const
 {
     // see https://datatracker.ietf.org/doc/html/draft-ietf-avtcore-rtp-vvc#section-4.3.3
@@ -110,6 +105,9 @@ rtp_error_t uvgrtp::formats::h266::fu_division(uint8_t* data, size_t data_len, s
 
     uvgrtp::buf_vec* buffers = fqueue_->get_buffer_vector();
 
+    // the buffers of a previous fragmented NAL unit of the frame are not used anymore
+    buffers->clear();
+
     buffers->push_back(std::make_pair(sizeof(headers->payload_header), headers->payload_header));
     buffers->push_back(std::make_pair(sizeof(uint8_t), &headers->fu_headers[0]));
     buffers->push_back(std::make_pair(payload_size, nullptr));
@@ -1,14 +1,20 @@
 #include "h26x.hh"
+#include "scl.hh"
 
 #include "socket.hh"
 
 #include "rtp.hh"
 #include "frame_queue.hh"
+#include "rx_buffer.hh"
+#include "pool.hh"
+#include "thread_pool.hh"
 #include "debug.hh"
 
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <future>
 #include <iostream>
 #include <unordered_map>
 #include <queue>
@@ -18,85 +24,36 @@
 #include <sys/socket.h>
 #endif
 
-
 #define PTR_DIFF(a, b)  ((ptrdiff_t)((char *)(a) - (char *)(b)))
 
-// see https://graphics.stanford.edu/~seander/bithacks.html#ZeroInWord
-#define haszero64_le(v) (((v) - 0x0101010101010101) & ~(v) & 0x8080808080808080UL)
-#define haszero32_le(v) (((v) - 0x01010101)         & ~(v) & 0x80808080UL)
-
-#define haszero64_be(v) (((v) - 0x1010101010101010) & ~(v) & 0x0808080808080808UL)
-#define haszero32_be(v) (((v) - 0x10101010)         & ~(v) & 0x08080808UL)
-
-#ifndef __LITTLE_ENDIAN
-#define __LITTLE_ENDIAN 1337
-#endif
-
-#ifndef __BYTE_ORDER
-#define __BYTE_ORDER __LITTLE_ENDIAN
-#endif
-
-constexpr int GARBAGE_COLLECTION_INTERVAL_MS = 100;
+// with RCE_PARALLEL_SCL, smaller frames are still scanned on the calling thread
+constexpr size_t PARALLEL_SCL_MIN_SIZE = 1024 * 1024;
 
-// any value less than 30 minutes is ok here, since that is how long it takes to go through all timestamps
-constexpr int TIME_TO_KEEP_TRACK_OF_PREVIOUS_FRAMES_MS = 5000;
+// size of the chunks scanned by one worker thread
+constexpr size_t PARALLEL_SCL_CHUNK_SIZE = 256 * 1024;
 
-static inline uint8_t determine_start_prefix_precense(uint32_t value, bool& additional_byte)
+/* Return the positions of the start codes which begin in data[begin] - data[end - 1] */
+static std::vector<size_t> scan_chunk(const uint8_t* data, size_t begin, size_t end, size_t data_len)
 {
-    additional_byte = false;
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-    uint16_t cur_ls = (value >> 16) & 0xffff;
-    uint16_t cur_ms = (value >>  0) & 0xffff;
-
-    // zeros in more significant bytes
-    bool ms4z = (cur_ms                 == 0);
-    bool ms2z = (((cur_ms >> 8) & 0xff) == 0);
-
-    // possible start code end in less significant bytes
-    bool ls2s = ((cur_ls & 0xff)        == 0x01);
-    bool ls4s = (cur_ls                 == 0x0100);
-    
-#else
-    uint16_t cur_ls = (value >>  0) & 0xffff;
-    uint16_t cur_ms = (value >> 16) & 0xffff;
-
-    bool ms4z = ( cur_ms                == 0);
-    bool ms2z = ((cur_ms        & 0xff) == 0);
-    bool ls2s = (((cur_ls >> 8) & 0xff) == 0x01);
-    bool ls4s = (  cur_ls               == 0x0001);
-    
-#endif
+    std::vector<size_t> starts;
+    size_t scan_end = std::min(end + 2, data_len);
+    uint8_t start_len = 0;
+
+    for (ssize_t offset = uvgrtp::formats::find_start_code(data, scan_end, begin, start_len);
+         offset > -1;
+         offset = uvgrtp::formats::find_start_code(data, scan_end, (size_t)offset, start_len))
+    {
+        starts.push_back((size_t)offset - 3);
+    }
 
-    if (ms4z) {
-        /* 0x00000001 */
-        if (ls4s)
-            return 4;
-
-        /* "value" definitely has a start code (0x000001XX), but at this
-         * point we can't know for sure whether it's 3 or 4 bytes long.
-         *
-         * Return 5 to indicate that start length could not be determined
-         * and that caller must check previous dword's last byte for 0x00 */
-        if (ls2s)
-            return 5;
-    } else if (ms2z && ls4s) {
-        /* 0xXX000001 */
-        additional_byte = true;
-        return 4;
-    }
-
-    return 0;
+    return starts;
 }
 
 uvgrtp::formats::h26x::h26x(std::shared_ptr<uvgrtp::socket> socket, std::shared_ptr<uvgrtp::rtp> rtp, int rce_flags) :
     media(socket, rtp, rce_flags),
     queued_(), 
-    frames_(), 
-    fragments_(UINT16_MAX + 1, nullptr),
-    dropped_ts_(),
-    completed_ts_(),
+    reassembly_("H26x", [this](uint32_t) { discard_until_key_frame_ = true; }),
     rtp_ctx_(rtp),
-    last_garbage_collection_(uvgrtp::clock::hrc::now()),
     discard_until_key_frame_(true)
 {}
 
@@ -108,184 +65,15 @@ uvgrtp::formats::h26x::~h26x()
     }
 
     queued_.clear();
-
-    for (auto& fragment : fragments_)
-    {
-        if (fragment != nullptr)
-        {
-            (void)uvgrtp::frame::dealloc_frame(fragment);
-        }
-    }
-
-    fragments_.clear();
 }
 
-/* NOTE: the area 0 - len (ie data[0] - data[len - 1]) must be addressable
- * Do not add offset to "data" ptr before passing it to find_h26x_start_code()! */
 ssize_t uvgrtp::formats::h26x::find_h26x_start_code(
-    uint8_t *data,
+    const uint8_t *data,
     size_t len,
     size_t offset,
     uint8_t& start_len)
 {
-    if (data == nullptr || len < offset || len < 1)
-    {
-        UVG_LOG_WARN("Invalid parameter found for start code lookup");
-        return -1;
-    }
-
-    bool prev_had_zero   = false;
-    bool cur_has_zero    = false;
-    size_t pos           = offset;
-    size_t last_byte_position = len - (len % 8) - 1;
-
-    /* We can get rid of the bounds check when looping through
-     * non-zero 8 byte chunks by setting the last byte to zero.
-     *
-     * This added zero will make the last 8 byte zero check to fail
-     * and when we get out of the loop we can check if we've reached the end */
-    uint8_t temp_last_byte    = data[last_byte_position];
-    data[last_byte_position] = 0;
-
-    uint32_t prev_value32 = UINT32_MAX;
-    uint32_t cur_value32 = UINT32_MAX;
-
-    uint64_t prefetch64 = UINT64_MAX;
-
-    while (pos + 4 <= len) {
-
-        if (!prev_had_zero)
-        {
-            // since we know that start code prefix has zeros, we find the next dword that has zeros
-            while (!cur_has_zero && pos + 8 <= len)
-            {
-                prefetch64 = *(uint64_t*)(data + pos);
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-                cur_has_zero = haszero64_le(prefetch64);
-#else
-                cur_has_zero = haszero64_be(prefetch64);
-#endif
-                if (!cur_has_zero)
-                {
-                    pos += 8;
-                }
-            }
-        }
-
-        if (pos + 4 <= len)
-        {
-            cur_value32 = *(uint32_t*)(data + pos);
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-            cur_has_zero = haszero32_le(cur_value32);
-#else
-            cur_has_zero = haszero32_be(cur_value32);
-#endif
-        }
-
-        if ((prev_had_zero || cur_has_zero) && pos + 4 <= len)
-        {
-            /* Previous dword had zeros but this doesn't. The only way there might be a start code
-             * is if the most significant byte of current dword is 0x01 */
-            if (prev_had_zero) {
-                /* previous dword: 0xXX000000 or 0xXXXX0000 and current dword 0x01XXXXXX */
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-                if (((cur_value32 >> 0) & 0xff) == 0x01 && ((prev_value32 >> 16) & 0xffff) == 0) {
-                    start_len = (((prev_value32 >>  8) & 0xffffff) == 0) ? 4 : 3;
-#else
-                if (((cur_value32 >> 24) & 0xff) == 0x01 && ((prev_value32 >>  0) & 0xffff) == 0) {
-                    start_len = (((prev_value32 >>  0) & 0xffffff) == 0) ? 4 : 3;
-#endif
-                    data[last_byte_position] = temp_last_byte;
-                    return pos + 1;
-                }
-            }
-
-            // find out if the current value as a whole contains start code prefix
-            bool additional_byte =  false;
-            uint8_t ret = determine_start_prefix_precense(cur_value32, additional_byte);
-            start_len = ret;
-            if (ret > 0) {
-                if (ret == 5) {
-                    // ret 5 means we don't know how long the start code is so we check it
-
-                    ret = 3;
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-                    start_len = (((prev_value32 >> 24) & 0xff) == 0) ? 4 : 3;
-#else
-                    start_len = (((prev_value32 >>  0) & 0xff) == 0) ? 4 : 3;
-#endif
-                }
-                if (additional_byte)
-                {
-                    --start_len;
-                }
-                data[last_byte_position] = temp_last_byte;
-                return pos + ret;
-            }
-
-            // see if the start code prefix is split between previous and this dword
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-            uint16_t cur_ls  = (cur_value32 >> 16) & 0xffff; // current less significant word
-            uint16_t cur_ms  = (cur_value32 >>  0) & 0xffff; // corrent more significant word
-            uint16_t prev_ls = (prev_value32 >> 16) & 0xffff; // previous less significant word
-
-            // previous has 4 zeros
-            bool p4z = (prev_ls                  == 0); 
-
-            // previous has 2 zeros
-            bool p2z = (((prev_ls >> 8) & 0xff)  == 0);
-            
-            // current has 2 bytes of possible start code
-            //bool c2s = (((cur_ms >> 8) & 0xff)              == 0x01);
-
-            // current has 4 bytes of possible start code
-            bool c4s = (cur_ms                              == 0x0100); // current starts with 0001
-
-            // current has 6 bytes of start code
-            bool c6s = (cur_ms == 0x0000 && (cur_ls & 0xff) == 0x01);   // current is 0000 01XX
-
-#else
-            uint16_t cur_ls =  (cur_value32 >>  0) & 0xffff;
-            uint16_t cur_ms =  (cur_value32 >> 16) & 0xffff;
-            uint16_t prev_ls = (prev_value32 >>  0) & 0xffff;
-
-            bool p4z = (prev_ls == 0);
-            bool p2z = ((prev_ls & 0xff)   == 0);
-            //bool c2s = ((cur_ms & 0xff)    == 0x01);
-            bool c4s = (cur_ms == 0x0001);
-            bool c6s = (cur_ms == 0x0000 && ((cur_ls >> 8) & 0xff) == 0x01);
-#endif
-            // all possible start code modes between two bytes
-            if (p4z && c4s) {
-                // previous dword 0xXXXX0000 and current dword is 0x0001XXXX
-                start_len = 4;
-                data[last_byte_position] = temp_last_byte;
-                return pos + 2;
-            } else if (p2z) {
-                // Previous dword was 0xXXXXXX00
-                
-                if (c6s) {
-                    // Current dword is 0x000001XX
-                    start_len = 4;
-                    data[last_byte_position] = temp_last_byte;
-                    return pos + 3;
-                }
-                else if (c4s) {
-                    // Current dword is 0x0001XXXX
-                    start_len = 3;
-                    data[last_byte_position] = temp_last_byte;
-                    return pos + 2;
-                }
-            }
-        }
-
-        prev_had_zero = cur_has_zero;
-        pos += get_start_code_range();
-        prev_value32 = cur_value32;
-    }
-
-    data[last_byte_position] = temp_last_byte;
-    return -1;
+    return uvgrtp::formats::find_start_code(data, len, offset, start_len);
 }
 
 rtp_error_t uvgrtp::formats::h26x::frame_getter(uvgrtp::frame::rtp_frame** frame)
@@ -326,6 +114,9 @@ rtp_error_t uvgrtp::formats::h26x::push_media_frame(uint8_t* data, size_t data_l
 
         nals.push_back(nal);
     }
+    else if ((rce_flags_ & RCE_PARALLEL_SCL) && data_len >= PARALLEL_SCL_MIN_SIZE) {
+        parallel_scl(data, data_len, payload_size, nals, should_aggregate);
+    }
     else {
         scl(data, data_len, payload_size, nals, should_aggregate);
     }
@@ -361,18 +152,7 @@ rtp_error_t uvgrtp::formats::h26x::push_media_frame(uint8_t* data, size_t data_l
     {
         if (!nal.aggregate || !should_aggregate)
         {
-            // single NAL unit uses the NAL unit header as the payload header meaning that it does not
-            // add anything extra to the packet and we can just compare the NAL size with the payload size allowed
-            if (nal.size <= payload_size) // send as a single NAL unit packet
-            {
-                ret = single_nal_unit(data + nal.offset, nal.size);
-            }
-            else // send divided based on payload_size
-            {
-                ret = fu_division(&data[nal.offset], nal.size, payload_size);
-            }
-
-            if (ret != RTP_OK)
+            if ((ret = send_nal_unit(data + nal.offset, nal.size, payload_size)) != RTP_OK)
             {
                 clear_aggregation_info();
                 fqueue_->deinit_transaction();
@@ -388,6 +168,62 @@ rtp_error_t uvgrtp::formats::h26x::push_media_frame(uint8_t* data, size_t data_l
     return ret;
 }
 
+rtp_error_t uvgrtp::formats::h26x::send_nal_unit(uint8_t* data, size_t data_len, size_t payload_size)
+{
+    // single NAL unit uses the NAL unit header as the payload header meaning that it does not
+    // add anything extra to the packet and we can just compare the NAL size with the payload size allowed
+    if (data_len <= payload_size) // send as a single NAL unit packet
+    {
+        return single_nal_unit(data, data_len);
+    }
+
+    // send divided based on payload_size
+    return fu_division(data, data_len, payload_size);
+}
+
+void uvgrtp::formats::h26x::parallel_scl(uint8_t* data, size_t data_len, size_t packet_size,
+    std::vector<nal_info>& nals, bool& can_be_aggregated)
+{
+    /* The calling thread scans the first chunk and the workers scan the rest. Each chunk is scanned
+     * two bytes past its end so that start codes crossing the chunk boundary are found exactly once */
+    size_t chunks = (data_len + PARALLEL_SCL_CHUNK_SIZE - 1) / PARALLEL_SCL_CHUNK_SIZE;
+    std::vector<std::future<std::vector<size_t>>> results;
+
+    for (size_t i = 1; i < chunks; ++i)
+    {
+        size_t begin = i * PARALLEL_SCL_CHUNK_SIZE;
+        size_t end   = std::min(begin + PARALLEL_SCL_CHUNK_SIZE, data_len);
+
+        auto task = std::make_shared<std::packaged_task<std::vector<size_t>()>>([data, begin, end, data_len]() {
+            return scan_chunk(data, begin, end, data_len);
+        });
+
+        results.push_back(task->get_future());
+        uvgrtp::thread_pool::shared().submit([task]() { (*task)(); });
+    }
+
+    auto add_nals = [&](const std::vector<size_t>& starts) {
+        for (size_t start : starts)
+        {
+            nal_info nal;
+            nal.offset = start + 3;
+            nal.prefix_len = (start > 0 && data[start - 1] == 0) ? 4 : 3;
+
+            nals.push_back(nal);
+        }
+    };
+
+    add_nals(scan_chunk(data, 0, std::min(PARALLEL_SCL_CHUNK_SIZE, data_len), data_len));
+
+    // the chunk results are in frame order, and the workers are done with "data" once all have been read
+    for (auto& result : results)
+    {
+        add_nals(result.get());
+    }
+
+    set_nal_sizes(data_len, packet_size, nals, can_be_aggregated);
+}
+
 rtp_error_t uvgrtp::formats::h26x::add_aggregate_packet(uint8_t* data, size_t data_len)
 {
     // the default implementation is to just use single NAL units and don't do the aggregate packet
@@ -486,7 +322,7 @@ uvgrtp::frame::rtp_frame* uvgrtp::formats::h26x::allocate_rtp_frame_with_startco
         complete->payload_len += 4;
     } 
     
-    complete->payload = new uint8_t[complete->payload_len];
+    uvgrtp::frame::alloc_payload(complete, complete->payload_len);
 
     if (add_start_code && complete->payload_len >= 4) {
         complete->payload[0] = 0;
@@ -501,58 +337,51 @@ uvgrtp::frame::rtp_frame* uvgrtp::formats::h26x::allocate_rtp_frame_with_startco
     return complete;
 }
 
-void uvgrtp::formats::h26x::prepend_start_code(int rce_flags, uvgrtp::frame::rtp_frame** out)
+bool uvgrtp::formats::h26x::prepend_start_code_in_place(uvgrtp::frame::rtp_frame* frame, uint8_t start_code_len)
 {
-    if (!(rce_flags & RCE_NO_H26X_PREPEND_SC)) {
-        uint8_t* pl = new uint8_t[(*out)->payload_len + 4];
+    // payloads copied from the reception buffer are allocated with headroom for the start code
+    if (!uvgrtp::frame::claim_headroom(frame, start_code_len)) {
+        if (!frame->owner || !frame->dgram)
+            return false;
 
-        pl[0] = 0;
-        pl[1] = 0;
-        pl[2] = 0;
-        pl[3] = 1;
+        // extension data sits between the RTP header and the payload and must be preserved
+        uint8_t* header_end = frame->dgram;
+        if (frame->ext && frame->ext->data)
+            header_end = frame->ext->data + frame->ext->len;
 
-        std::memcpy(pl + 4, (*out)->payload, (*out)->payload_len);
-        delete[](*out)->payload;
+        if (frame->payload < header_end + start_code_len)
+            return false;
 
-        (*out)->payload = pl;
-        (*out)->payload_len += 4;
+        frame->payload -= start_code_len;
+        frame->payload_len += start_code_len;
     }
-}
 
-bool uvgrtp::formats::h26x::is_frame_late(uvgrtp::formats::h26x_info_t& hinfo, size_t max_delay)
-{
-    return (uvgrtp::clock::hrc::diff_now(hinfo.sframe_time) >= max_delay);
+    std::memset(frame->payload, 0, start_code_len - 1);
+    frame->payload[start_code_len - 1] = 1;
+
+    return true;
 }
 
-size_t uvgrtp::formats::h26x::drop_frame(uint32_t ts)
+void uvgrtp::formats::h26x::prepend_start_code(int rce_flags, uvgrtp::frame::rtp_frame** out)
 {
-    size_t total_cleaned = 0;
-    if (frames_.find(ts) == frames_.end())
-    {
-        UVG_LOG_ERROR("Tried to drop a non-existing frame");
-        return total_cleaned;
-    }
+    if (!(rce_flags & RCE_NO_H26X_PREPEND_SC)) {
+        if (prepend_start_code_in_place(*out, 4))
+            return;
 
-    /*
-    uint16_t s_seq = frames_.at(ts).s_seq;
-    uint16_t e_seq = frames_.at(ts).e_seq;
+        // the detached payload gets headroom, so the start code can be written without a second copy
+        uvgrtp::frame::detach_rx_buffer(*out);
 
-    UVG_LOG_INFO("Dropping frame. Ts: %lu, Seq: %u <-> %u, received/expected: %lli/%lli", 
-        ts, s_seq, e_seq, frames_[ts].received_packet_seqs.size(), calculate_expected_fus(ts));
-    */
+        if (prepend_start_code_in_place(*out, 4))
+            return;
 
-    for (auto& fragment_seq : frames_[ts].received_packet_seqs)
-    {
-        total_cleaned += fragments_[fragment_seq]->payload_len + sizeof(uvgrtp::frame::rtp_frame);
-        free_fragment(fragment_seq);
-    }
+        uint8_t* pl = uvgrtp::frame::move_payload(*out, (*out)->payload_len + 4, 4);
 
-    dropped_ts_[ts] = frames_.at(ts).sframe_time;
-    frames_.erase(ts);
-
-    discard_until_key_frame_ = true;
-
-    return total_cleaned;
+        pl[0] = 0;
+        pl[1] = 0;
+        pl[2] = 0;
+        pl[3] = 1;
+        (*out)->payload_len += 4;
+    }
 }
 
 rtp_error_t uvgrtp::formats::h26x::handle_aggregation_packet(uvgrtp::frame::rtp_frame** out, 
@@ -574,6 +403,8 @@ rtp_error_t uvgrtp::formats::h26x::handle_aggregation_packet(uvgrtp::frame::rtp_
         }
         else {
             UVG_LOG_ERROR("The received aggregation packet claims to be larger than packet!");
+            (void)uvgrtp::frame::dealloc_frame(frame);
+            *out = nullptr;
             return RTP_GENERIC_ERROR;
         }
     }
@@ -584,6 +415,7 @@ rtp_error_t uvgrtp::formats::h26x::handle_aggregation_packet(uvgrtp::frame::rtp_
         bool prepend_startcode = !(rce_flags & RCE_NO_H26X_PREPEND_SC);
         uvgrtp::frame::rtp_frame* retframe = 
             allocate_rtp_frame_with_startcode(prepend_startcode, (*out)->header, nalus[i].first, fptr);
+        retframe->arrival_ntp = (*out)->arrival_ntp;
         
         std::memcpy(
             retframe->payload + fptr,
@@ -594,6 +426,10 @@ rtp_error_t uvgrtp::formats::h26x::handle_aggregation_packet(uvgrtp::frame::rtp_
         queued_.push_back(retframe);
     }
 
+    // the NAL units have been copied and the frames are returned through the frame getter
+    (void)uvgrtp::frame::dealloc_frame(frame);
+    *out = nullptr;
+
     return RTP_MULTIPLE_PKTS_READY;
 }
 
@@ -604,15 +440,20 @@ rtp_error_t uvgrtp::formats::h26x::packet_handler(int rce_flags, uvgrtp::frame::
     // aggregate, start, middle, end or single NAL
     uvgrtp::formats::FRAG_TYPE frag_type = get_fragment_type(frame); 
 
+    // a frame the stream has moved past can no longer be completed, so it is dropped before its deadline
+    (void)reassembly_.detect_lost_frames(frame->header.seq);
+
     // first we check that this packet does not belong to a frame that has been dropped or completed
-    if (dropped_ts_.find(frame->header.timestamp) != dropped_ts_.end()) {
+    const finished_frame* finished = reassembly_.find_finished(frame->header.timestamp);
+
+    if (finished && finished->dropped) {
         UVG_LOG_DEBUG("Received an RTP packet belonging to a dropped frame! Timestamp: %lu, seq: %u",
             frame->header.timestamp, frame->header.seq);
         (void)uvgrtp::frame::dealloc_frame(frame); // free fragment memory
         return RTP_GENERIC_ERROR;
     }
 
-    if (completed_ts_.find(frame->header.timestamp) != completed_ts_.end()) {
+    if (finished) {
         UVG_LOG_DEBUG("Received an RTP packet belonging to a completed frame! Timestamp: %lu, seq: %u",
             frame->header.timestamp, frame->header.seq);
         (void)uvgrtp::frame::dealloc_frame(frame); // free fragment memory
@@ -631,7 +472,7 @@ rtp_error_t uvgrtp::formats::h26x::packet_handler(int rce_flags, uvgrtp::frame::
 
         // TODO: We should detect duplicate packets, but there are legitimate situations
         //  where single NAL units have same timestamps
-        //completed_ts_[frame->header.timestamp] = std::chrono::high_resolution_clock::now();
+        //finished_.remember(frame->header.timestamp, false, uvgrtp::clock::hrc::now());
 
         // nothing special needs to be done, just possibly add start codes back
         prepend_start_code(rce_flags, out);
@@ -655,12 +496,9 @@ rtp_error_t uvgrtp::formats::h26x::packet_handler(int rce_flags, uvgrtp::frame::
 
     uvgrtp::formats::NAL_TYPE nal_type = get_nal_type(frame); // Intra, inter or some other type of frame
     
-    // Initialize new frame if this is the first packet with this timestamp
-    if (frames_.find(fragment_ts) == frames_.end()) {
-        initialize_new_fragmented_frame(fragment_ts, nal_type);
-    }
-    else if (frames_[fragment_ts].received_packet_seqs.find(fragment_seq) !=
-        frames_[fragment_ts].received_packet_seqs.end()) {
+    const fragmented_frame* existing = reassembly_.find(fragment_ts);
+
+    if (existing && reassembly_.is_received(fragment_ts, fragment_seq)) {
 
         // we have already received this seq
         UVG_LOG_DEBUG("Detected duplicate fragment, dropping! Fragment ts: %lu, Seq: %u", 
@@ -673,53 +511,35 @@ rtp_error_t uvgrtp::formats::h26x::packet_handler(int rce_flags, uvgrtp::frame::
     const uint8_t sizeof_fu_headers = (uint8_t)get_payload_header_size() + 
                                                get_fu_header_size();
 
-    if (frames_[fragment_ts].nal_type != nal_type)
+    // the oldest fragment of the frame tells the NAL type of the frame
+    if (existing && get_nal_type(reassembly_.fragment(existing->first_seq)) != nal_type)
     {
         UVG_LOG_ERROR("The fragment has different NAL type fragments before!");
         (void)uvgrtp::frame::dealloc_frame(frame); // free fragment memory
+        *out = nullptr;
         return RTP_GENERIC_ERROR;
     }
 
-    // keep track of fragments belonging to this frame in case we need to delete them
-    frames_[fragment_ts].received_packet_seqs.insert(fragment_seq);
-    frames_[fragment_ts].total_size += (frame->payload_len - sizeof_fu_headers);
-
-    if (fragments_[fragment_seq] != nullptr)
-    {
-        UVG_LOG_WARN("Found an existing fragment with same sequence number %u! Fragment ts: %lu, current ts: %lu",
-            fragment_seq, fragments_[fragment_seq]->header.timestamp, fragment_ts);
-
-        free_fragment(fragment_seq);
-    }
-
     // save the fragment for later reconstruction
-    fragments_[fragment_seq] = frame;
-
-    // if this is first or last, save it to help with reconstruction
-    if (frag_type == uvgrtp::formats::FRAG_TYPE::FT_START) {
-        frames_[fragment_ts].s_seq = fragment_seq; 
-        frames_[fragment_ts].start_received = true;
-    }
-    else if (frag_type == uvgrtp::formats::FRAG_TYPE::FT_END) {
-        frames_[fragment_ts].e_seq = fragment_seq;
-        frames_[fragment_ts].end_received = true;
-    }
+    const fragmented_frame& info = reassembly_.insert(frame,
+        frag_type == uvgrtp::formats::FRAG_TYPE::FT_START, frag_type == uvgrtp::formats::FRAG_TYPE::FT_END);
+    *out = nullptr;
 
     // have the first and last fragment arrived so we can possibly start reconstructing the frame?
-    if (frames_[fragment_ts].start_received && frames_[fragment_ts].end_received) {
-        size_t received = calculate_expected_fus(fragment_ts);
+    if (info.start_received && info.end_received) {
+        size_t expected = (size_t)(uint16_t)(info.e_seq - info.s_seq) + 1;
 
         // have we received every fragment and can the frame can be reconstructed?
-        if (received == frames_[fragment_ts].received_packet_seqs.size()) {
+        if (expected == info.received_count) {
 
             bool enable_reference_discarding = (rce_flags & RCE_H26X_DEPENDENCY_ENFORCEMENT);
             // here we discard inter frames if their references were not received correctly
             if (discard_until_key_frame_ && enable_reference_discarding) {
                 if (nal_type == uvgrtp::formats::NAL_TYPE::NT_INTER) {
                     UVG_LOG_WARN("Dropping h26x frame because of missing reference. Timestamp: %lu. Seq: %u - %u",
-                        fragment_ts, frames_[fragment_ts].s_seq, frames_[fragment_ts].e_seq);
+                        fragment_ts, info.s_seq, info.e_seq);
 
-                    drop_frame(fragment_ts);
+                    (void)reassembly_.drop_frame(fragment_ts);
                     return RTP_GENERIC_ERROR;
                 }
                 else if (nal_type == uvgrtp::formats::NAL_TYPE::NT_INTRA) {
@@ -730,127 +550,23 @@ rtp_error_t uvgrtp::formats::h26x::packet_handler(int rce_flags, uvgrtp::frame::
                 }
             }
 
+            *out = frame;
             return reconstruction(out, rce_flags, fragment_ts, sizeof_fu_headers);
         }
     }
 
     // make sure uvgRTP does not reserve increasing amounts of memory because some frames are not completed
-    garbage_collect_lost_frames(rtp_ctx_->get_pkt_max_delay());
+    // RCC_REASSEMBLY_MEMORY_LIMIT only applies to generic frames
+    reassembly_.garbage_collect(rtp_ctx_->get_pkt_max_delay(), SIZE_MAX);
     return RTP_OK; // no frame was completed, but everything went ok for this fragment
 }
 
-void uvgrtp::formats::h26x::garbage_collect_lost_frames(size_t timout)
-{
-    if (uvgrtp::clock::hrc::diff_now(last_garbage_collection_) >= GARBAGE_COLLECTION_INTERVAL_MS) {
-        size_t total_cleaned = 0;
-        std::vector<uint32_t> to_remove;
-
-        // first find all frames that have been waiting for too long
-        for (auto& gc_frame : frames_) {
-            if (uvgrtp::clock::hrc::diff_now(gc_frame.second.sframe_time) > timout) {
-#ifndef __RTP_SILENT__
-                uint16_t s_seq = gc_frame.second.s_seq;
-                uint16_t e_seq = gc_frame.second.e_seq;
-                UVG_LOG_WARN("Found an old frame that has not been completed. Ts: %lu, Seq: %u <-> %u, received/expected: %lli/%lli",
-                    gc_frame.first, s_seq, e_seq, gc_frame.second.received_packet_seqs.size(), calculate_expected_fus(gc_frame.first));
-#endif
-                to_remove.push_back(gc_frame.first);
-            }
-        }
-
-        // remove old frames
-        for (auto& old_frame : to_remove) {
-
-            total_cleaned += drop_frame(old_frame);
-        }
-
-        if (total_cleaned > 0) {
-            UVG_LOG_DEBUG("Garbage collection cleaned %d bytes!", total_cleaned);
-        }
-
-        // we keep track of old frames, so we don't send duplicate frames forward twice
-        std::vector<uint32_t> to_remove_completed;
-        for (auto& invalid : completed_ts_) {
-            if (uvgrtp::clock::hrc::diff_now(invalid.second) > TIME_TO_KEEP_TRACK_OF_PREVIOUS_FRAMES_MS)
-            {
-                to_remove_completed.push_back(invalid.first);
-            }
-        }
-
-        for (auto& old_invalid : to_remove_completed)
-        {
-            completed_ts_.erase(old_invalid);
-        }
-
-        // we keep track of old dopped, so we don't send invalid frames forward again
-        to_remove_completed.clear();
-        for (auto& invalid : dropped_ts_) {
-            if (uvgrtp::clock::hrc::diff_now(invalid.second) > TIME_TO_KEEP_TRACK_OF_PREVIOUS_FRAMES_MS)
-            {
-                to_remove_completed.push_back(invalid.first);
-            }
-        }
-
-        for (auto& old_invalid : to_remove_completed)
-        {
-            dropped_ts_.erase(old_invalid);
-        }
-
-        last_garbage_collection_ = uvgrtp::clock::hrc::now();
-    }
-}
-
-void uvgrtp::formats::h26x::initialize_new_fragmented_frame(uint32_t ts, NAL_TYPE nal_type)
-{
-    frames_[ts].nal_type = nal_type;
-    frames_[ts].s_seq = 0;
-    frames_[ts].start_received = false;
-    frames_[ts].e_seq = 0;
-    frames_[ts].end_received = false;
-
-    frames_[ts].sframe_time = uvgrtp::clock::hrc::now();
-    frames_[ts].total_size = 0;
-}
-
-size_t uvgrtp::formats::h26x::calculate_expected_fus(uint32_t ts)
-{
-    size_t expected = 0;
-    size_t s_seq = frames_[ts].s_seq;
-    size_t e_seq = frames_[ts].e_seq;
-
-    if (frames_[ts].start_received && frames_[ts].end_received)
-    {
-        if (s_seq > e_seq) {
-            expected = (UINT16_MAX - s_seq) + e_seq + 2;
-        }
-        else {
-            expected = e_seq - s_seq + 1;
-        }
-    }
-
-    return expected;
-}
-
-void uvgrtp::formats::h26x::free_fragment(uint16_t sequence_number)
-{
-    if (fragments_[sequence_number] == nullptr)
-    {
-        UVG_LOG_ERROR("Tried to free an already freed fragment with seq: %u", sequence_number);
-        return;
-    }
-
-    (void)uvgrtp::frame::dealloc_frame(fragments_[sequence_number]); // free fragment memory
-    fragments_[sequence_number] = nullptr;
-}
-
 void uvgrtp::formats::h26x::scl(uint8_t* data, size_t data_len, size_t packet_size, 
     std::vector<nal_info>& nals, bool& can_be_aggregated)
 {
     uint8_t start_len = 0;
     ssize_t offset = find_h26x_start_code(data, data_len, 0, start_len);
 
-    packet_size -= get_payload_header_size(); // aggregate packet has a payload header
-
     while (offset > -1) {
         nal_info nal;
         nal.offset = size_t(offset);
@@ -863,6 +579,14 @@ void uvgrtp::formats::h26x::scl(uint8_t* data, size_t data_len, size_t packet_si
         offset = find_h26x_start_code(data, data_len, offset, start_len);
     }
 
+    set_nal_sizes(data_len, packet_size, nals, can_be_aggregated);
+}
+
+void uvgrtp::formats::h26x::set_nal_sizes(size_t data_len, size_t packet_size,
+    std::vector<nal_info>& nals, bool& can_be_aggregated)
+{
+    packet_size -= get_payload_header_size(); // aggregate packet has a payload header
+
     size_t aggregate_size = 0;
     int aggregatable_packets = 0;
 
@@ -903,41 +627,76 @@ rtp_error_t uvgrtp::formats::h26x::reconstruction(uvgrtp::frame::rtp_frame** out
     //LOG_DEBUG("Reconstructing frame. Ts: %lu, Seq: %u -> %u", frame_timestamp, 
     //    frames_.at(frame_timestamp).s_seq, frames_.at(frame_timestamp).e_seq);
 
+    const fragmented_frame& info = *reassembly_.find(frame_timestamp);
+    uint16_t s_seq = info.s_seq;
+    uint16_t next_from_last = info.e_seq + 1;
+    size_t fragment_count = 0;
+
+    // check that every fragment is present before anything is allocated for the NAL unit
+    for (uint16_t i = s_seq; i != next_from_last; ++i, ++fragment_count)
+    {
+        if (reassembly_.fragment(i) == nullptr)
+        {
+            UVG_LOG_ERROR("Missing fragment in reconstruction. Seq range: %u - %u. Missing seq %u",
+                s_seq, info.e_seq, i);
+            return RTP_GENERIC_ERROR;
+        }
+    }
+
+    bool scatter_gather = (rce_flags & RCE_H26X_SCATTER_GATHER);
+
     // Reconstruction of frame from fragments
     size_t fptr = 0;
 
-    // allocating the frame with start code ready saves a copy operation for the frame
+    // allocating the frame with start code ready saves a copy operation for the frame.
+    // With scatter-gather output the payload of the frame only holds the start code and the NAL header
+    size_t payload_size = get_nal_header_size() + (scatter_gather ? 0 : info.size - fragment_count * sizeof_fu_headers);
     uvgrtp::frame::rtp_frame* complete = allocate_rtp_frame_with_startcode(!(rce_flags & RCE_NO_H26X_PREPEND_SC),
-        frame->header, get_nal_header_size() + frames_[frame_timestamp].total_size, fptr);
+        frame->header, payload_size, fptr);
+    complete->arrival_ntp = frame->arrival_ntp;
 
     // construct the NAL header from fragment header of current fragment
     get_nal_header_from_fu_headers(fptr, frame->payload, complete->payload); // NAL header
     fptr += get_nal_header_size();
 
-    uint16_t next_from_last = frames_.at(frame_timestamp).e_seq + 1;
-    for (uint16_t i = frames_.at(frame_timestamp).s_seq; i != next_from_last; ++i)
+    if (scatter_gather)
     {
-        if (fragments_[i] == nullptr)
+        uvgrtp::frame::payload_fragment* views = uvgrtp::frame::alloc_fragments(complete, fragment_count + 1);
+        views[0].data = complete->payload;
+        views[0].len  = complete->payload_len;
+
+        size_t view = 1;
+        for (uint16_t i = s_seq; i != next_from_last; ++i, ++view)
         {
-            UVG_LOG_ERROR("Missing fragment in reconstruction. Seq range: %u - %u. Missing seq %u",
-                frames_.at(frame_timestamp).s_seq, frames_.at(frame_timestamp).e_seq, i);
-            return RTP_GENERIC_ERROR;
-        }
+            uvgrtp::frame::rtp_frame* fragment = reassembly_.take_fragment(i);
 
-        // copy everything expect fu headers (which repeat for every fu)
-        std::memcpy(
-            &complete->payload[fptr],
-            &fragments_[i]->payload[sizeof_fu_headers],
-            fragments_[i]->payload_len - sizeof_fu_headers
-        );
-        fptr += fragments_[i]->payload_len - sizeof_fu_headers;
-        free_fragment(i);
+            // the fragment is freed together with the complete frame
+            views[view].data = &fragment->payload[sizeof_fu_headers];
+            views[view].len  = fragment->payload_len - sizeof_fu_headers;
+
+            uvgrtp::frame::hold_fragment(complete, fragment);
+        }
+    }
+    else
+    {
+        for (uint16_t i = s_seq; i != next_from_last; ++i)
+        {
+            uvgrtp::frame::rtp_frame* fragment = reassembly_.take_fragment(i);
+
+            // copy everything expect fu headers (which repeat for every fu)
+            std::memcpy(
+                &complete->payload[fptr],
+                &fragment->payload[sizeof_fu_headers],
+                fragment->payload_len - sizeof_fu_headers
+            );
+            fptr += fragment->payload_len - sizeof_fu_headers;
+            (void)uvgrtp::frame::dealloc_frame(fragment); // free fragment memory
+        }
     }
 
     *out = complete;      // save result to output
 
     // keep track of completed frames so we don't accept the same frame again
-    completed_ts_[frame_timestamp] = frames_.at(frame_timestamp).sframe_time;
-    frames_.erase(frame_timestamp);  // erase data structures for this frame
+    reassembly_.complete_frame(frame_timestamp);
     return RTP_PKT_READY; // indicate that we have a frame ready
 }
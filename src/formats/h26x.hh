@@ -9,7 +9,7 @@
 
 #include <deque>
 #include <memory>
-#include <set>
+#include <vector>
 
 namespace uvgrtp {
 
@@ -33,28 +33,6 @@ namespace uvgrtp {
             NT_OTHER = 0xff
         };
 
-        typedef struct h26x_info {
-            /* clock reading when the first fragment is received */
-            uvgrtp::clock::hrc::hrc_t sframe_time;
-
-            uvgrtp::formats::NAL_TYPE nal_type = uvgrtp::formats::NAL_TYPE::NT_OTHER;
-
-            bool start_received = false;
-            bool end_received = false;
-
-            /* sequence number of the fragment with s-bit (start) */
-            uint16_t s_seq = 0;
-
-            /* sequence number of the fragment with e-bit (end) */
-            uint16_t e_seq = 0;
-
-            /* total size of all fragments */
-            size_t total_size = 0;
-
-            // needed for cleaning fragments in case the frame is dropped
-            std::set<uint16_t> received_packet_seqs;
-        } h26x_info_t;
-
         struct nal_info
         {
             size_t offset = 0;
@@ -69,11 +47,11 @@ namespace uvgrtp {
                 virtual ~h26x();
 
                 /* Find H26x start code from "data"
-                 * This process is the same for H26{4,5,6}
+                 * This process is the same for H26{4,5,6}, see formats/scl.hh
                  *
-                 * Return the offset of the start code on success
+                 * Return the offset of the first byte after the start code on success
                  * Return -1 if no start code was found */
-                ssize_t find_h26x_start_code(uint8_t *data, size_t len, size_t offset, uint8_t& start_len);
+                ssize_t find_h26x_start_code(const uint8_t *data, size_t len, size_t offset, uint8_t& start_len);
 
                 /* Top-level push_frame() called by the Media class
                  * Sets up the frame queue for the send operation
@@ -121,6 +99,10 @@ namespace uvgrtp {
 
                 rtp_error_t single_nal_unit(uint8_t* data, size_t data_len);
 
+                /* Send a NAL unit as a single NAL unit packet if it fits to "payload_size"
+                 * and as fragmentation units otherwise */
+                rtp_error_t send_nal_unit(uint8_t* data, size_t data_len, size_t payload_size);
+
                 // constructs format specific RTP header with correct values
                 virtual rtp_error_t fu_division(uint8_t* data, size_t data_len, size_t payload_size) = 0;
 
@@ -138,7 +120,6 @@ namespace uvgrtp {
                 virtual uint8_t get_payload_header_size() const = 0;
                 virtual uint8_t get_nal_header_size() const = 0;
                 virtual uint8_t get_fu_header_size() const = 0;
-                virtual uint8_t get_start_code_range() const = 0;
                 virtual uvgrtp::formats::FRAG_TYPE get_fragment_type(uvgrtp::frame::rtp_frame* frame) const = 0;
                 virtual uvgrtp::formats::NAL_TYPE  get_nal_type(uvgrtp::frame::rtp_frame* frame) const = 0;
 
@@ -149,38 +130,38 @@ namespace uvgrtp {
 
                 virtual void prepend_start_code(int rce_flags, uvgrtp::frame::rtp_frame** out);
 
-        private:
-
-            bool is_frame_late(uvgrtp::formats::h26x_info_t& hinfo, size_t max_delay);
-            size_t drop_frame(uint32_t ts);
+                /* Write the start code in front of the payload if the payload was allocated with
+                 * headroom or, for a zero-copy frame, if the already parsed RTP header leaves room for it
+                 *
+                 * Return true if the start code was written
+                 * Return false if the payload has to be copied */
+                bool prepend_start_code_in_place(uvgrtp::frame::rtp_frame* frame, uint8_t start_code_len);
 
-            inline size_t calculate_expected_fus(uint32_t ts);
-            inline void initialize_new_fragmented_frame(uint32_t ts, NAL_TYPE nal_type);
+        private:
 
-            void free_fragment(uint16_t sequence_number);
+            /* Same as scl() but the start codes of a large frame are searched for
+             * on the shared worker pool (RCE_PARALLEL_SCL) */
+            void parallel_scl(uint8_t* data, size_t data_len, size_t packet_size,
+                std::vector<nal_info>& nals, bool& can_be_aggregated);
 
             void scl(uint8_t* data, size_t data_len, size_t packet_size, 
                 std::vector<nal_info>& nals, bool& can_be_aggregated);
 
-            void garbage_collect_lost_frames(size_t timout);
+            /* Calculate the sizes of the NAL units found by scl() and mark
+             * the ones that fit to an aggregation packet */
+            void set_nal_sizes(size_t data_len, size_t packet_size,
+                std::vector<nal_info>& nals, bool& can_be_aggregated);
 
             rtp_error_t reconstruction(uvgrtp::frame::rtp_frame** out,
                 int rce_flags, uint32_t frame_timestamp, const uint8_t sizeof_fu_headers);
 
             std::deque<uvgrtp::frame::rtp_frame*> queued_;
-            std::unordered_map<uint32_t, h26x_info_t> frames_;
 
-            // Holds all possible fragments in sequence number order
-            std::vector<uvgrtp::frame::rtp_frame*> fragments_;
-
-            // keep track of frames discarded so we don't accept invalid fragments
-            std::unordered_map<uint32_t, uvgrtp::clock::hrc::hrc_t> dropped_ts_;
-            std::unordered_map<uint32_t, uvgrtp::clock::hrc::hrc_t> completed_ts_;
+            // fragments of the NAL units that have not been completed yet
+            reassembly reassembly_;
 
             std::shared_ptr<uvgrtp::rtp> rtp_ctx_;
 
-            uvgrtp::clock::hrc::hrc_t last_garbage_collection_;
-
             bool discard_until_key_frame_ = true;
         };
     }
@@ -1,20 +1,314 @@
 #include "media.hh"
 
+#include "uvgrtp/frame.hh"
+
 #include "../socket.hh"
 #include "../rtp.hh"
 #include "../frame_queue.hh"
 #include "debug.hh"
 
-#include <map>
+#include <cstring>
 #include <unordered_map>
 
 
+// any value less than 30 minutes is ok here, since that is how long it takes to go through all timestamps
+constexpr int TIME_TO_KEEP_TRACK_OF_PREVIOUS_FRAMES_MS = 5000;
+
+/* Slot of timestamp "ts" in the list of finished frames. Timestamps usually advance by a fixed step,
+ * so they are hashed to spread them over the list */
+static inline size_t finished_slot(uint32_t ts)
+{
+    return (size_t)((ts * 2654435761u) >> 24);
+}
+
+void uvgrtp::formats::finished_frames::remember(uint32_t ts, bool dropped, uvgrtp::clock::hrc::hrc_t time)
+{
+    finished_frame& entry = entries_[finished_slot(ts)];
+
+    entry.ts      = ts;
+    entry.valid   = true;
+    entry.dropped = dropped;
+    entry.time    = time;
+}
+
+const uvgrtp::formats::finished_frame *uvgrtp::formats::finished_frames::find(uint32_t ts) const
+{
+    const finished_frame& entry = entries_[finished_slot(ts)];
+
+    if (!entry.valid || entry.ts != ts ||
+        uvgrtp::clock::hrc::diff_now(entry.time) > TIME_TO_KEEP_TRACK_OF_PREVIOUS_FRAMES_MS)
+        return nullptr;
+
+    return &entry;
+}
+
+uvgrtp::formats::reassembly::reassembly(const char *name, std::function<void(uint32_t)> on_drop):
+    name_(name),
+    on_drop_(on_drop),
+    frames_(),
+    fragments_(),
+    pending_(),
+    finished_()
+{
+}
+
+uvgrtp::formats::reassembly::~reassembly()
+{
+    for (auto& fragment : fragments_) {
+        if (fragment)
+            (void)uvgrtp::frame::dealloc_frame(fragment);
+    }
+}
+
+size_t uvgrtp::formats::reassembly::window_slot(uint16_t seq) const
+{
+    return seq & (fragments_.size() - 1);
+}
+
+bool uvgrtp::formats::reassembly::is_pending(const pending_frame& pending) const
+{
+    auto it = frames_.find(pending.ts);
+
+    return it != frames_.end() && it->second.sframe_time == pending.time;
+}
+
+bool uvgrtp::formats::reassembly::grow_window()
+{
+    if (fragments_.size() >= FRAGMENT_WINDOW_MAX)
+        return false;
+
+    std::vector<uvgrtp::frame::rtp_frame *> grown(fragments_.size() * 2, nullptr);
+
+    // two fragments in different slots of the old window cannot end up in the same slot of the new one
+    for (auto& fragment : fragments_) {
+        if (fragment)
+            grown[fragment->header.seq & (grown.size() - 1)] = fragment;
+    }
+
+    UVG_LOG_DEBUG("Grew the %s fragment window to %zu fragments", name_, grown.size());
+
+    fragments_.swap(grown);
+    return true;
+}
+
+bool uvgrtp::formats::reassembly::detect_lost_frames(uint16_t seq)
+{
+    if (seq_initialized_ && (int16_t)(seq - highest_seq_) <= 0)
+        return false;
+
+    highest_seq_     = seq;
+    seq_initialized_ = true;
+
+    // frames are started in sequence number order, so the first frame which is still within reach ends the search
+    while (!pending_.empty()) {
+        if (is_pending(pending_.front())) {
+            uint32_t ts = pending_.front().ts;
+            const fragmented_frame& info = frames_.at(ts);
+
+            if ((uint16_t)(highest_seq_ - info.last_seq) <= LOSS_DETECTION_REORDER_DEPTH)
+                break;
+
+            UVG_LOG_WARN("Dropping %s frame with lost fragments. Ts: %lu, last received seq: %u, current seq: %u, received: %zu",
+                name_, ts, info.last_seq, highest_seq_, info.received_count);
+
+            (void)drop_frame(ts);
+        }
+
+        pending_.pop_front();
+    }
+
+    return true;
+}
+
+void uvgrtp::formats::reassembly::garbage_collect(size_t timeout, size_t memory_limit)
+{
+    size_t total_cleaned = 0;
+
+    // the frames at the front have been waiting for the longest
+    while (!pending_.empty()) {
+        if (is_pending(pending_.front())) {
+            uint32_t ts = pending_.front().ts;
+            const fragmented_frame& info = frames_.at(ts);
+
+            if (buffered_ > memory_limit) {
+                UVG_LOG_WARN("%s fragments take more than %zu bytes, dropping the oldest frame. Ts: %lu",
+                    name_, memory_limit, ts);
+            }
+            else if (uvgrtp::clock::hrc::diff_now(info.sframe_time) >= timeout) {
+                UVG_LOG_WARN("Found an old %s frame that has not been completed. Ts: %lu, Seq: %u <-> %u, received: %zu",
+                    name_, ts, info.first_seq, info.last_seq, info.received_count);
+            }
+            else {
+                break;
+            }
+
+            total_cleaned += drop_frame(ts);
+        }
+
+        pending_.pop_front();
+    }
+
+    if (total_cleaned > 0) {
+        UVG_LOG_DEBUG("Garbage collection cleaned %zu bytes!", total_cleaned);
+    }
+}
+
+const uvgrtp::formats::finished_frame *uvgrtp::formats::reassembly::find_finished(uint32_t ts) const
+{
+    return finished_.find(ts);
+}
+
+uvgrtp::formats::fragmented_frame *uvgrtp::formats::reassembly::find(uint32_t ts)
+{
+    auto it = frames_.find(ts);
+
+    return it != frames_.end() ? &it->second : nullptr;
+}
+
+bool uvgrtp::formats::reassembly::is_received(uint32_t ts, uint16_t seq) const
+{
+    uvgrtp::frame::rtp_frame *stored = fragment(seq);
+
+    return stored && stored->header.timestamp == ts;
+}
+
+uvgrtp::formats::fragmented_frame& uvgrtp::formats::reassembly::insert(uvgrtp::frame::rtp_frame *fragment,
+    bool start, bool end)
+{
+    uint32_t ts  = fragment->header.timestamp;
+    uint16_t seq = fragment->header.seq;
+
+    if (fragments_.empty())
+        fragments_.resize(FRAGMENT_WINDOW_MIN, nullptr);
 
-#define INVALID_SEQ 0xffffffff
+    // the slot is taken by a fragment of an unfinished frame, so the window is too small for the reorder depth
+    while (fragments_[window_slot(seq)] && grow_window())
+        ;
+
+    if (fragments_[window_slot(seq)]) {
+        uint32_t old_ts = fragments_[window_slot(seq)]->header.timestamp;
+
+        UVG_LOG_WARN("Found an existing %s fragment with same sequence number %u! Fragment ts: %lu, current ts: %lu",
+            name_, seq, old_ts, ts);
+
+        (void)drop_frame(old_ts);
+    }
+
+    auto it = frames_.find(ts);
+
+    if (it == frames_.end()) {
+        it = frames_.emplace(ts, fragmented_frame()).first;
+
+        it->second.sframe_time = uvgrtp::clock::hrc::now();
+        it->second.first_seq   = seq;
+        it->second.last_seq    = seq;
+
+        pending_.push_back({ ts, it->second.sframe_time });
+    }
+
+    fragmented_frame& info = it->second;
+
+    fragments_[window_slot(seq)] = fragment;
+    buffered_ += fragment->payload_len;
+
+    info.received_count++;
+    info.size += fragment->payload_len;
+
+    if ((int16_t)(seq - info.first_seq) < 0)
+        info.first_seq = seq;
+
+    if ((int16_t)(seq - info.last_seq) > 0)
+        info.last_seq = seq;
+
+    if (start) {
+        info.s_seq          = seq;
+        info.start_received = true;
+    }
+
+    if (end) {
+        info.e_seq        = seq;
+        info.end_received = true;
+    }
+
+    return info;
+}
+
+uvgrtp::frame::rtp_frame *uvgrtp::formats::reassembly::fragment(uint16_t seq) const
+{
+    if (fragments_.empty())
+        return nullptr;
+
+    uvgrtp::frame::rtp_frame *stored = fragments_[window_slot(seq)];
+
+    return (stored && stored->header.seq == seq) ? stored : nullptr;
+}
+
+uvgrtp::frame::rtp_frame *uvgrtp::formats::reassembly::take_fragment(uint16_t seq)
+{
+    uvgrtp::frame::rtp_frame *stored = fragment(seq);
+
+    if (stored) {
+        buffered_ -= stored->payload_len;
+        fragments_[window_slot(seq)] = nullptr;
+    }
+
+    return stored;
+}
+
+void uvgrtp::formats::reassembly::complete_frame(uint32_t ts)
+{
+    auto it = frames_.find(ts);
+    if (it == frames_.end())
+        return;
+
+    finished_.remember(ts, false, it->second.sframe_time);
+    frames_.erase(it);
+}
+
+size_t uvgrtp::formats::reassembly::drop_frame(uint32_t ts)
+{
+    auto it = frames_.find(ts);
+    if (it == frames_.end()) {
+        UVG_LOG_ERROR("Tried to drop a non-existing %s frame", name_);
+        return 0;
+    }
+
+    size_t cleaned = 0;
+    uint16_t next_from_last = it->second.last_seq + 1;
+
+    for (uint16_t seq = it->second.first_seq; seq != next_from_last; ++seq) {
+        uvgrtp::frame::rtp_frame *stored = fragment(seq);
+
+        if (stored && stored->header.timestamp == ts) {
+            cleaned += stored->payload_len;
+            (void)uvgrtp::frame::dealloc_frame(take_fragment(seq));
+        }
+    }
+
+    finished_.remember(ts, true, it->second.sframe_time);
+    frames_.erase(it);
+
+    if (on_drop_)
+        on_drop_(ts);
+
+    return cleaned;
+}
+
+size_t uvgrtp::formats::reassembly::buffered() const
+{
+    return buffered_;
+}
+
+size_t uvgrtp::formats::reassembly::unfinished_frames() const
+{
+    return frames_.size();
+}
 
 uvgrtp::formats::media::media(std::shared_ptr<uvgrtp::socket> socket, std::shared_ptr<uvgrtp::rtp> rtp_ctx, int rce_flags):
     socket_(socket), rtp_ctx_(rtp_ctx), rce_flags_(rce_flags), fqueue_(new uvgrtp::frame_queue(socket, rtp_ctx, rce_flags)), minfo_()
-{}
+{
+    minfo_.rtp_ctx = rtp_ctx;
+}
 
 uvgrtp::formats::media::~media()
 {
@@ -105,8 +399,7 @@ rtp_error_t uvgrtp::formats::media::packet_handler(void *arg, int rce_flags, uvg
     auto minfo   = (uvgrtp::formats::media_frame_info_t *)arg;
     auto frame   = *out;
     uint32_t ts  = frame->header.timestamp;
-    uint32_t seq = frame->header.seq;
-    uint32_t recv  = 0;
+    uint16_t seq = frame->header.seq;
 
     bool fragmentation = (rce_flags & RCE_FRAGMENT_GENERIC);
 
@@ -117,72 +410,56 @@ rtp_error_t uvgrtp::formats::media::packet_handler(void *arg, int rce_flags, uvg
         return RTP_PKT_READY;
     }
 
-    if (minfo->frames.find(ts) != minfo->frames.end()) {
-        minfo->frames[ts].npkts++;
-        minfo->frames[ts].size += frame->payload_len;
-
-        if (seq < minfo->frames[ts].s_seq)
-            minfo->frames[ts].fragments[seq + 0x10000] = frame;
-        else
-            minfo->frames[ts].fragments[seq] = frame;
+    // a frame the stream has moved past can no longer be completed, so it is dropped before its deadline
+    bool in_order = minfo->frames.detect_lost_frames(seq);
 
+    // frames pushed in quick succession may share a timestamp, so only late packets are matched to finished frames
+    if (!in_order && minfo->frames.find_finished(ts)) {
+        UVG_LOG_DEBUG("Received a fragment of a finished generic frame! Timestamp: %lu, seq: %u", ts, seq);
+        (void)uvgrtp::frame::dealloc_frame(frame);
         *out = nullptr;
+        return RTP_GENERIC_ERROR;
+    }
 
+    if (!minfo->frames.find(ts)) {
         if (frame->header.marker)
-        {
-            minfo->frames[ts].e_seq = seq;
-        }
-        else if (seq == minfo->frames[ts].s_seq - 1)
-        {
-            // try to detect if the start seq was ordered wrong
-            minfo->frames[ts].s_seq = seq;
-        }
+            return RTP_PKT_READY; // fragmentation is used, but there was only one packet for this frame
+    } else if (minfo->frames.is_received(ts, seq)) {
+        UVG_LOG_DEBUG("Detected duplicate generic fragment, dropping! Timestamp: %lu, seq: %u", ts, seq);
+        (void)uvgrtp::frame::dealloc_frame(frame);
+        *out = nullptr;
+        return RTP_GENERIC_ERROR;
+    }
 
-        if (minfo->frames[ts].e_seq != INVALID_SEQ && minfo->frames[ts].s_seq != INVALID_SEQ) {
-            if (minfo->frames[ts].s_seq > minfo->frames[ts].e_seq)
-            {
-                recv = UINT16_MAX - minfo->frames[ts].s_seq + minfo->frames[ts].e_seq + (uint32_t)2;
-            }
-            else
-            {
-                recv = minfo->frames[ts].e_seq - minfo->frames[ts].s_seq + (uint32_t)1;
-            }
+    // generic fragments do not mark the first fragment, so the frame starts from the oldest fragment received
+    fragmented_frame& info = minfo->frames.insert(frame, false, frame->header.marker);
+    *out = nullptr;
 
-            if (recv == minfo->frames[ts].npkts) {
-                auto retframe = uvgrtp::frame::alloc_rtp_frame(minfo->frames[ts].size);
-                size_t ptr    = 0;
-
-                std::memcpy(&retframe->header, &frame->header, sizeof(frame->header));
-
-                for (auto& frag : minfo->frames[ts].fragments) {
-                    std::memcpy(
-                        retframe->payload + ptr,
-                        frag.second->payload,
-                        frag.second->payload_len
-                    );
-                    ptr += frag.second->payload_len;
-                    (void)uvgrtp::frame::dealloc_frame(frag.second);
-                }
-
-                minfo->frames.erase(ts);
-                (void)uvgrtp::frame::dealloc_frame(*out);
-                *out = retframe;
-                return RTP_PKT_READY;
-            }
-        }
-    } else {
-        if (!(frame->header.marker)) {
-            minfo->frames[ts].npkts          = 1;
-            minfo->frames[ts].s_seq          = seq;
-            minfo->frames[ts].e_seq          = INVALID_SEQ;
-            minfo->frames[ts].fragments[seq] = frame;
-            minfo->frames[ts].size           = frame->payload_len;
-            *out                             = nullptr;
-        } else {
-            return RTP_PKT_READY; // fragmentation is used, but there was only one packet for this frame
+    if (info.end_received && info.received_count == (size_t)(uint16_t)(info.e_seq - info.first_seq) + 1) {
+        auto retframe = uvgrtp::frame::alloc_rtp_frame(info.size);
+        size_t ptr    = 0;
+
+        std::memcpy(&retframe->header, &frame->header, sizeof(frame->header));
+        retframe->arrival_ntp = frame->arrival_ntp;
+
+        uint16_t next_from_last = info.e_seq + 1;
+        for (uint16_t i = info.first_seq; i != next_from_last; ++i) {
+            uvgrtp::frame::rtp_frame *fragment = minfo->frames.take_fragment(i);
+
+            std::memcpy(retframe->payload + ptr, fragment->payload, fragment->payload_len);
+            ptr += fragment->payload_len;
+
+            (void)uvgrtp::frame::dealloc_frame(fragment);
         }
+
+        minfo->frames.complete_frame(ts);
+
+        *out = retframe;
+        return RTP_PKT_READY;
     }
 
+    // make sure uvgRTP does not reserve increasing amounts of memory because some frames are not completed
+    minfo->frames.garbage_collect(minfo->rtp_ctx->get_pkt_max_delay(), minfo->rtp_ctx->get_reassembly_limit());
     return RTP_OK;
 }
 
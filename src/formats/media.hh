@@ -1,11 +1,14 @@
 #pragma once
 
 #include "uvgrtp/util.hh"
+#include "uvgrtp/clock.hh"
 
-#include <map>
+#include <array>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 namespace uvgrtp {
 
@@ -21,20 +24,165 @@ namespace uvgrtp {
 
         #define INVALID_TS            0xffffffff
 
-        /* TODO: This functionality has much in common with h26x fragmentation and 
-         * they could use same structures */ 
+        /* Reassembly of fragmented frames (H26x and RCE_FRAGMENT_GENERIC) */
 
-        typedef struct media_info {
-            uint32_t s_seq = 0;
-            uint32_t e_seq = 0;
-            size_t npkts = 0;
+        // initial size of the fragment window, enough for frames of about 1.4 MB with the default MTU.
+        // The window grows up to the whole sequence number space if more fragments are in flight
+        constexpr size_t FRAGMENT_WINDOW_MIN = 1024;
+        constexpr size_t FRAGMENT_WINDOW_MAX = UINT16_MAX + 1;
+
+        static_assert((FRAGMENT_WINDOW_MIN & (FRAGMENT_WINDOW_MIN - 1)) == 0, "The fragment window must be a power of two");
+
+        // an unfinished frame is considered lost once the stream has moved this many packets past its newest fragment
+        constexpr uint16_t LOSS_DETECTION_REORDER_DEPTH = 64;
+
+        /* An unfinished frame in the order the frames were started. The frame is identified by both
+         * the timestamp and the start time, since the timestamp may be reused after the frame is finished */
+        struct pending_frame {
+            uint32_t ts = 0;
+            uvgrtp::clock::hrc::hrc_t time;
+        };
+
+        /* A frame that has been completed or dropped, remembered so that its late fragments are not accepted */
+        struct finished_frame {
+            uint32_t ts = 0;
+            bool valid = false;
+            bool dropped = false;
+            uvgrtp::clock::hrc::hrc_t time;
+        };
+
+        /* Recently completed or dropped frames. Indexed by a hash of the timestamp,
+         * a newer frame replaces an older one with the same hash */
+        class finished_frames {
+            public:
+                /* Remember that the frame "ts" which was started at "time" was completed or dropped */
+                void remember(uint32_t ts, bool dropped, uvgrtp::clock::hrc::hrc_t time);
+
+                /* Return nullptr if frame "ts" has not been completed or dropped recently */
+                const finished_frame *find(uint32_t ts) const;
+
+            private:
+                std::array<finished_frame, 256> entries_;
+        };
+
+        /* A fragmented frame waiting for the rest of its fragments */
+        struct fragmented_frame {
+            /* clock reading when the first fragment is received */
+            uvgrtp::clock::hrc::hrc_t sframe_time;
+
+            /* oldest and newest sequence number received for this frame */
+            uint16_t first_seq = 0;
+            uint16_t last_seq = 0;
+
+            /* sequence number of the first fragment, if the format marks it */
+            uint16_t s_seq = 0;
+            bool start_received = false;
+
+            /* sequence number of the last fragment */
+            uint16_t e_seq = 0;
+            bool end_received = false;
+
+            size_t received_count = 0;
+
+            /* payload bytes of the received fragments */
             size_t size = 0;
-            std::map<uint32_t, uvgrtp::frame::rtp_frame *> fragments;
-        } media_info_t;
+        };
+
+        /* Fragments of unfinished frames and the bookkeeping needed to notice when a frame can no longer
+         * be completed. Shared by the H26x and the generic (RCE_FRAGMENT_GENERIC) reassembly.
+         *
+         * The fragment window is allocated when the first fragment is stored, so streams which
+         * never receive fragmented frames do not reserve memory for it */
+        class reassembly {
+            public:
+                /* "name" identifies the format in log messages. "on_drop" is called with the timestamp
+                 * of every frame that is dropped before it is completed */
+                reassembly(const char *name, std::function<void(uint32_t)> on_drop = nullptr);
+                ~reassembly();
+
+                reassembly(const reassembly&) = delete;
+                reassembly& operator=(const reassembly&) = delete;
+
+                /* Update the newest sequence number of the stream with "seq" and drop the unfinished frames
+                 * that the stream has moved past by more than the reorder depth. The missing fragments of these
+                 * frames would have to be reordered further than any packet is expected to be.
+                 *
+                 * Return false if "seq" is a reordered or duplicate packet which did not move the stream forward */
+                bool detect_lost_frames(uint16_t seq);
+
+                /* Drop the oldest frames while they have been waiting for at least "timeout" milliseconds
+                 * or while the fragments take more than "memory_limit" bytes */
+                void garbage_collect(size_t timeout, size_t memory_limit);
+
+                /* Return nullptr if frame "ts" has not been completed or dropped recently */
+                const finished_frame *find_finished(uint32_t ts) const;
+
+                /* Return nullptr if frame "ts" is not waiting for fragments */
+                fragmented_frame *find(uint32_t ts);
+
+                /* Return true if fragment "seq" of the unfinished frame "ts" has been stored */
+                bool is_received(uint32_t ts, uint16_t seq) const;
+
+                /* Store "fragment" and start a new frame if it is the first fragment with its timestamp.
+                 * If the slot of the fragment is taken and the window cannot grow, the frame holding
+                 * the slot is dropped. "start" and "end" tell whether the fragment begins or ends the frame
+                 *
+                 * Return the frame the fragment belongs to */
+                fragmented_frame& insert(uvgrtp::frame::rtp_frame *fragment, bool start, bool end);
+
+                /* Return the stored fragment "seq" or nullptr if it has not been received */
+                uvgrtp::frame::rtp_frame *fragment(uint16_t seq) const;
+
+                /* Remove fragment "seq" from the window and pass its ownership to the caller */
+                uvgrtp::frame::rtp_frame *take_fragment(uint16_t seq);
+
+                /* Forget frame "ts" after its fragments have been taken, so its late fragments are not accepted */
+                void complete_frame(uint32_t ts);
+
+                /* Free the fragments of frame "ts" and forget the frame. Return the number of payload bytes freed */
+                size_t drop_frame(uint32_t ts);
+
+                /* Payload bytes held by the unfinished frames */
+                size_t buffered() const;
+
+                size_t unfinished_frames() const;
+
+            private:
+                size_t window_slot(uint16_t seq) const;
+
+                /* Double the size of the fragment window. Return false if it already covers all sequence numbers */
+                bool grow_window();
+
+                /* Return true if "pending" refers to a frame that is still unfinished */
+                bool is_pending(const pending_frame& pending) const;
+
+                const char *name_;
+                std::function<void(uint32_t)> on_drop_;
+
+                std::unordered_map<uint32_t, fragmented_frame> frames_;
+
+                /* Window of fragments waiting for reassembly, indexed by the sequence number modulo the window size.
+                 * The size is a power of two which grows when the fragments of the unfinished frames do not fit */
+                std::vector<uvgrtp::frame::rtp_frame *> fragments_;
+
+                // unfinished frames in the order they were started, which is also the order they become late in.
+                // Entries of finished frames are removed when they reach the front
+                std::deque<pending_frame> pending_;
+
+                // keep track of frames completed or discarded so we don't accept invalid fragments
+                finished_frames finished_;
+
+                uint16_t highest_seq_ = 0;
+                bool seq_initialized_ = false;
+
+                size_t buffered_ = 0;
+        };
 
         typedef struct media_frame_info {
-            std::unordered_map<uint32_t, media_info> frames;
-            std::unordered_set<uint32_t> dropped;
+            /* unfinished frames of RCE_FRAGMENT_GENERIC, RCC_REASSEMBLY_MEMORY_LIMIT limits their size */
+            reassembly frames{ "generic" };
+
+            std::shared_ptr<uvgrtp::rtp> rtp_ctx;
         } media_frame_info_t;
 
         class media {
@@ -0,0 +1,274 @@
+#include "scl.hh"
+
+#include "debug.hh"
+
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define UVGRTP_SCL_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define UVGRTP_SCL_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* GCC and Clang only allow intrinsics of instruction sets enabled for the function,
+ * MSVC allows all of them everywhere */
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SCL_TARGET(isa)
+#else
+#define SCL_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace {
+
+    /* Scans "data" from "pos" until one of the last bytes that cannot be scanned as a full block
+     * and returns either the position of the first start code or the position where scanning
+     * stopped. The rest of the data is then scanned with scan_scalar() */
+    typedef size_t (*scan_func)(const uint8_t *data, size_t pos, size_t len);
+
+    inline unsigned int count_trailing_zeros(uint64_t value)
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index = 0;
+        _BitScanForward64(&index, value);
+        return (unsigned int)index;
+#else
+        return (unsigned int)__builtin_ctzll(value);
+#endif
+    }
+
+    /* Byte-wise lookup which skips ahead by looking at the last byte of each possible start code.
+     * If it is larger than one, none of the three positions ending at it can start a start code */
+    size_t scan_scalar(const uint8_t *data, size_t pos, size_t len)
+    {
+        while (pos + 3 <= len) {
+            if (data[pos + 2] > 1)
+                pos += 3;
+            else if (data[pos + 1] != 0)
+                pos += 2;
+            else if (data[pos] != 0 || data[pos + 2] != 1)
+                pos += 1;
+            else
+                return pos;
+        }
+
+        return len;
+    }
+
+    /* The SIMD kernels compare the block at "pos" against zero, the block at "pos + 1" against zero
+     * and the block at "pos + 2" against one. A set bit in the combined mask is a start code */
+
+#ifdef UVGRTP_SCL_X86
+    size_t scan_sse2(const uint8_t *data, size_t pos, size_t len)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one  = _mm_set1_epi8(1);
+
+        for (; pos + 16 + 2 <= len; pos += 16) {
+            __m128i v0 = _mm_loadu_si128((const __m128i *)(data + pos));
+            __m128i v1 = _mm_loadu_si128((const __m128i *)(data + pos + 1));
+            __m128i v2 = _mm_loadu_si128((const __m128i *)(data + pos + 2));
+
+            __m128i match = _mm_and_si128(
+                _mm_and_si128(_mm_cmpeq_epi8(v0, zero), _mm_cmpeq_epi8(v1, zero)),
+                _mm_cmpeq_epi8(v2, one)
+            );
+
+            unsigned int mask = (unsigned int)_mm_movemask_epi8(match);
+            if (mask)
+                return pos + count_trailing_zeros(mask);
+        }
+
+        return pos;
+    }
+
+    SCL_TARGET("avx2")
+    size_t scan_avx2(const uint8_t *data, size_t pos, size_t len)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one  = _mm256_set1_epi8(1);
+
+        for (; pos + 32 + 2 <= len; pos += 32) {
+            __m256i v0 = _mm256_loadu_si256((const __m256i *)(data + pos));
+            __m256i v1 = _mm256_loadu_si256((const __m256i *)(data + pos + 1));
+            __m256i v2 = _mm256_loadu_si256((const __m256i *)(data + pos + 2));
+
+            __m256i match = _mm256_and_si256(
+                _mm256_and_si256(_mm256_cmpeq_epi8(v0, zero), _mm256_cmpeq_epi8(v1, zero)),
+                _mm256_cmpeq_epi8(v2, one)
+            );
+
+            uint32_t mask = (uint32_t)_mm256_movemask_epi8(match);
+            if (mask)
+                return pos + count_trailing_zeros(mask);
+        }
+
+        return pos;
+    }
+
+    SCL_TARGET("avx512f,avx512bw")
+    size_t scan_avx512(const uint8_t *data, size_t pos, size_t len)
+    {
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i one  = _mm512_set1_epi8(1);
+
+        for (; pos + 64 + 2 <= len; pos += 64) {
+            __m512i v0 = _mm512_loadu_si512((const void *)(data + pos));
+            __m512i v1 = _mm512_loadu_si512((const void *)(data + pos + 1));
+            __m512i v2 = _mm512_loadu_si512((const void *)(data + pos + 2));
+
+            __mmask64 mask = _mm512_cmpeq_epi8_mask(v0, zero) &
+                             _mm512_cmpeq_epi8_mask(v1, zero) &
+                             _mm512_cmpeq_epi8_mask(v2, one);
+            if (mask)
+                return pos + count_trailing_zeros((uint64_t)mask);
+        }
+
+        return pos;
+    }
+
+    struct cpu_features {
+        bool avx2   = false;
+        bool avx512 = false;
+    };
+
+    cpu_features detect_cpu_features()
+    {
+        cpu_features features;
+
+#if defined(_MSC_VER) && !defined(__clang__)
+        int regs[4] = { 0 };
+
+        __cpuid(regs, 0);
+        int max_leaf = regs[0];
+
+        __cpuid(regs, 1);
+        bool osxsave = (regs[2] & (1 << 27)) != 0;
+
+        if (!osxsave || max_leaf < 7)
+            return features;
+
+        // the operating system must save the YMM and ZMM registers on context switches
+        unsigned long long xcr0 = _xgetbv(0);
+        bool ymm_enabled = (xcr0 & 0x06) == 0x06;
+        bool zmm_enabled = (xcr0 & 0xe6) == 0xe6;
+
+        __cpuidex(regs, 7, 0);
+        features.avx2   = ymm_enabled && (regs[1] & (1 << 5)) != 0;
+        features.avx512 = zmm_enabled && (regs[1] & (1 << 16)) != 0 && (regs[1] & (1 << 30)) != 0;
+#else
+        __builtin_cpu_init();
+        features.avx2   = __builtin_cpu_supports("avx2");
+        features.avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+
+        return features;
+    }
+#endif
+
+#ifdef UVGRTP_SCL_NEON
+    size_t scan_neon(const uint8_t *data, size_t pos, size_t len)
+    {
+        const uint8x16_t zero = vdupq_n_u8(0);
+        const uint8x16_t one  = vdupq_n_u8(1);
+
+        for (; pos + 16 + 2 <= len; pos += 16) {
+            uint8x16_t v0 = vld1q_u8(data + pos);
+            uint8x16_t v1 = vld1q_u8(data + pos + 1);
+            uint8x16_t v2 = vld1q_u8(data + pos + 2);
+
+            uint8x16_t match = vandq_u8(vandq_u8(vceqq_u8(v0, zero), vceqq_u8(v1, zero)), vceqq_u8(v2, one));
+
+            // narrow each byte of the mask to four bits since NEON has no movemask
+            uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);
+            if (mask)
+                return pos + count_trailing_zeros(mask) / 4;
+        }
+
+        return pos;
+    }
+#endif
+
+    struct scl_kernel {
+        scan_func scan;
+        const char *name;
+    };
+
+    /* Kernels supported by this CPU from the widest to the scalar lookup, which is always last */
+    std::vector<scl_kernel> supported_kernels()
+    {
+        std::vector<scl_kernel> kernels;
+
+#if defined(UVGRTP_SCL_X86)
+        cpu_features features = detect_cpu_features();
+
+        if (features.avx512)
+            kernels.push_back({ scan_avx512, "AVX-512" });
+
+        if (features.avx2)
+            kernels.push_back({ scan_avx2, "AVX2" });
+
+        kernels.push_back({ scan_sse2, "SSE2" });
+#elif defined(UVGRTP_SCL_NEON)
+        kernels.push_back({ scan_neon, "NEON" });
+#endif
+        kernels.push_back({ scan_scalar, "scalar" });
+
+        return kernels;
+    }
+
+    const std::vector<scl_kernel>& get_kernels()
+    {
+        static const std::vector<scl_kernel> kernels = supported_kernels();
+        return kernels;
+    }
+
+    ssize_t find_start_code_with(const scl_kernel& kernel, const uint8_t *data, size_t len,
+                                 size_t offset, uint8_t& start_len)
+    {
+        if (data == nullptr || len < offset || len < 1)
+        {
+            UVG_LOG_WARN("Invalid parameter found for start code lookup");
+            return -1;
+        }
+
+        size_t pos = kernel.scan(data, offset, len);
+        pos = scan_scalar(data, pos, len);
+
+        if (pos + 3 > len)
+            return -1;
+
+        start_len = (pos > offset && data[pos - 1] == 0) ? 4 : 3;
+        return (ssize_t)(pos + 3);
+    }
+}
+
+ssize_t uvgrtp::formats::find_start_code(const uint8_t *data, size_t len, size_t offset, uint8_t& start_len)
+{
+    return find_start_code_with(get_kernels().front(), data, len, offset, start_len);
+}
+
+const char *uvgrtp::formats::start_code_lookup_name()
+{
+    return get_kernels().front().name;
+}
+
+size_t uvgrtp::formats::start_code_lookup_count()
+{
+    return get_kernels().size();
+}
+
+const char *uvgrtp::formats::start_code_lookup_name(size_t kernel)
+{
+    return get_kernels().at(kernel).name;
+}
+
+ssize_t uvgrtp::formats::find_start_code(const uint8_t *data, size_t len, size_t offset, uint8_t& start_len,
+                                         size_t kernel)
+{
+    return find_start_code_with(get_kernels().at(kernel), data, len, offset, start_len);
+}
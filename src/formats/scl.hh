@@ -0,0 +1,37 @@
+#pragma once
+
+#include "uvgrtp/util.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace uvgrtp {
+    namespace formats {
+
+        /* Start Code Lookup (SCL)
+         *
+         * Finds the next H26x start code (0x000001 or 0x00000001) from "data" starting at "offset".
+         * The search uses the widest SIMD instruction set supported by the CPU (AVX-512, AVX2 or SSE2
+         * on x86-64, NEON on ARM) which is selected at runtime when the first lookup is made.
+         * The memory pointed to by "data" is only read, so it may be read-only or shared.
+         *
+         * "start_len" is set to 4 if the start code is preceded by a zero byte at or after "offset"
+         * and to 3 otherwise.
+         *
+         * Return the offset of the first byte after the start code on success
+         * Return -1 if no start code was found */
+        ssize_t find_start_code(const uint8_t *data, size_t len, size_t offset, uint8_t& start_len);
+
+        /* Return the name of the SCL implementation selected for this CPU */
+        const char *start_code_lookup_name();
+
+        /* The implementations supported by this CPU are numbered from the selected one (0)
+         * to the scalar lookup (start_code_lookup_count() - 1). They all give the same results,
+         * these are meant for testing each of them */
+        size_t start_code_lookup_count();
+        const char *start_code_lookup_name(size_t kernel);
+        ssize_t find_start_code(const uint8_t *data, size_t len, size_t offset, uint8_t& start_len, size_t kernel);
+    }
+}
+
+namespace uvg_rtp = uvgrtp;
@@ -2,14 +2,112 @@
 
 #include "uvgrtp/util.hh"
 
+#include "rx_buffer.hh"
+#include "pool.hh"
 #include "debug.hh"
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
 #include <cstring>
+#include <new>
+
+
+// alignment of the buffers of a receive region
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+#ifdef __linux__
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+#endif
+
+namespace {
+
+    inline size_t align_up(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    /* Map "size" bytes, preferably with huge pages to reduce TLB misses when the ring is walked
+     * through during bursts. The memory is prefaulted so that receiving does not cause page faults */
+    uint8_t *map_region(size_t& size, bool& mapped)
+    {
+#ifdef __linux__
+        if (size >= HUGE_PAGE_SIZE) {
+            size_t huge_size = align_up(size, HUGE_PAGE_SIZE);
+            void *mem = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+
+            if (mem != MAP_FAILED) {
+                size   = huge_size;
+                mapped = true;
+                return (uint8_t *)mem;
+            }
+        }
+
+        void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (mem != MAP_FAILED) {
+            // no huge pages reserved, ask for transparent ones before the memory is touched
+#ifdef MADV_HUGEPAGE
+            if (size >= HUGE_PAGE_SIZE)
+                (void)madvise(mem, size, MADV_HUGEPAGE);
+#endif
+            std::memset(mem, 0, size);
+
+            mapped = true;
+            return (uint8_t *)mem;
+        }
+#endif
+        mapped = false;
+        return (uint8_t *)::operator new(size, std::align_val_t(CACHE_LINE_SIZE), std::nothrow);
+    }
+
+    void unmap_region(uint8_t *mem, size_t size, bool mapped)
+    {
+#ifdef __linux__
+        if (mapped) {
+            (void)munmap(mem, size);
+            return;
+        }
+#else
+        (void)size;
+        (void)mapped;
+#endif
+        ::operator delete(mem, std::align_val_t(CACHE_LINE_SIZE));
+    }
+
+    /* rtp_frame with room for the data that parsing a packet may need, allocated from the pool
+     *
+     * The frame records which memory it got from the pool so that dealloc_frame() can tell it apart
+     * from memory that the application has attached to the frame with new[] */
+    struct pooled_frame {
+        uvgrtp::frame::rtp_frame frame;
+        uvgrtp::frame::ext_header ext;
+        uint32_t csrc[15];
+
+        uint8_t *payload  = nullptr;
+        uint8_t *ext_data = nullptr;
+
+        // free bytes in front of frame->payload when the payload was allocated with headroom
+        size_t headroom = 0;
 
+        // fragment frames whose payloads frame->fragments points to
+        uvgrtp::frame::rtp_frame **held = nullptr;
+        size_t held_count = 0;
+    };
+
+    inline pooled_frame *to_pooled(uvgrtp::frame::rtp_frame *frame)
+    {
+        return reinterpret_cast<pooled_frame *>(frame);
+    }
+}
 
 uvgrtp::frame::rtp_frame *uvgrtp::frame::alloc_rtp_frame()
 {
-    uvgrtp::frame::rtp_frame *frame = new uvgrtp::frame::rtp_frame;
+    pooled_frame *pooled = new (uvgrtp::pool::alloc(sizeof(pooled_frame))) pooled_frame();
+    uvgrtp::frame::rtp_frame *frame = &pooled->frame;
 
     frame->header.version   = 0;
     frame->header.padding   = 0;
@@ -33,34 +131,250 @@ uvgrtp::frame::rtp_frame *uvgrtp::frame::alloc_rtp_frame(size_t payload_len)
     if ((frame = uvgrtp::frame::alloc_rtp_frame()) == nullptr)
         return nullptr;
 
-    frame->payload     = new uint8_t[payload_len];
+    uvgrtp::frame::alloc_payload(frame, payload_len);
     frame->payload_len = payload_len;
 
     return frame;
 }
 
+uint8_t *uvgrtp::frame::alloc_payload(uvgrtp::frame::rtp_frame *frame, size_t len, size_t headroom)
+{
+    pooled_frame *pooled = to_pooled(frame);
+
+    pooled->payload  = (uint8_t *)uvgrtp::pool::alloc(len + headroom);
+    pooled->headroom = headroom;
+    frame->payload   = pooled->payload + headroom;
+
+    return frame->payload;
+}
+
+bool uvgrtp::frame::claim_headroom(uvgrtp::frame::rtp_frame *frame, size_t len)
+{
+    pooled_frame *pooled = to_pooled(frame);
+
+    if (!frame->payload || !pooled->payload || frame->payload < pooled->payload + len ||
+        frame->payload > pooled->payload + pooled->headroom)
+        return false;
+
+    frame->payload     -= len;
+    frame->payload_len += len;
+    pooled->headroom    = (size_t)(frame->payload - pooled->payload);
+
+    return true;
+}
+
+uint8_t *uvgrtp::frame::move_payload(uvgrtp::frame::rtp_frame *frame, size_t len, size_t offset)
+{
+    pooled_frame *pooled = to_pooled(frame);
+    uint8_t *payload = (uint8_t *)uvgrtp::pool::alloc(len);
+
+    if (frame->payload)
+        std::memcpy(payload + offset, frame->payload, std::min(frame->payload_len, len - offset));
+
+    uvgrtp::frame::release_payload(frame);
+
+    pooled->payload = payload;
+    frame->payload  = payload;
+
+    return payload;
+}
+
+void uvgrtp::frame::release_payload(uvgrtp::frame::rtp_frame *frame)
+{
+    pooled_frame *pooled = to_pooled(frame);
+
+    /* the payload of a zero-copy frame is owned by the receive buffer */
+    if (frame->payload && pooled->payload && frame->payload >= pooled->payload &&
+        frame->payload <= pooled->payload + pooled->headroom)
+        uvgrtp::pool::release(pooled->payload);
+    else if (frame->payload && !frame->owner)
+        delete[] frame->payload;
+
+    frame->payload   = nullptr;
+    pooled->payload  = nullptr;
+    pooled->headroom = 0;
+}
+
+uvgrtp::frame::payload_fragment *uvgrtp::frame::alloc_fragments(uvgrtp::frame::rtp_frame *frame, size_t count)
+{
+    pooled_frame *pooled = to_pooled(frame);
+
+    frame->fragments      = (uvgrtp::frame::payload_fragment *)uvgrtp::pool::alloc(count * sizeof(uvgrtp::frame::payload_fragment));
+    frame->fragment_count = count;
+
+    pooled->held       = (uvgrtp::frame::rtp_frame **)uvgrtp::pool::alloc(count * sizeof(uvgrtp::frame::rtp_frame *));
+    pooled->held_count = 0;
+
+    return frame->fragments;
+}
+
+void uvgrtp::frame::hold_fragment(uvgrtp::frame::rtp_frame *frame, uvgrtp::frame::rtp_frame *fragment)
+{
+    pooled_frame *pooled = to_pooled(frame);
+
+    pooled->held[pooled->held_count++] = fragment;
+}
+
+uint32_t *uvgrtp::frame::alloc_csrc(uvgrtp::frame::rtp_frame *frame)
+{
+    return to_pooled(frame)->csrc;
+}
+
+uvgrtp::frame::ext_header *uvgrtp::frame::alloc_ext(uvgrtp::frame::rtp_frame *frame)
+{
+    return &to_pooled(frame)->ext;
+}
+
+uint8_t *uvgrtp::frame::dup_ext_data(uvgrtp::frame::rtp_frame *frame, const void *src, size_t len)
+{
+    pooled_frame *pooled = to_pooled(frame);
+
+    pooled->ext_data = uvgrtp::pool::memdup(src, len);
+
+    return pooled->ext_data;
+}
+
 rtp_error_t uvgrtp::frame::dealloc_frame(uvgrtp::frame::rtp_frame *frame)
 {
     if (!frame)
         return RTP_INVALID_VALUE;
 
-    if (frame->csrc)
+    pooled_frame *pooled = to_pooled(frame);
+
+    if (frame->csrc && frame->csrc != pooled->csrc)
         delete[] frame->csrc;
 
+    /* extension data of a zero-copy frame is owned by the receive buffer */
     if (frame->ext) {
-        delete[] frame->ext->data;
-        delete frame->ext;
+        if (frame->ext->data && frame->ext->data == pooled->ext_data)
+            uvgrtp::pool::release(frame->ext->data);
+        else if (frame->ext->data && !frame->owner)
+            delete[] frame->ext->data;
+
+        if (frame->ext != &pooled->ext)
+            delete frame->ext;
     }
 
-    else if (frame->payload)
-        delete[] frame->payload;
+    uvgrtp::frame::release_payload(frame);
+
+    if (pooled->held) {
+        for (size_t i = 0; i < pooled->held_count; ++i)
+            (void)uvgrtp::frame::dealloc_frame(pooled->held[i]);
+
+        uvgrtp::pool::release(pooled->held);
+        uvgrtp::pool::release(frame->fragments);
+    }
+
+    if (frame->owner)
+        release_rx_buffer(frame->owner);
 
     //UVG_LOG_DEBUG("Deallocating frame, type %u", frame->type);
 
-    delete frame;
+    pooled->~pooled_frame();
+    uvgrtp::pool::release(pooled);
     return RTP_OK;
 }
 
+uvgrtp::frame::rx_buffer *uvgrtp::frame::alloc_rx_buffer(size_t size)
+{
+    uvgrtp::frame::rx_buffer *buffer = new (uvgrtp::pool::alloc(sizeof(uvgrtp::frame::rx_buffer))) uvgrtp::frame::rx_buffer();
+
+    buffer->data = (uint8_t *)uvgrtp::pool::alloc(size);
+    buffer->size = size;
+
+    return buffer;
+}
+
+bool uvgrtp::frame::alloc_rx_region(size_t count, size_t size, std::vector<uvgrtp::frame::rx_buffer *>& buffers)
+{
+    if (count == 0 || size == 0)
+        return false;
+
+    /* The headers of the region and its buffers are at the start of the region
+     * and the memory of the buffers follows them as one dense array */
+    size_t stride       = align_up(size, CACHE_LINE_SIZE);
+    size_t headers_size = align_up((count + 1) * sizeof(uvgrtp::frame::rx_buffer), CACHE_LINE_SIZE);
+    size_t region_size  = headers_size + count * stride;
+    bool mapped         = false;
+
+    uint8_t *mem = map_region(region_size, mapped);
+    if (!mem)
+        return false;
+
+    uvgrtp::frame::rx_buffer *headers = (uvgrtp::frame::rx_buffer *)mem;
+
+    // each buffer of the region holds a reference to it
+    uvgrtp::frame::rx_buffer *region = new (&headers[0]) uvgrtp::frame::rx_buffer();
+    region->data        = mem;
+    region->size        = region_size;
+    region->region_size = region_size;
+    region->mapped      = mapped;
+    region->refs        = (uint32_t)count;
+
+    buffers.clear();
+    buffers.reserve(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        uvgrtp::frame::rx_buffer *buffer = new (&headers[i + 1]) uvgrtp::frame::rx_buffer();
+        buffer->data   = mem + headers_size + i * stride;
+        buffer->size   = size;
+        buffer->parent = region;
+
+        buffers.push_back(buffer);
+    }
+
+    return true;
+}
+
+void uvgrtp::frame::retain_rx_buffer(uvgrtp::frame::rx_buffer *buffer)
+{
+    buffer->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void uvgrtp::frame::release_rx_buffer(uvgrtp::frame::rx_buffer *buffer)
+{
+    if (!buffer || buffer->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    // the header of a region buffer lives in the region which is freed with its last buffer
+    if (buffer->parent) {
+        uvgrtp::frame::release_rx_buffer(buffer->parent);
+    } else if (buffer->region_size) {
+        unmap_region(buffer->data, buffer->region_size, buffer->mapped);
+    } else {
+        uvgrtp::pool::release(buffer->data);
+
+        buffer->~rx_buffer();
+        uvgrtp::pool::release(buffer);
+    }
+}
+
+bool uvgrtp::frame::rx_buffer_unique(const uvgrtp::frame::rx_buffer *buffer)
+{
+    return buffer->refs.load(std::memory_order_acquire) == 1;
+}
+
+void uvgrtp::frame::detach_rx_buffer(uvgrtp::frame::rtp_frame *frame)
+{
+    if (!frame || !frame->owner)
+        return;
+
+    if (frame->ext && frame->ext->data)
+        frame->ext->data = uvgrtp::frame::dup_ext_data(frame, frame->ext->data, frame->ext->len);
+
+    if (frame->payload) {
+        uint8_t *payload = frame->payload;
+        std::memcpy(uvgrtp::frame::alloc_payload(frame, frame->payload_len, uvgrtp::frame::PAYLOAD_HEADROOM),
+            payload, frame->payload_len);
+    }
+
+    frame->dgram      = nullptr;
+    frame->dgram_size = 0;
+
+    release_rx_buffer(frame->owner);
+    frame->owner = nullptr;
+}
+
 void* uvgrtp::frame::alloc_zrtp_frame(size_t size)
 {
     if (size == 0) {
@@ -23,9 +23,9 @@
 
 uvgrtp::frame_queue::frame_queue(std::shared_ptr<uvgrtp::socket> socket, std::shared_ptr<uvgrtp::rtp> rtp, int rce_flags):
     active_(nullptr),
+    free_transactions_(),
     dealloc_hook_(nullptr),
     max_mcount_(MAX_MSG_COUNT),
-    max_ccount_(MAX_CHUNK_COUNT* max_mcount_),
     rtp_(rtp), 
     socket_(socket),
     rce_flags_(rce_flags),
@@ -41,57 +41,95 @@ uvgrtp::frame_queue::~frame_queue()
     {
         (void)deinit_transaction();
     }
-}
 
-rtp_error_t uvgrtp::frame_queue::init_transaction()
-{
-    if (active_)
+    for (auto transaction : free_transactions_)
     {
-        (void)deinit_transaction();
+        delete_transaction(transaction);
     }
+}
 
-    active_      = new transaction_t;
+uvgrtp::transaction_t *uvgrtp::frame_queue::new_transaction()
+{
+    transaction_t *transaction = new transaction_t;
 
-#ifndef _WIN32
-    active_->headers     = new struct mmsghdr[max_mcount_];
-    active_->chunks      = new struct iovec[max_ccount_];
-#else
-    active_->headers     = nullptr;
-    active_->chunks      = nullptr;
-#endif
-    active_->rtp_headers = new uvgrtp::frame::rtp_header[max_mcount_];
+    transaction->rtp_headers = new uvgrtp::frame::rtp_header[max_mcount_];
 
-    switch (rtp_->get_payload()) {
+    if (srtp_authenticates(rce_flags_))
+        transaction->rtp_auth_tags = new uint8_t[srtp_auth_tag_length(rce_flags_) * max_mcount_];
+
+    return transaction;
+}
+
+void uvgrtp::frame_queue::delete_transaction(transaction_t *transaction)
+{
+    if (transaction->rtp_headers)
+        delete[] transaction->rtp_headers;
+
+    if (transaction->rtp_auth_tags)
+        delete[] transaction->rtp_auth_tags;
+
+    for (auto media_headers : transaction->media_headers)
+    {
+        switch (rtp_->get_payload()) {
         case RTP_FORMAT_H264:
-            active_->media_headers = new uvgrtp::formats::h264_headers;
+            delete (uvgrtp::formats::h264_headers*)media_headers;
             break;
 
         case RTP_FORMAT_H265:
-            active_->media_headers = new uvgrtp::formats::h265_headers;
+            delete (uvgrtp::formats::h265_headers*)media_headers;
             break;
 
         case RTP_FORMAT_H266:
-            active_->media_headers = new uvgrtp::formats::h266_headers;
+            delete (uvgrtp::formats::h266_headers*)media_headers;
             break;
 
-
         default:
             break;
+        }
+    }
+
+    delete transaction;
+}
+
+void *uvgrtp::frame_queue::new_media_headers()
+{
+    switch (rtp_->get_payload()) {
+        case RTP_FORMAT_H264:
+            return new uvgrtp::formats::h264_headers;
+
+        case RTP_FORMAT_H265:
+            return new uvgrtp::formats::h265_headers;
+
+        case RTP_FORMAT_H266:
+            return new uvgrtp::formats::h266_headers;
+
+        default:
+            return nullptr;
+    }
+}
+
+rtp_error_t uvgrtp::frame_queue::init_transaction()
+{
+    if (active_)
+    {
+        (void)deinit_transaction();
+    }
+
+    if (!free_transactions_.empty()) {
+        active_ = free_transactions_.back();
+        free_transactions_.pop_back();
+    } else {
+        active_ = new_transaction();
     }
 
-    active_->hdr_ptr     = 0;
-    active_->rtphdr_ptr  = 0;
-    active_->rtpauth_ptr = 0;
+    active_->rtphdr_ptr    = 0;
+    active_->rtpauth_ptr   = 0;
+    active_->media_hdr_ptr = 0;
 
     active_->data_raw     = nullptr;
     active_->data_smart   = nullptr;
     active_->dealloc_hook = dealloc_hook_;
 
-    if (rce_flags_ & RCE_SRTP_AUTHENTICATE_RTP)
-        active_->rtp_auth_tags = new uint8_t[10 * max_mcount_];
-    else
-        active_->rtp_auth_tags = nullptr;
-
     rtp_->fill_header((uint8_t *)&active_->rtp_common);
     active_->buffers.clear();
 
@@ -137,47 +175,21 @@ rtp_error_t uvgrtp::frame_queue::deinit_transaction()
         return RTP_INVALID_VALUE;
     }
 
-    if (active_->headers)
-        delete[] active_->headers;
-
-    if (active_->chunks)
-        delete[] active_->chunks;
-
-    if (active_->rtp_headers)
-        delete[] active_->rtp_headers;
-
-    if (active_->rtp_auth_tags)
-        delete[] active_->rtp_auth_tags;
-
-    active_->headers = nullptr;
-    active_->chunks = nullptr;
-    active_->rtp_headers = nullptr;
-    active_->rtp_auth_tags = nullptr;
-
-    if (active_->media_headers)
-    {
-        switch (rtp_->get_payload()) {
-        case RTP_FORMAT_H264:
-            delete (uvgrtp::formats::h264_headers*)active_->media_headers;
-            active_->media_headers = nullptr;
-            break;
-
-        case RTP_FORMAT_H265:
-            delete (uvgrtp::formats::h265_headers*)active_->media_headers;
-            active_->media_headers = nullptr;
-            break;
-
-        case RTP_FORMAT_H266:
-            delete (uvgrtp::formats::h266_headers*)active_->media_headers;
-            active_->media_headers = nullptr;
-            break;
-
-        default:
-            break;
-        }
+    /* Keep the packet vectors, emptied, so that the next frame does not have to allocate them */
+    for (auto& packet : active_->packets) {
+        packet.clear();
+        active_->spare_packets.push_back(std::move(packet));
     }
+    active_->packets.clear();
+    active_->copies.clear();
+    active_->data_smart = nullptr;
+    active_->data_raw   = nullptr;
+
+    if (free_transactions_.size() < (size_t)MAX_CACHED_TRANSACTIONS)
+        free_transactions_.push_back(active_);
+    else
+        delete_transaction(active_);
 
-    delete active_;
     active_ = nullptr;
 
     return RTP_OK;
@@ -193,7 +205,7 @@ rtp_error_t uvgrtp::frame_queue::enqueue_message(uint8_t *message, size_t messag
 
     /* Create buffer vector where the full packet is constructed
      * and which is then pushed to "active_"'s pkt_vec structure */
-    uvgrtp::buf_vec tmp;
+    uvgrtp::buf_vec tmp = next_packet();
 
     /* update the RTP header at "rtpheaders_ptr_" */
     update_rtp_header();
@@ -231,7 +243,7 @@ rtp_error_t uvgrtp::frame_queue::enqueue_message(buf_vec& buffers)
 
     /* Create buffer vector where the full packet is constructed
      * and which is then pushed to "active_"'s pkt_vec structure */
-    uvgrtp::buf_vec tmp;
+    uvgrtp::buf_vec tmp = next_packet();
 
     /* Push RTP header first and then push all payload buffers */
     tmp.push_back({     sizeof(active_->rtp_headers[active_->rtphdr_ptr]), 
@@ -250,6 +262,8 @@ rtp_error_t uvgrtp::frame_queue::enqueue_message(buf_vec& buffers)
         uint8_t* mem = new uint8_t[total];
         uint8_t* ptr = mem;
 
+        active_->copies.emplace_back(mem);
+
         // copy buffers to a single pointer
         for (auto& buffer : buffers) {
             memcpy(ptr, buffer.second, buffer.first);
@@ -383,7 +397,16 @@ uvgrtp::buf_vec* uvgrtp::frame_queue::get_buffer_vector()
 
 void *uvgrtp::frame_queue::get_media_headers()
 {
-    return active_->media_headers;
+    if (active_->media_hdr_ptr == active_->media_headers.size()) {
+        void *media_headers = new_media_headers();
+
+        if (!media_headers)
+            return nullptr;
+
+        active_->media_headers.push_back(media_headers);
+    }
+
+    return active_->media_headers[active_->media_hdr_ptr++];
 }
 
 uint8_t *uvgrtp::frame_queue::get_active_dataptr()
@@ -406,18 +429,31 @@ void uvgrtp::frame_queue::install_dealloc_hook(void (*dealloc_hook)(void *))
 
 void uvgrtp::frame_queue::enqueue_finalize(uvgrtp::buf_vec& tmp)
 {
-    if (rce_flags_ & RCE_SRTP_AUTHENTICATE_RTP) {
+    if (srtp_authenticates(rce_flags_)) {
+        size_t tag_len = srtp_auth_tag_length(rce_flags_);
+
         tmp.push_back({
-            UVG_AUTH_TAG_LENGTH,
-            (uint8_t*)&active_->rtp_auth_tags[10 * active_->rtpauth_ptr++]
+            tag_len,
+            (uint8_t*)&active_->rtp_auth_tags[tag_len * active_->rtpauth_ptr++]
             });
     }
 
-    active_->packets.push_back(tmp);
+    active_->packets.push_back(std::move(tmp));
     rtp_->inc_sequence();
     rtp_->inc_sent_pkts();
 }
 
+uvgrtp::buf_vec uvgrtp::frame_queue::next_packet()
+{
+    if (active_->spare_packets.empty())
+        return uvgrtp::buf_vec();
+
+    uvgrtp::buf_vec packet = std::move(active_->spare_packets.back());
+    active_->spare_packets.pop_back();
+
+    return packet;
+}
+
 inline void uvgrtp::frame_queue::update_sync_point()
 {
     //UVG_LOG_DEBUG("Updating framerate sync point");
@@ -16,6 +16,9 @@ const int MAX_MSG_COUNT   = 5000;
 const int MAX_QUEUED_MSGS =  10;
 const int MAX_CHUNK_COUNT =   4;
 
+// how many released transactions a frame queue keeps for reuse
+const int MAX_CACHED_TRANSACTIONS = 2;
+
 namespace uvgrtp {
     class rtp;
 
@@ -38,28 +41,28 @@ namespace uvgrtp {
         uvgrtp::frame::rtp_header rtp_common;
         uvgrtp::frame::rtp_header *rtp_headers = nullptr;
 
-#ifndef _WIN32
-        struct mmsghdr *headers = nullptr;
-        struct iovec   *chunks = nullptr;
-#else
-        char *headers = nullptr;
-        char *chunks = nullptr;
-#endif
-
-        /* Media may need space for additional buffers,
-         * this pointer is initialized with uvgrtp::MEDIA_TYPE::media_headers
-         * when the transaction is initialized for the first time
+        /* Media may need space for additional buffers, these point to uvgrtp::MEDIA_TYPE::media_headers
+         * structures. Each fragmented NAL unit of a frame uses its own structure, since the packets
+         * of all NAL units point to their headers until the frame has been sent.
+         * The structures are allocated when needed for the first time and kept with the transaction
          *
-         * See src/formats/hevc.hh for example */
-        void *media_headers = nullptr;
+         * See src/formats/h265.hh for example */
+        std::vector<void *> media_headers;
+        size_t media_hdr_ptr = 0;
 
         /* Pointer to RTP authentication (if enabled) */
         uint8_t *rtp_auth_tags = nullptr;
 
-        size_t hdr_ptr = 0;
         size_t rtphdr_ptr = 0;
         size_t rtpauth_ptr = 0;
 
+        /* Packets of earlier frames sent with this transaction. They are kept empty
+         * so that the memory of the buffer vectors can be reused for the next frame */
+        std::vector<uvgrtp::buf_vec> spare_packets;
+
+        /* Copies of messages made for SRTP encryption, freed when the transaction is released */
+        std::vector<std::unique_ptr<uint8_t[]>> copies;
+
         /* The flag "RTP_COPY" means that uvgRTP has a made a copy of the original chunk 
          * and it can be safely freed */
         std::unique_ptr<uint8_t[]> data_smart;
@@ -80,7 +83,7 @@ namespace uvgrtp {
             rtp_error_t init_transaction(uint8_t *data);
             rtp_error_t init_transaction(std::unique_ptr<uint8_t[]> data);
 
-            /* Releases all memory associated with transaction
+            /* Releases the active transaction. Its memory is kept for the following frames
              *
              * Return RTP_OK on success
              * Return RTP_INVALID_VALUE if "key" doesn't point to valid transaction */
@@ -115,11 +118,11 @@ namespace uvgrtp {
              * buf_vec is the place to store these extra headers (see src/formats/hevc.cc) */
             uvgrtp::buf_vec* get_buffer_vector();
 
-            /* Each media may allocate extra buffers for the transaction struct if need be
-             *
+            /* Each media may allocate extra buffers for the transaction struct if need be.
+             * Every call returns a different structure for the rest of the transaction
              *
-             * Return pointer to media headers if they're set
-             * Return nullptr if they're not set */
+             * Return pointer to media headers if the media has them
+             * Return nullptr if it doesn't */
             void *get_media_headers();
 
             /* Update the active task's current packet's sequence number */
@@ -160,17 +163,30 @@ namespace uvgrtp {
 
             void enqueue_finalize(uvgrtp::buf_vec& tmp);
 
+            /* Return an empty buffer vector for the next packet of the active transaction */
+            uvgrtp::buf_vec next_packet();
+
+            /* Allocate a transaction with room for "max_mcount_" packets */
+            transaction_t *new_transaction();
+            void delete_transaction(transaction_t *transaction);
+
+            /* Allocate the media headers structure of the payload format */
+            void *new_media_headers();
+
             inline std::chrono::high_resolution_clock::time_point this_frame_time();
 
             inline void update_sync_point();
 
             transaction_t *active_;
 
+            /* Transactions are expensive to allocate so released transactions are
+             * reset and reused for the following frames instead of being freed */
+            std::vector<transaction_t *> free_transactions_;
+
             /* Deallocation hook is stored here and copied to transaction upon initialization */
             void (*dealloc_hook_)(void *);
 
             ssize_t max_mcount_; /* number of messages per transactions */
-            ssize_t max_ccount_; /* number of chunks per message */
 
             std::shared_ptr<uvgrtp::rtp> rtp_;
             std::shared_ptr<uvgrtp::socket> socket_;
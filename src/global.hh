@@ -20,5 +20,7 @@ namespace uvgrtp {
     constexpr uint16_t MAX_IPV6_MEDIA_PAYLOAD = MAX_IPV6_PAYLOAD - RTP_HDR_SIZE;
 
     constexpr int PKT_MAX_DELAY_MS = 500;
+
+    constexpr size_t REASSEMBLY_MEMORY_LIMIT = 64 * 1024 * 1024;
 }
 
@@ -3,15 +3,20 @@
 #include "uvgrtp/clock.hh"
 
 #include "socket.hh"
+#include "reactor.hh"
 #include "debug.hh"
 
 
 #define THRESHOLD 2000
+#define CHECK_INTERVAL_MS 500
 
 uvgrtp::holepuncher::holepuncher(std::shared_ptr<uvgrtp::socket> socket):
     socket_(socket),
     last_dgram_sent_(0),
-    active_(false)
+    active_(false),
+    runner_(nullptr),
+    reactor_(nullptr),
+    reactor_key_(0)
 {}
 
 uvgrtp::holepuncher::~holepuncher()
@@ -19,9 +24,26 @@ uvgrtp::holepuncher::~holepuncher()
     stop();
 }
 
-rtp_error_t uvgrtp::holepuncher::start()
+rtp_error_t uvgrtp::holepuncher::start(std::shared_ptr<uvgrtp::reactor> reactor)
 {
     active_ = true;
+
+    if (reactor)
+    {
+        reactor_key_ = reactor->add_timer(CHECK_INTERVAL_MS, CHECK_INTERVAL_MS, [this]() {
+            send_if_idle();
+            return RTP_OK;
+        });
+
+        if (reactor_key_)
+        {
+            reactor_ = reactor;
+            return RTP_OK;
+        }
+
+        UVG_LOG_WARN("Failed to register the holepuncher to the reactor, creating a thread instead");
+    }
+
     runner_ = std::unique_ptr<std::thread> (new std::thread(&uvgrtp::holepuncher::keepalive, this));
     return RTP_OK;
 }
@@ -33,6 +55,12 @@ rtp_error_t uvgrtp::holepuncher::stop()
     {
         runner_->join();
     }
+
+    if (reactor_key_)
+    {
+        reactor_->remove_source(reactor_key_);
+        reactor_key_ = 0;
+    }
     return RTP_OK;
 }
 
@@ -48,14 +76,22 @@ void uvgrtp::holepuncher::keepalive()
     // TODO: Make this follow https://datatracker.ietf.org/doc/html/rfc6263
     while (active_) {
         if (uvgrtp::clock::ntp::diff_now(last_dgram_sent_) < THRESHOLD) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            std::this_thread::sleep_for(std::chrono::milliseconds(CHECK_INTERVAL_MS));
             continue;
         }
 
-        UVG_LOG_DEBUG("Sending keep-alive");
-        uint8_t payload = 0x00;
-        socket_->sendto(&payload, 1, 0);
-        last_dgram_sent_ = uvgrtp::clock::ntp::now();
+        send_if_idle();
     }
     UVG_LOG_DEBUG("Stopping holepuncher");
 }
+
+void uvgrtp::holepuncher::send_if_idle()
+{
+    if (uvgrtp::clock::ntp::diff_now(last_dgram_sent_) < THRESHOLD)
+        return;
+
+    UVG_LOG_DEBUG("Sending keep-alive");
+    uint8_t payload = 0x00;
+    socket_->sendto(&payload, 1, 0);
+    last_dgram_sent_ = uvgrtp::clock::ntp::now();
+}
@@ -9,17 +9,19 @@
 namespace uvgrtp {
 
     class socket;
+    class reactor;
 
     class holepuncher {
         public:
             holepuncher(std::shared_ptr<uvgrtp::socket> socket);
             ~holepuncher();
 
-            /* Create new thread object and start the holepuncher
+            /* Create new thread object and start the holepuncher. If "reactor" is given,
+             * the keep-alive timer is run by its I/O threads instead
              *
              * Return RTP_OK on success
              * Return RTP_MEMORY_ERROR if allocation fails */
-            rtp_error_t start();
+            rtp_error_t start(std::shared_ptr<uvgrtp::reactor> reactor = nullptr);
 
             /* Stop the holepuncher */
             rtp_error_t stop();
@@ -31,11 +33,17 @@ namespace uvgrtp {
         private:
             void keepalive();
 
+            /* Send a keep-alive datagram if nothing has been sent for a while */
+            void send_if_idle();
+
             std::shared_ptr<uvgrtp::socket> socket_;
             std::atomic<uint64_t> last_dgram_sent_;
 
             bool active_;
             std::unique_ptr<std::thread> runner_;
+
+            std::shared_ptr<uvgrtp::reactor> reactor_;
+            uint64_t reactor_key_;
     };
 }
 
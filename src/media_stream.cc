@@ -23,7 +23,7 @@
 
 uvgrtp::media_stream::media_stream(std::string cname, std::string remote_addr, 
     std::string local_addr, uint16_t src_port, uint16_t dst_port, rtp_format_t fmt, 
-    int rce_flags):
+    int rce_flags, std::shared_ptr<uvgrtp::reactor> reactor):
     key_(uvgrtp::random::generate_32()),
     srtp_(nullptr),
     srtcp_(nullptr),
@@ -41,6 +41,7 @@ uvgrtp::media_stream::media_stream(std::string cname, std::string remote_addr,
     rtp_handler_key_(0),
     zrtp_handler_key_(0),
     reception_flow_(nullptr),
+    reactor_(reactor),
     media_(nullptr),
     holepuncher_(std::unique_ptr<uvgrtp::holepuncher>(new uvgrtp::holepuncher(socket_))),
     cname_(cname),
@@ -251,7 +252,7 @@ rtp_error_t uvgrtp::media_stream::init()
         return free_resources(RTP_GENERIC_ERROR);
     }
 
-    reception_flow_ = std::unique_ptr<uvgrtp::reception_flow> (new uvgrtp::reception_flow());
+    reception_flow_ = std::unique_ptr<uvgrtp::reception_flow> (new uvgrtp::reception_flow(reactor_));
 
     rtp_ = std::shared_ptr<uvgrtp::rtp> (new uvgrtp::rtp(fmt_, ssrc_));
     rtcp_ = std::shared_ptr<uvgrtp::rtcp> (new uvgrtp::rtcp(rtp_, ssrc_, cname_, rce_flags_));
@@ -271,7 +272,7 @@ rtp_error_t uvgrtp::media_stream::init(std::shared_ptr<uvgrtp::zrtp> zrtp)
         return RTP_GENERIC_ERROR;
     }
 
-    reception_flow_ = std::unique_ptr<uvgrtp::reception_flow> (new uvgrtp::reception_flow());
+    reception_flow_ = std::unique_ptr<uvgrtp::reception_flow> (new uvgrtp::reception_flow(reactor_));
 
     rtp_ = std::shared_ptr<uvgrtp::rtp> (new uvgrtp::rtp(fmt_, ssrc_));
 
@@ -312,7 +313,8 @@ rtp_error_t uvgrtp::media_stream::init(std::shared_ptr<uvgrtp::zrtp> zrtp)
     rtcp_ = std::shared_ptr<uvgrtp::rtcp> (new uvgrtp::rtcp(rtp_, ssrc_, cname_, srtcp_, rce_flags_));
 
     socket_->install_handler(rtcp_.get(), rtcp_->send_packet_handler_vec);
-    socket_->install_handler(srtp_.get(), srtp_->send_packet_handler);
+    socket_->install_handler(srtp_.get(), srtp_->send_packet_handler,
+        srtp_->send_prepare_handler, srtp_->send_batch_handler);
 
     rtp_handler_key_  = reception_flow_->install_handler(rtp_->packet_handler);
     zrtp_handler_key_ = reception_flow_->install_handler(zrtp->packet_handler);
@@ -339,7 +341,7 @@ rtp_error_t uvgrtp::media_stream::add_srtp_ctx(uint8_t *key, uint8_t *salt)
     if ((rce_flags_ & srtp_rce_flags) != srtp_rce_flags)
         return free_resources(RTP_NOT_SUPPORTED);
 
-    reception_flow_ = std::unique_ptr<uvgrtp::reception_flow> (new uvgrtp::reception_flow());
+    reception_flow_ = std::unique_ptr<uvgrtp::reception_flow> (new uvgrtp::reception_flow(reactor_));
 
     rtp_ = std::shared_ptr<uvgrtp::rtp> (new uvgrtp::rtp(fmt_, ssrc_));
 
@@ -361,7 +363,8 @@ rtp_error_t uvgrtp::media_stream::add_srtp_ctx(uint8_t *key, uint8_t *salt)
     rtcp_ = std::shared_ptr<uvgrtp::rtcp> (new uvgrtp::rtcp(rtp_, ssrc_, cname_, srtcp_, rce_flags_));
 
     socket_->install_handler(rtcp_.get(), rtcp_->send_packet_handler_vec);
-    socket_->install_handler(srtp_.get(), srtp_->send_packet_handler);
+    socket_->install_handler(srtp_.get(), srtp_->send_packet_handler,
+        srtp_->send_prepare_handler, srtp_->send_batch_handler);
 
     rtp_handler_key_ = reception_flow_->install_handler(rtp_->packet_handler);
 
@@ -377,7 +380,7 @@ rtp_error_t uvgrtp::media_stream::start_components()
         return free_resources(RTP_MEMORY_ERROR);
 
     if (rce_flags_ & RCE_HOLEPUNCH_KEEPALIVE) {
-        holepuncher_->start();
+        holepuncher_->start(reactor_);
     }
 
     if (rce_flags_ & RCE_RTCP) {
@@ -392,12 +395,12 @@ rtp_error_t uvgrtp::media_stream::start_components()
         {
             rtcp_->add_participant(local_address_, remote_address_, src_port_ + 1, dst_port_ + 1, rtp_->get_clock_rate());
             rtcp_->set_session_bandwidth(get_default_bandwidth_kbps(fmt_));
-            rtcp_->start();
+            rtcp_->start(reactor_);
         }
     }
 
-    if (rce_flags_ & RCE_SRTP_AUTHENTICATE_RTP)
-        rtp_->set_payload_size(MAX_IPV4_MEDIA_PAYLOAD - UVG_AUTH_TAG_LENGTH);
+    if (srtp_authenticates(rce_flags_))
+        rtp_->set_payload_size(MAX_IPV4_MEDIA_PAYLOAD - srtp_auth_tag_length(rce_flags_));
 
     initialized_ = true;
     return reception_flow_->start(socket_, rce_flags_);
@@ -600,6 +603,28 @@ rtp_error_t uvgrtp::media_stream::configure_ctx(int rcc_flag, ssize_t value)
             rtp_->set_pkt_max_delay(value);
             break;
         }
+        case RCC_REASSEMBLY_MEMORY_LIMIT: {
+            if (value <= 0)
+                return RTP_INVALID_VALUE;
+
+            rtp_->set_reassembly_limit((size_t)value);
+            break;
+        }
+        case RCC_SRTP_REPLAY_WINDOW: {
+            if (!srtp_ || !srtcp_ || value <= 0)
+                return RTP_INVALID_VALUE;
+
+            if ((ret = srtp_->set_replay_window((size_t)value)) == RTP_OK)
+                ret = srtcp_->set_replay_window((size_t)value);
+            break;
+        }
+        case RCC_SRTP_KEYSTREAM_PACKETS: {
+            if (!srtp_ || value < 0)
+                return RTP_INVALID_VALUE;
+
+            ret = srtp_->set_keystream_packets((size_t)value, rtp_->get_payload_size());
+            break;
+        }
         case RCC_DYN_PAYLOAD_TYPE: {
             if (value <= 0 || (ssize_t)UINT8_MAX < value)
                 return RTP_INVALID_VALUE;
@@ -616,8 +641,8 @@ rtp_error_t uvgrtp::media_stream::configure_ctx(int rcc_flag, ssize_t value)
         }
         case RCC_MTU_SIZE: {
             ssize_t hdr      = IPV4_HDR_SIZE + UDP_HDR_SIZE + RTP_HDR_SIZE;
-            if (rce_flags_ & RCE_SRTP_AUTHENTICATE_RTP)
-                hdr += UVG_AUTH_TAG_LENGTH;
+            if (srtp_authenticates(rce_flags_))
+                hdr += srtp_auth_tag_length(rce_flags_);
 
             if (value <= hdr)
                 return RTP_INVALID_VALUE;
@@ -663,6 +688,17 @@ rtp_error_t uvgrtp::media_stream::configure_ctx(int rcc_flag, ssize_t value)
             *ssrc_ = (uint32_t)value;
             break;
         }
+        case RCC_FRAME_QUEUE_SIZE: {
+            if (value <= 0)
+                return RTP_INVALID_VALUE;
+
+            ret = reception_flow_->set_frame_queue_size((size_t)value);
+            break;
+        }
+        case RCC_FRAME_QUEUE_POLICY: {
+            ret = reception_flow_->set_frame_queue_policy((int)value);
+            break;
+        }
         default:
             return RTP_INVALID_VALUE;
     }
@@ -0,0 +1,219 @@
+#include "pool.hh"
+
+#include <cassert>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// the smallest size class is 64 bytes and each class doubles the size, up to 64 KB
+constexpr size_t MIN_CLASS_SHIFT = 6;
+constexpr size_t NUM_SIZE_CLASSES = 11;
+
+// the size class of blocks that are too large for the pool and come from the heap
+constexpr uint32_t HEAP_CLASS = 0xff;
+constexpr uint32_t BLOCK_MAGIC = 0x75767062;
+
+// how many free blocks a thread keeps per size class before moving half of them to the depot
+constexpr size_t THREAD_CACHE_SIZE = 64;
+
+// the depot frees blocks instead of caching them once it holds this much memory per size class
+constexpr size_t MAX_DEPOT_BYTES = 8 * 1024 * 1024;
+
+namespace {
+
+    /* Placed in front of every block. 16 bytes keeps the memory given to the caller aligned */
+    struct block_header {
+        uint32_t size_class;
+        uint32_t magic;
+        uint64_t reserved;
+    };
+
+    static_assert(sizeof(block_header) == 16, "block header must keep 16-byte alignment");
+
+    inline size_t class_size(size_t size_class)
+    {
+        return (size_t)1 << (size_class + MIN_CLASS_SHIFT);
+    }
+
+    inline uint32_t size_to_class(size_t size)
+    {
+        uint32_t size_class = 0;
+
+        while (size_class < NUM_SIZE_CLASSES && class_size(size_class) < size)
+            ++size_class;
+
+        return size_class < NUM_SIZE_CLASSES ? size_class : HEAP_CLASS;
+    }
+
+    inline block_header *new_block(uint32_t size_class, size_t size)
+    {
+        block_header *block = (block_header *)::operator new(sizeof(block_header) + size);
+
+        block->size_class = size_class;
+        block->magic      = BLOCK_MAGIC;
+        block->reserved   = 0;
+
+        return block;
+    }
+
+    inline void delete_block(block_header *block)
+    {
+        ::operator delete(block);
+    }
+
+    /* Free blocks shared by all threads */
+    class depot {
+        public:
+            ~depot()
+            {
+                for (auto& blocks : free_) {
+                    for (auto block : blocks)
+                        delete_block(block);
+                }
+            }
+
+            /* Move up to "count" blocks of "size_class" to "out" */
+            void take(uint32_t size_class, std::vector<block_header *>& out, size_t count)
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                auto& blocks = free_[size_class];
+
+                while (count-- && !blocks.empty()) {
+                    out.push_back(blocks.back());
+                    blocks.pop_back();
+                }
+            }
+
+            /* Take ownership of "count" blocks from the end of "in" */
+            void give(uint32_t size_class, std::vector<block_header *>& in, size_t count)
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                auto& blocks = free_[size_class];
+                size_t max_blocks = MAX_DEPOT_BYTES / class_size(size_class);
+
+                while (count-- && !in.empty()) {
+                    if (blocks.size() < max_blocks)
+                        blocks.push_back(in.back());
+                    else
+                        delete_block(in.back());
+
+                    in.pop_back();
+                }
+            }
+
+        private:
+            std::mutex mtx_;
+            std::vector<block_header *> free_[NUM_SIZE_CLASSES];
+    };
+
+    depot& get_depot()
+    {
+        static depot instance;
+        return instance;
+    }
+
+    /* Memory may still be freed on a thread after its cache has been destroyed, for example
+     * by destructors of static objects, in which case the depot is used directly */
+    thread_local bool cache_destroyed = false;
+
+    /* Free blocks of one thread, given back to the depot when the thread exits */
+    class thread_cache {
+        public:
+            thread_cache()
+            {
+                for (auto& blocks : free_)
+                    blocks.reserve(THREAD_CACHE_SIZE);
+            }
+
+            ~thread_cache()
+            {
+                cache_destroyed = true;
+
+                for (uint32_t i = 0; i < NUM_SIZE_CLASSES; ++i)
+                    get_depot().give(i, free_[i], free_[i].size());
+            }
+
+            block_header *alloc(uint32_t size_class)
+            {
+                auto& blocks = free_[size_class];
+
+                if (blocks.empty())
+                    get_depot().take(size_class, blocks, THREAD_CACHE_SIZE / 2);
+
+                if (blocks.empty())
+                    return new_block(size_class, class_size(size_class));
+
+                block_header *block = blocks.back();
+                blocks.pop_back();
+                return block;
+            }
+
+            void release(block_header *block)
+            {
+                auto& blocks = free_[block->size_class];
+
+                if (blocks.size() >= THREAD_CACHE_SIZE)
+                    get_depot().give(block->size_class, blocks, THREAD_CACHE_SIZE / 2);
+
+                blocks.push_back(block);
+            }
+
+        private:
+            std::vector<block_header *> free_[NUM_SIZE_CLASSES];
+    };
+
+    thread_local thread_cache cache;
+
+    block_header *alloc_block(uint32_t size_class)
+    {
+        if (!cache_destroyed)
+            return cache.alloc(size_class);
+
+        std::vector<block_header *> blocks;
+        get_depot().take(size_class, blocks, 1);
+
+        return blocks.empty() ? new_block(size_class, class_size(size_class)) : blocks.back();
+    }
+
+    void release_block(block_header *block)
+    {
+        if (!cache_destroyed) {
+            cache.release(block);
+            return;
+        }
+
+        std::vector<block_header *> blocks(1, block);
+        get_depot().give(block->size_class, blocks, 1);
+    }
+}
+
+void *uvgrtp::pool::alloc(size_t size)
+{
+    uint32_t size_class = size_to_class(size);
+    block_header *block = (size_class == HEAP_CLASS) ? new_block(HEAP_CLASS, size) : alloc_block(size_class);
+
+    return block + 1;
+}
+
+void uvgrtp::pool::release(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    block_header *block = (block_header *)ptr - 1;
+    assert(block->magic == BLOCK_MAGIC);
+
+    if (block->size_class == HEAP_CLASS)
+        delete_block(block);
+    else
+        release_block(block);
+}
+
+uint8_t *uvgrtp::pool::memdup(const void *src, size_t len)
+{
+    uint8_t *dst = (uint8_t *)uvgrtp::pool::alloc(len);
+    std::memcpy(dst, src, len);
+
+    return dst;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace uvgrtp {
+
+    /* Size-classed memory pool for the receive path
+     *
+     * Received packets, frames and their payloads are allocated and freed at the packet rate,
+     * often on different threads (the processor allocates, the application frees). The pool keeps
+     * freed blocks in power-of-two size classes from 64 bytes to 64 KB so that they can be
+     * reused without going through the global heap.
+     *
+     * Each thread has a small cache of blocks per size class which is used without locking.
+     * When the cache of a thread runs empty or overflows, blocks are moved in batches between it
+     * and a shared depot. Allocations larger than the largest size class go directly to the heap */
+    namespace pool {
+
+        /* Allocate at least "size" bytes. The memory is aligned to 16 bytes.
+         * Like new[], a zero-sized allocation returns a unique pointer */
+        void *alloc(size_t size);
+
+        /* Return memory allocated with alloc() to the pool. Does nothing if "ptr" is nullptr */
+        void release(void *ptr);
+
+        /* Allocate "len" bytes from the pool and copy "src" to it */
+        uint8_t *memdup(const void *src, size_t len);
+    }
+
+    namespace frame {
+        struct rtp_frame;
+        struct ext_header;
+        struct payload_fragment;
+
+        /* Bytes left free in front of received payloads so that an H26x start code
+         * can be prepended without copying the payload again */
+        constexpr size_t PAYLOAD_HEADROOM = 4;
+
+        /* Frames allocated with alloc_rtp_frame() come from the pool and have room for the CSRC list
+         * and the extension header, so parsing a packet does not need separate allocations for them.
+         * Memory given out by these functions is returned to the pool by dealloc_frame() */
+
+        /* Allocate "len" bytes of payload memory for "frame" and set frame->payload to point to it.
+         * "headroom" bytes are left free in front of the payload for claim_headroom() */
+        uint8_t *alloc_payload(rtp_frame *frame, size_t len, size_t headroom = 0);
+
+        /* Grow the payload of "frame" by "len" bytes to the front if it has enough headroom left.
+         * Return false if the payload was not allocated by alloc_payload() with enough headroom */
+        bool claim_headroom(rtp_frame *frame, size_t len);
+
+        /* Replace the payload of "frame" with "len" bytes of memory to which the old payload is copied
+         * at "offset". Return pointer to the new payload */
+        uint8_t *move_payload(rtp_frame *frame, size_t len, size_t offset);
+
+        /* Free the payload of "frame" if the frame owns it and set frame->payload to nullptr */
+        void release_payload(rtp_frame *frame);
+
+        /* Return the storage of "frame" for the maximum of 15 CSRC entries */
+        uint32_t *alloc_csrc(rtp_frame *frame);
+
+        /* Return the storage of "frame" for the extension header */
+        ext_header *alloc_ext(rtp_frame *frame);
+
+        /* Allocate "len" bytes for the extension data of "frame" and copy "src" to it */
+        uint8_t *dup_ext_data(rtp_frame *frame, const void *src, size_t len);
+
+        /* Allocate an array of "count" payload fragments for "frame" and set frame->fragments
+         * and frame->fragment_count. The fragments are filled in by the caller */
+        payload_fragment *alloc_fragments(rtp_frame *frame, size_t count);
+
+        /* Keep "fragment" alive until "frame" is deallocated. At most "count" frames given
+         * to alloc_fragments() can be held */
+        void hold_fragment(rtp_frame *frame, rtp_frame *fragment);
+    }
+}
+
+namespace uvg_rtp = uvgrtp;
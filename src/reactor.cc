@@ -0,0 +1,318 @@
+#include "reactor.hh"
+
+#include "debug.hh"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <errno.h>
+#endif
+
+#include <cstring>
+#include <algorithm>
+
+// how many events one I/O thread handles per epoll_wait()
+constexpr int MAX_REACTOR_EVENTS = 64;
+
+// exits epoll_wait() after this time to check whether the reactor should stop
+constexpr int REACTOR_TIMEOUT_MS = 100;
+
+uvgrtp::reactor::reactor(unsigned int threads):
+    workers_(),
+    should_stop_(true),
+    sources_mtx_(),
+    owners_(),
+    next_key_(1)
+{
+    if (threads == 0)
+    {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        workers_.emplace_back(new worker());
+    }
+}
+
+uvgrtp::reactor::~reactor()
+{
+    stop();
+
+#ifdef __linux__
+    for (auto& w : workers_)
+    {
+        // timers that were never removed
+        for (auto& src : w->sources)
+        {
+            if (src.second.timer)
+            {
+                close(src.second.socket);
+            }
+        }
+
+        if (w->epoll_fd >= 0)
+        {
+            close(w->epoll_fd);
+        }
+    }
+#endif
+}
+
+rtp_error_t uvgrtp::reactor::start()
+{
+#ifdef __linux__
+    for (auto& w : workers_)
+    {
+        if ((w->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+        {
+            log_platform_error("epoll_create1(2) failed");
+            return RTP_GENERIC_ERROR;
+        }
+    }
+
+    should_stop_ = false;
+
+    UVG_LOG_DEBUG("Starting reactor with %zu I/O threads", workers_.size());
+
+    for (auto& w : workers_)
+    {
+        w->thread = std::unique_ptr<std::thread>(new std::thread(&uvgrtp::reactor::run, this, w.get()));
+
+        // the I/O threads replace the receiver threads of the streams, so they get the same priority
+        struct sched_param params;
+        params.sched_priority = sched_get_priority_max(SCHED_FIFO);
+        pthread_setschedparam(w->thread->native_handle(), SCHED_FIFO, &params);
+    }
+
+    return RTP_OK;
+#else
+    UVG_LOG_ERROR("The reactor requires epoll(7) which is not available on this platform");
+    return RTP_NOT_SUPPORTED;
+#endif
+}
+
+void uvgrtp::reactor::stop()
+{
+    should_stop_ = true;
+
+    for (auto& w : workers_)
+    {
+        if (w->thread && w->thread->joinable())
+        {
+            w->thread->join();
+        }
+        w->thread = nullptr;
+    }
+}
+
+size_t uvgrtp::reactor::thread_count() const
+{
+    return workers_.size();
+}
+
+uint64_t uvgrtp::reactor::add_source(socket_t socket, uvgrtp::reactor_callback callback, uint64_t affinity)
+{
+    if (!callback || should_stop_)
+        return 0;
+
+    return register_source(socket, callback, false, affinity);
+}
+
+uint64_t uvgrtp::reactor::add_timer(uint32_t first_ms, uint32_t interval_ms, uvgrtp::reactor_callback callback,
+    uint64_t affinity)
+{
+    if (!callback || should_stop_)
+        return 0;
+
+#ifdef __linux__
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd < 0)
+    {
+        log_platform_error("timerfd_create(2) failed");
+        return 0;
+    }
+
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+
+    // a zero value would disarm the timer
+    spec.it_value.tv_sec     = first_ms / 1000;
+    spec.it_value.tv_nsec    = first_ms ? (long)(first_ms % 1000) * 1000000 : 1;
+    spec.it_interval.tv_sec  = interval_ms / 1000;
+    spec.it_interval.tv_nsec = (long)(interval_ms % 1000) * 1000000;
+
+    if (timerfd_settime(timer_fd, 0, &spec, nullptr) < 0)
+    {
+        log_platform_error("timerfd_settime(2) failed");
+        close(timer_fd);
+        return 0;
+    }
+
+    uint64_t key = register_source(timer_fd, [timer_fd, callback]() {
+        // the number of expirations is not needed, but reading it rearms the readiness
+        uint64_t expirations = 0;
+        if (read(timer_fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+        {
+            log_platform_error("read(2) from a timerfd failed");
+            return RTP_GENERIC_ERROR;
+        }
+
+        return callback();
+    }, true, affinity);
+
+    if (!key)
+    {
+        close(timer_fd);
+    }
+
+    return key;
+#else
+    (void)first_ms;
+    (void)interval_ms;
+    (void)affinity;
+    return 0;
+#endif
+}
+
+uint64_t uvgrtp::reactor::register_source(socket_t socket, uvgrtp::reactor_callback callback, bool timer,
+    uint64_t affinity)
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lk(sources_mtx_);
+
+    worker *owner = nullptr;
+
+    auto related = owners_.find(affinity);
+    if (affinity && related != owners_.end())
+    {
+        owner = related->second;
+    }
+    else
+    {
+        // give the new source to the least loaded thread
+        size_t fewest_sources = 0;
+
+        for (auto& w : workers_)
+        {
+            std::lock_guard<std::mutex> dispatch_lk(w->dispatch_mtx);
+            if (!owner || w->sources.size() < fewest_sources)
+            {
+                owner = w.get();
+                fewest_sources = w->sources.size();
+            }
+        }
+    }
+
+    uint64_t key = next_key_++;
+
+    std::lock_guard<std::mutex> dispatch_lk(owner->dispatch_mtx);
+    owner->sources[key] = {socket, callback, timer};
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = key;
+
+    if (epoll_ctl(owner->epoll_fd, EPOLL_CTL_ADD, socket, &event) < 0)
+    {
+        log_platform_error("epoll_ctl(2) failed");
+        owner->sources.erase(key);
+        return 0;
+    }
+
+    owners_[key] = owner;
+    return key;
+#else
+    (void)socket;
+    (void)callback;
+    (void)timer;
+    (void)affinity;
+    return 0;
+#endif
+}
+
+void uvgrtp::reactor::close_source(worker *w, std::unordered_map<uint64_t, source>::iterator src)
+{
+#ifdef __linux__
+    (void)epoll_ctl(w->epoll_fd, EPOLL_CTL_DEL, src->second.socket, nullptr);
+
+    if (src->second.timer)
+    {
+        close(src->second.socket);
+    }
+
+    w->sources.erase(src);
+#else
+    (void)w;
+    (void)src;
+#endif
+}
+
+void uvgrtp::reactor::remove_source(uint64_t key)
+{
+#ifdef __linux__
+    std::lock_guard<std::mutex> lk(sources_mtx_);
+
+    auto owner = owners_.find(key);
+    if (owner == owners_.end())
+        return;
+
+    worker *w = owner->second;
+    owners_.erase(owner);
+
+    /* Taking the dispatch lock waits for the callback to return if it is running. Events that
+     * the thread has already fetched for this source are skipped since the key is gone */
+    std::lock_guard<std::mutex> dispatch_lk(w->dispatch_mtx);
+
+    auto src = w->sources.find(key);
+    if (src != w->sources.end())
+    {
+        close_source(w, src);
+    }
+#else
+    (void)key;
+#endif
+}
+
+void uvgrtp::reactor::run(worker *w)
+{
+#ifdef __linux__
+    struct epoll_event events[MAX_REACTOR_EVENTS];
+
+    while (!should_stop_)
+    {
+        int nfds = epoll_wait(w->epoll_fd, events, MAX_REACTOR_EVENTS, REACTOR_TIMEOUT_MS);
+
+        if (nfds < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            log_platform_error("epoll_wait(2) failed");
+            break;
+        }
+
+        std::lock_guard<std::mutex> lk(w->dispatch_mtx);
+
+        for (int i = 0; i < nfds; ++i)
+        {
+            auto src = w->sources.find(events[i].data.u64);
+
+            // the source was removed after the event was fetched
+            if (src == w->sources.end())
+                continue;
+
+            if (src->second.callback() != RTP_OK)
+            {
+                UVG_LOG_ERROR("Event source failed, removing it from the reactor");
+                close_source(w, src);
+            }
+        }
+    }
+#else
+    (void)w;
+#endif
+}
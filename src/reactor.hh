@@ -0,0 +1,106 @@
+#pragma once
+
+#include "uvgrtp/util.hh"
+
+#include "socket.hh"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace uvgrtp {
+
+    /* Called by the reactor when the socket of an event source is readable or its timer expires.
+     * If the callback returns something else than RTP_OK, the source is removed from the reactor */
+    typedef std::function<rtp_error_t()> reactor_callback;
+
+    /* Context-level I/O reactor
+     *
+     * Instead of every media stream running receiver, processor, RTCP and keep-alive threads
+     * of its own, the sockets and periodic work of all media streams of a context can be
+     * registered to a reactor. The reactor runs a fixed pool of threads, each of which waits on its own epoll(7)
+     * instance, so the number of threads follows the number of cores and not the number of streams.
+     *
+     * An event source is always served by the same thread and a new source is given to the
+     * thread with the fewest sources. */
+    class reactor {
+        public:
+            /* Create a reactor with "threads" I/O threads, 0 uses the number of hardware threads */
+            reactor(unsigned int threads);
+            ~reactor();
+
+            /* Start the I/O threads
+             *
+             * Return RTP_OK on success
+             * Return RTP_NOT_SUPPORTED if the platform does not have epoll(7)
+             * Return RTP_GENERIC_ERROR if an epoll instance could not be created */
+            rtp_error_t start();
+
+            /* Stop and join the I/O threads */
+            void stop();
+
+            /* Register "socket" as an event source. "callback" is called from an I/O thread every
+             * time the socket is readable and it should read the socket until it is drained
+             *
+             * If "affinity" is the key of another source, the new source is served by the same thread
+             * so that their callbacks never run at the same time. Otherwise the new source is given
+             * to the thread with the fewest sources
+             *
+             * Return a key on success that identifies the event source
+             * Return 0 if the source could not be registered */
+            uint64_t add_source(socket_t socket, reactor_callback callback, uint64_t affinity = 0);
+
+            /* Register a timer as an event source. "callback" is called from an I/O thread
+             * "first_ms" milliseconds from now and every "interval_ms" milliseconds after that.
+             * "affinity" works the same way as with add_source() and the timer is removed with remove_source()
+             *
+             * Return a key on success that identifies the event source
+             * Return 0 if the timer could not be created */
+            uint64_t add_timer(uint32_t first_ms, uint32_t interval_ms, reactor_callback callback, uint64_t affinity = 0);
+
+            /* Remove an event source. When this returns, the callback of the source is not running
+             * and will not be called again. Must not be called from the callback of a source served
+             * by the same I/O thread */
+            void remove_source(uint64_t key);
+
+            size_t thread_count() const;
+
+        private:
+            struct source {
+                socket_t socket;
+                reactor_callback callback;
+                bool timer; // "socket" is a timerfd owned by the reactor
+            };
+
+            struct worker {
+                int epoll_fd = -1;
+                std::unique_ptr<std::thread> thread;
+
+                // held while the events of one epoll_wait() are dispatched
+                std::mutex dispatch_mtx;
+                std::unordered_map<uint64_t, source> sources;
+            };
+
+            void run(worker *w);
+
+            /* Add a source to the thread of "affinity" or to the least loaded thread. Return its key or 0 */
+            uint64_t register_source(socket_t socket, reactor_callback callback, bool timer, uint64_t affinity);
+
+            /* Stop polling a source of "w" and close it if it is a timer. The dispatch lock of "w" must be held */
+            void close_source(worker *w, std::unordered_map<uint64_t, source>::iterator src);
+
+            std::vector<std::unique_ptr<worker>> workers_;
+            std::atomic<bool> should_stop_;
+
+            // maps event source keys to the thread serving them
+            std::mutex sources_mtx_;
+            std::unordered_map<uint64_t, worker *> owners_;
+            uint64_t next_key_;
+    };
+}
+
+namespace uvg_rtp = uvgrtp;
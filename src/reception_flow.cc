@@ -2,8 +2,12 @@
 
 #include "uvgrtp/util.hh"
 #include "uvgrtp/frame.hh"
+#include "uvgrtp/clock.hh"
 
 #include "socket.hh"
+#include "reactor.hh"
+#include "uring.hh"
+#include "rx_buffer.hh"
 #include "debug.hh"
 #include "random.hh"
 
@@ -20,103 +24,382 @@
 #endif
 
 #include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
 
 constexpr size_t DEFAULT_INITIAL_BUFFER_SIZE = 4194304;
+constexpr size_t DEFAULT_FRAME_QUEUE_SIZE = 1024;
+
+// with UDP GRO the kernel coalesces datagrams up to the maximum size of an IP packet
+constexpr size_t MAX_GRO_READ = 65535;
+constexpr size_t MIN_GRO_RING_SLOTS = 2 * uvgrtp::MAX_RECV_BATCH;
+
+// io_uring receive: buffer group of the ring buffer slots and user data of the requests
+constexpr uint16_t URING_BUFFER_GROUP = 0;
+constexpr uint64_t URING_RECV_REQUEST = 1;
+constexpr uint64_t URING_CANCEL_REQUEST = 2;
+
+#ifdef UVGRTP_HAVE_IO_URING
+// a multishot recvmsg writes a header and the ancillary data in front of the datagrams
+constexpr size_t URING_RECVMSG_HEADROOM = sizeof(io_uring_recvmsg_out) + uvgrtp::RECV_CONTROL_SIZE;
+#endif
+
+// bounds for how long the processor spins waiting for packets before it parks itself
+constexpr int MIN_SPIN_LIMIT = 64;
+constexpr int MAX_SPIN_LIMIT = 16384;
 
-uvgrtp::reception_flow::reception_flow() :
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+uvgrtp::reception_flow::reception_flow(std::shared_ptr<uvgrtp::reactor> reactor) :
+    frames_(nullptr),
+    frame_queue_(),
+    retired_frame_queues_(),
+    frame_queue_readers_(0),
+    pending_frame_queue_size_(0),
+    frame_queue_policy_(RFQ_DROP_OLDEST),
+    dropped_frames_(0),
+    pull_waiters_(0),
     recv_hook_arg_(nullptr),
     recv_hook_(nullptr),
     should_stop_(true),
     receiver_(nullptr),
+    processor_(nullptr),
+    reactor_(reactor),
+    reactor_key_(0),
+    uring_(nullptr),
     ring_buffer_(),
-    ring_read_index_(-1), // invalid first index that will increase to a valid one
-    last_ring_write_index_(-1),
+    ring_head_(0),
+    ring_tail_(0),
+    processor_parked_(false),
+    ring_resize_pending_(false),
+    spin_limit_(MIN_SPIN_LIMIT),
+    ring_overruns_(0),
+    received_packets_(0),
+    receive_batches_(0),
+    largest_batch_(0),
+    processed_packets_(0),
     buffer_size_kbytes_(DEFAULT_INITIAL_BUFFER_SIZE),
-    payload_size_(MAX_IPV4_PAYLOAD)
+    payload_size_(MAX_IPV4_PAYLOAD),
+    gro_(false),
+    timestamps_(false),
+    slot_size_(MAX_IPV4_PAYLOAD),
+    slot_headroom_(0)
 {
-    create_ring_buffer();
+    frame_queue_.reset(new uvgrtp::bounded_queue<uvgrtp::frame::rtp_frame*>(DEFAULT_FRAME_QUEUE_SIZE));
+    frames_ = frame_queue_.get();
 }
 
 uvgrtp::reception_flow::~reception_flow()
 {
+    if (reactor_key_)
+    {
+        reactor_->remove_source(reactor_key_);
+    }
+
     destroy_ring_buffer();
     clear_frames();
 }
 
 void uvgrtp::reception_flow::clear_frames()
 {
-    frames_mtx_.lock();
-    for (auto& frame : frames_)
+    uvgrtp::frame::rtp_frame* frame = nullptr;
+
+    while (frame_queue_->pop(frame))
     {
         (void)uvgrtp::frame::dealloc_frame(frame);
     }
 
-    frames_.clear();
-    frames_mtx_.unlock();
+    free_retired_frame_queues();
 }
 
-void uvgrtp::reception_flow::create_ring_buffer()
+rtp_error_t uvgrtp::reception_flow::create_ring_buffer()
 {
+    size_t slot_size = (gro_ ? MAX_GRO_READ : payload_size_) + slot_headroom_;
+    size_t elements = std::max((size_t)buffer_size_kbytes_ / slot_size, (size_t)1);
+
+    // a slot is used for every read, coalesced or not, so large slots alone would make a short ring
+    if (gro_)
+    {
+        elements = std::max(elements, MIN_GRO_RING_SLOTS);
+    }
+
+    std::vector<uvgrtp::frame::rx_buffer*> buffers;
+    if (!uvgrtp::frame::alloc_rx_region(elements, slot_size, buffers))
+    {
+        UVG_LOG_ERROR("Failed to allocate memory for ring buffer");
+        return RTP_MEMORY_ERROR;
+    }
+
     destroy_ring_buffer();
-    size_t elements = buffer_size_kbytes_ / payload_size_;
+    slot_size_ = slot_size;
 
-    for (size_t i = 0; i < elements; ++i)
+    ring_buffer_.reserve(elements);
+    for (auto buffer : buffers)
     {
-        uint8_t* data = new uint8_t[payload_size_];
-        if (data)
-        {
-            ring_buffer_.push_back({data, 0});
-        }
-        else
-        {
-            UVG_LOG_ERROR("Failed to allocate memory for ring buffer");
-        }
+        ring_buffer_.push_back({buffer->data, 0, buffer, 0, 0, 0});
     }
+
+    return RTP_OK;
 }
 
 void uvgrtp::reception_flow::destroy_ring_buffer()
 {
+    // frames that still reference a slot keep its memory alive
     for (size_t i = 0; i < ring_buffer_.size(); ++i)
     {
-        if (ring_buffer_.at(i).data)
-        {
-            delete[] ring_buffer_.at(i).data;
-        }
+        uvgrtp::frame::release_rx_buffer(ring_buffer_.at(i).buffer);
     }
     ring_buffer_.clear();
 }
 
+void uvgrtp::reception_flow::attach_ring_buffer(Buffer& slot, uint8_t* datagram, uvgrtp::frame::rtp_frame* frame)
+{
+    if (frame && !frame->owner && frame->dgram == datagram)
+    {
+        uvgrtp::frame::retain_rx_buffer(slot.buffer);
+        frame->owner = slot.buffer;
+    }
+}
+
+void uvgrtp::reception_flow::recycle_ring_buffer(Buffer& slot)
+{
+    if (!uvgrtp::frame::rx_buffer_unique(slot.buffer))
+    {
+        uvgrtp::frame::rx_buffer* buffer = uvgrtp::frame::alloc_rx_buffer(slot_size_);
+
+        uvgrtp::frame::release_rx_buffer(slot.buffer);
+        slot.buffer = buffer;
+        slot.data = buffer->data;
+    }
+}
+
 void uvgrtp::reception_flow::set_buffer_size(const ssize_t& value)
 {
     buffer_size_kbytes_ = value;
-    create_ring_buffer();
+    ring_resize_pending_ = !should_stop_;
 }
 
 void uvgrtp::reception_flow::set_payload_size(const size_t& value)
 {
     payload_size_ = value;
-    create_ring_buffer();
+    ring_resize_pending_ = !should_stop_;
+}
+
+void uvgrtp::reception_flow::apply_ring_resize()
+{
+    /* The processor only touches the slots between the tail and the head, so once it has caught up
+     * the ring can be replaced. Head and tail stay valid since they are taken modulo the ring size */
+    if (!ring_resize_pending_.load(std::memory_order_acquire) ||
+        ring_tail_.load(std::memory_order_acquire) != ring_head_.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    ring_resize_pending_ = false;
+
+    if (create_ring_buffer() == RTP_OK)
+    {
+        UVG_LOG_DEBUG("Reception ring buffer resized to %zu slots of %zu bytes", ring_buffer_.size(), slot_size_);
+    }
+}
+
+rtp_error_t uvgrtp::reception_flow::set_frame_queue_size(size_t size)
+{
+    if (size == 0)
+        return RTP_INVALID_VALUE;
+
+    pending_frame_queue_size_ = size;
+
+    // nobody is returning frames so the queue can be replaced right away
+    if (should_stop_)
+    {
+        resize_frame_queue();
+    }
+
+    return RTP_OK;
+}
+
+rtp_error_t uvgrtp::reception_flow::set_frame_queue_policy(int policy)
+{
+    if (policy != RFQ_DROP_OLDEST && policy != RFQ_DROP_NEWEST)
+        return RTP_INVALID_VALUE;
+
+    frame_queue_policy_ = policy;
+    return RTP_OK;
+}
+
+void uvgrtp::reception_flow::resize_frame_queue()
+{
+    size_t size = pending_frame_queue_size_.exchange(0);
+    if (size == 0)
+        return;
+
+    std::unique_ptr<uvgrtp::bounded_queue<uvgrtp::frame::rtp_frame*>> old_queue = std::move(frame_queue_);
+    uvgrtp::bounded_queue<uvgrtp::frame::rtp_frame*>* new_queue =
+        new uvgrtp::bounded_queue<uvgrtp::frame::rtp_frame*>(size);
+
+    // move the queued frames over, keeping the newest ones if they don't fit
+    uvgrtp::frame::rtp_frame* frame = nullptr;
+    while (old_queue->pop(frame))
+    {
+        if (!new_queue->push(frame))
+        {
+            uvgrtp::frame::rtp_frame* oldest = nullptr;
+            if (new_queue->pop(oldest))
+            {
+                (void)uvgrtp::frame::dealloc_frame(oldest);
+                ++dropped_frames_;
+            }
+            (void)new_queue->push(frame);
+        }
+    }
+
+    frame_queue_.reset(new_queue);
+    frames_ = new_queue;
+
+    // the application may have loaded the old queue just before it was replaced
+    retired_frame_queues_.push_back(std::move(old_queue));
+    free_retired_frame_queues();
+
+    UVG_LOG_DEBUG("Frame queue size set to %zu", new_queue->capacity());
+}
+
+void uvgrtp::reception_flow::free_retired_frame_queues()
+{
+    /* A reader that registers after this check loads the current queue, since "frames_" was
+     * replaced before the check. Otherwise the queues are freed on a later resize or return */
+    if (retired_frame_queues_.empty() || frame_queue_readers_.load() != 0)
+        return;
+
+    uvgrtp::frame::rtp_frame* frame = nullptr;
+
+    for (auto& queue : retired_frame_queues_)
+    {
+        while (queue->pop(frame))
+        {
+            (void)uvgrtp::frame::dealloc_frame(frame);
+        }
+    }
+
+    retired_frame_queues_.clear();
+}
+
+bool uvgrtp::reception_flow::pop_frame(uvgrtp::frame::rtp_frame*& frame)
+{
+    ++frame_queue_readers_;
+    bool popped = frames_.load()->pop(frame);
+    --frame_queue_readers_;
+
+    return popped;
 }
 
 rtp_error_t uvgrtp::reception_flow::start(std::shared_ptr<uvgrtp::socket> socket, int rce_flags)
 {
     should_stop_ = false;
 
+    // without kernel timestamps, the arrival time is taken when the packets are read
+    timestamps_ = socket->enable_timestamps() == RTP_OK;
+
+    if (rce_flags & RCE_UDP_GRO)
+    {
+        if (socket->enable_gro() == RTP_OK)
+        {
+            gro_ = true;
+        }
+        else
+        {
+            UVG_LOG_WARN("UDP GRO is not available, receiving one datagram per read");
+        }
+    }
+
+#ifdef UVGRTP_HAVE_IO_URING
+    slot_headroom_ = ((rce_flags & RCE_IO_URING) && !reactor_) ? URING_RECVMSG_HEADROOM : 0;
+#endif
+
+    // the slot size depends on GRO so the ring is allocated only now
+    ring_head_ = 0;
+    ring_tail_ = 0;
+    ring_resize_pending_ = false;
+
+    if (create_ring_buffer() != RTP_OK)
+    {
+        should_stop_ = true;
+        return RTP_MEMORY_ERROR;
+    }
+
+    if (reactor_)
+    {
+        // the I/O thread of the reactor processes the packets it has received.
+        // RTCP registers its own sockets and report timer when it is started
+        int reactor_flags = rce_flags | RCE_RUN_TO_COMPLETION;
+
+        reactor_key_ = reactor_->add_source(socket->get_raw_socket(), [this, socket, reactor_flags]() {
+            if (read_socket(socket, reactor_flags) != RTP_OK)
+            {
+                should_stop_ = true;
+                return RTP_GENERIC_ERROR;
+            }
+            return RTP_OK;
+        });
+
+        if (reactor_key_)
+        {
+            return RTP_OK;
+        }
+
+        UVG_LOG_WARN("Failed to register the socket to the reactor, creating receiving threads instead");
+    }
+
+    void (uvgrtp::reception_flow::*receiver_func)(std::shared_ptr<uvgrtp::socket>, int) = &uvgrtp::reception_flow::receiver;
+
+    if (rce_flags & RCE_IO_URING)
+    {
+        if (create_uring() == RTP_OK)
+        {
+            receiver_func = &uvgrtp::reception_flow::receiver_uring;
+        }
+        else
+        {
+            UVG_LOG_WARN("io_uring is not available, receiving packets with recvmmsg()");
+        }
+    }
+
     UVG_LOG_DEBUG("Creating receiving threads and setting priorities");
-    processor_ = std::unique_ptr<std::thread>(new std::thread(&uvgrtp::reception_flow::process_packet, this, rce_flags));
-    receiver_ = std::unique_ptr<std::thread>(new std::thread(&uvgrtp::reception_flow::receiver, this, socket));
+
+    // in run-to-completion mode the receiver thread processes the packets itself
+    if (!(rce_flags & RCE_RUN_TO_COMPLETION))
+    {
+        processor_ = std::unique_ptr<std::thread>(new std::thread(&uvgrtp::reception_flow::process_packet, this, rce_flags));
+    }
+    receiver_ = std::unique_ptr<std::thread>(new std::thread(receiver_func, this, socket, rce_flags));
 
     // set receiver thread priority to maximum
 #ifndef WIN32
     struct sched_param params;
     params.sched_priority = sched_get_priority_max(SCHED_FIFO);
     pthread_setschedparam(receiver_->native_handle(), SCHED_FIFO, &params);
-    params.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
-    pthread_setschedparam(processor_->native_handle(), SCHED_FIFO, &params);
+    if (processor_)
+    {
+        params.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+        pthread_setschedparam(processor_->native_handle(), SCHED_FIFO, &params);
+    }
 #else
 
     SetThreadPriority(receiver_->native_handle(), REALTIME_PRIORITY_CLASS);
-    SetThreadPriority(processor_->native_handle(), ABOVE_NORMAL_PRIORITY_CLASS);
+    if (processor_)
+    {
+        SetThreadPriority(processor_->native_handle(), ABOVE_NORMAL_PRIORITY_CLASS);
+    }
 
 #endif
 
@@ -126,7 +409,10 @@ rtp_error_t uvgrtp::reception_flow::start(std::shared_ptr<uvgrtp::socket> socket
 rtp_error_t uvgrtp::reception_flow::stop()
 {
     should_stop_ = true;
-    process_cond_.notify_all();
+    {
+        std::lock_guard<std::mutex> lk(wait_mtx_);
+        process_cond_.notify_all();
+    }
 
     if (receiver_ != nullptr && receiver_->joinable())
     {
@@ -138,6 +424,28 @@ rtp_error_t uvgrtp::reception_flow::stop()
         processor_->join();
     }
 
+    uring_ = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lk(pull_mtx_);
+        pull_cond_.notify_all();
+    }
+
+    if (reactor_key_)
+    {
+        // returns once the I/O thread is no longer reading the socket
+        reactor_->remove_source(reactor_key_);
+        reactor_key_ = 0;
+
+        log_receive_statistics(RCE_RUN_TO_COMPLETION);
+    }
+
+    if (dropped_frames_)
+    {
+        UVG_LOG_WARN("Frame queue was full, %llu frames were dropped",
+            (unsigned long long)dropped_frames_.load());
+    }
+
     clear_frames();
 
     return RTP_OK;
@@ -159,40 +467,43 @@ rtp_error_t uvgrtp::reception_flow::install_receive_hook(
 
 uvgrtp::frame::rtp_frame *uvgrtp::reception_flow::pull_frame()
 {
-    while (frames_.empty() && !should_stop_)
+    uvgrtp::frame::rtp_frame* frame = nullptr;
+
+    // wake up periodically to check whether reception flow has been stopped
+    while (!frame && !should_stop_)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        frame = wait_for_frame(100);
     }
 
-    if (should_stop_)
-        return nullptr;
-
-    frames_mtx_.lock();
-    auto frame = frames_.front();
-    frames_.erase(frames_.begin());
-    frames_mtx_.unlock();
-
     return frame;
 }
 
 uvgrtp::frame::rtp_frame *uvgrtp::reception_flow::pull_frame(ssize_t timeout_ms)
 {
-    auto start_time = std::chrono::high_resolution_clock::now();
+    return wait_for_frame(timeout_ms);
+}
 
-    while (frames_.empty() && 
-        !should_stop_ &&
-        timeout_ms > std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_time).count())
-    {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
+uvgrtp::frame::rtp_frame *uvgrtp::reception_flow::wait_for_frame(ssize_t timeout_ms)
+{
+    uvgrtp::frame::rtp_frame* frame = nullptr;
 
-    if (should_stop_ || frames_.empty())
+    if (should_stop_)
         return nullptr;
 
-    frames_mtx_.lock();
-    auto frame = frames_.front();
-    frames_.pop_front();
-    frames_mtx_.unlock();
+    if (pop_frame(frame) || timeout_ms <= 0)
+        return frame;
+
+    std::unique_lock<std::mutex> lk(pull_mtx_);
+    ++pull_waiters_;
+
+    // the frame returner either sees us waiting or we see the frame when checking the queue
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    pull_cond_.wait_for(lk, std::chrono::milliseconds(timeout_ms), [this, &frame] {
+        return should_stop_ || pop_frame(frame);
+    });
+
+    --pull_waiters_;
 
     return frame;
 }
@@ -253,10 +564,47 @@ void uvgrtp::reception_flow::return_frame(uvgrtp::frame::rtp_frame *frame)
 {
     if (recv_hook_) {
         recv_hook_(recv_hook_arg_, frame);
-    } else {
-        frames_mtx_.lock();
-        frames_.push_back(frame);
-        frames_mtx_.unlock();
+        return;
+    }
+
+    if (pending_frame_queue_size_)
+    {
+        resize_frame_queue();
+    }
+    else
+    {
+        free_retired_frame_queues();
+    }
+
+    uvgrtp::bounded_queue<uvgrtp::frame::rtp_frame*>* queue = frames_;
+
+    while (!queue->push(frame))
+    {
+        // the application is not pulling frames fast enough
+        if (dropped_frames_++ == 0)
+        {
+            UVG_LOG_WARN("Frame queue is full, dropping frames. Pull frames faster or increase RCC_FRAME_QUEUE_SIZE");
+        }
+
+        if (frame_queue_policy_ == RFQ_DROP_NEWEST)
+        {
+            (void)uvgrtp::frame::dealloc_frame(frame);
+            return;
+        }
+
+        uvgrtp::frame::rtp_frame* oldest = nullptr;
+        if (queue->pop(oldest))
+        {
+            (void)uvgrtp::frame::dealloc_frame(oldest);
+        }
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (pull_waiters_.load())
+    {
+        std::lock_guard<std::mutex> lk(pull_mtx_);
+        pull_cond_.notify_one();
     }
 }
 
@@ -345,211 +693,528 @@ void uvgrtp::reception_flow::call_aux_handlers(uint32_t key, int rce_flags, uvgr
     }
 }
 
-void uvgrtp::reception_flow::receiver(std::shared_ptr<uvgrtp::socket> socket)
+void uvgrtp::reception_flow::receiver(std::shared_ptr<uvgrtp::socket> socket, int rce_flags)
 {
-    int read_packets = 0;
-
-    while (!should_stop_) {
-
-        // First we wait using poll until there is data in the socket
-
 #ifdef _WIN32
-        LPWSAPOLLFD pfds = new pollfd();
+    WSAPOLLFD pfds;
 #else
-        pollfd* pfds = new pollfd();
+    pollfd pfds;
 #endif
 
-        size_t read_fds = socket->get_raw_socket();
-        pfds->fd = read_fds;
-        pfds->events = POLLIN;
+    pfds.fd = socket->get_raw_socket();
+    pfds.events = POLLIN;
+
+    while (!should_stop_) {
+
+        // First we wait using poll until there is data in the socket
+        pfds.revents = 0;
 
         // exits after this time if no data has been received to check whether we should exit
-        int timeout_ms = 100; 
+        int timeout_ms = 100;
 
 #ifdef _WIN32
-        if (WSAPoll(pfds, 1, timeout_ms) < 0) {
+        if (WSAPoll(&pfds, 1, timeout_ms) < 0) {
 #else
-        if (poll(pfds, 1, timeout_ms) < 0) {
+        if (poll(&pfds, 1, timeout_ms) < 0) {
 #endif
             UVG_LOG_ERROR("poll(2) failed");
-            if (pfds)
-            {
-                delete pfds;
-                pfds = nullptr;
-            }
             break;
         }
 
-        if (pfds->revents & POLLIN) {
+        if (pfds.revents & POLLIN) {
+            if (read_socket(socket, rce_flags) != RTP_OK) {
+                should_stop_ = true;
+            }
+        }
+    }
 
-            // we write as many packets as socket has in the buffer
-            while (!should_stop_)
-            {
-                ssize_t next_write_index = next_buffer_location(last_ring_write_index_);
+    log_receive_statistics(rce_flags);
+}
 
-                //increase_buffer_size(next_write_index);
+void uvgrtp::reception_flow::log_receive_statistics(int rce_flags)
+{
+    UVG_LOG_DEBUG("Total read packets from buffer: %llu in %llu batches, largest batch %u, average batch %.2f",
+        (unsigned long long)received_packets_, (unsigned long long)receive_batches_, largest_batch_,
+        receive_batches_ ? (double)received_packets_ / receive_batches_ : 0.0);
+
+    if (ring_overruns_)
+    {
+        UVG_LOG_WARN("Reception ring buffer was full %llu times", (unsigned long long)ring_overruns_);
+    }
+
+    if (rce_flags & RCE_RUN_TO_COMPLETION)
+    {
+        UVG_LOG_DEBUG("Total processed packets: %llu", (unsigned long long)processed_packets_);
+    }
+}
+
+rtp_error_t uvgrtp::reception_flow::create_uring()
+{
+    const size_t size = ring_buffer_.size();
+
+    if (size == 0)
+        return RTP_NOT_SUPPORTED;
+
+    uring_ = std::unique_ptr<uvgrtp::uring>(new uvgrtp::uring());
+
+    // every slot of the ring buffer can have a completion waiting
+    if (uring_->init(8, (unsigned int)size) != RTP_OK ||
+        uring_->register_buffer_ring(URING_BUFFER_GROUP, (unsigned int)size) != RTP_OK)
+    {
+        uring_ = nullptr;
+        return RTP_NOT_SUPPORTED;
+    }
+
+    return RTP_OK;
+}
+
+void uvgrtp::reception_flow::receiver_uring(std::shared_ptr<uvgrtp::socket> socket, int rce_flags)
+{
+#ifdef UVGRTP_HAVE_IO_URING
+    const size_t size = ring_buffer_.size();
+    bool run_to_completion = rce_flags & RCE_RUN_TO_COMPLETION;
+
+    // slots given to the kernel, counted the same way as head and tail
+    uint64_t provided = 0;
+    bool armed = false;
+
+    /* The multishot recvmsg only takes the sizes of the name and ancillary data from this
+     * header. Each read starts with io_uring_recvmsg_out followed by those and the datagrams */
+    struct msghdr recv_msg;
+    memset(&recv_msg, 0, sizeof(recv_msg));
+    recv_msg.msg_controllen = uvgrtp::RECV_CONTROL_SIZE;
+    const size_t read_header = sizeof(io_uring_recvmsg_out) + recv_msg.msg_namelen + recv_msg.msg_controllen;
+
+    while (!should_stop_)
+    {
+        // the kernel has the slots, so the ring keeps the size it had when receiving started
+        if (ring_resize_pending_.exchange(false))
+        {
+            UVG_LOG_WARN("The reception ring buffer of an io_uring receiver cannot be resized while receiving");
+        }
 
-                rtp_error_t ret = RTP_OK;
+        /* Give the slots released by the processor back to the kernel in ring order. The kernel
+         * uses the provided buffers in the order they were given, so the packets are
+         * written to the slots in the same order as with recvmmsg() */
+        uint64_t tail = ring_tail_.load(std::memory_order_acquire);
+        for (; provided < tail + size; ++provided)
+        {
+            uint16_t index = (uint16_t)(provided % size);
+            uring_->provide_buffer(ring_buffer_[index].data, (unsigned int)slot_size_, index);
+        }
+        uring_->commit_buffers();
 
-                // get the potential packet
-                ret = socket->recvfrom(ring_buffer_[next_write_index].data, payload_size_,
-                    MSG_DONTWAIT, &ring_buffer_[next_write_index].read);
+        uint64_t head = ring_head_.load(std::memory_order_relaxed);
 
-                if (ret == RTP_INTERRUPTED)
+        if (!armed)
+        {
+            if (head - tail == size)
+            {
+                // the ring buffer is full, see read_socket()
+                if (ring_overruns_++ == 0)
                 {
-                    break;
+                    UVG_LOG_WARN("Reception ring buffer is full, consider increasing RCC_RING_BUFFER_SIZE");
                 }
-                else if (ring_buffer_[next_write_index].read == 0)
+
+                wake_processor();
+                while (!should_stop_ && ring_tail_.load(std::memory_order_acquire) == tail)
                 {
-                    UVG_LOG_WARN("Failed to read anything from socket");
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+                continue;
+            }
+
+            io_uring_sqe *sqe = uring_->get_sqe();
+            if (!sqe)
+            {
+                // the submission queue is full, submit what is queued and arm on the next round
+                if (uring_->submit_and_wait(0, 0) == RTP_GENERIC_ERROR)
+                {
+                    UVG_LOG_ERROR("io_uring_enter(2) failed! Reception flow cannot continue!");
+                    should_stop_ = true;
                     break;
                 }
-                else if (ret != RTP_OK) {
-                    UVG_LOG_ERROR("recvfrom(2) failed! Reception flow cannot continue %d!", ret);
+                continue;
+            }
+
+            sqe->opcode    = IORING_OP_RECVMSG;
+            sqe->fd        = socket->get_raw_socket();
+            sqe->addr      = (uint64_t)(uintptr_t)&recv_msg;
+            sqe->len       = 1;
+            sqe->ioprio    = IORING_RECV_MULTISHOT;
+            sqe->flags     = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = URING_BUFFER_GROUP;
+            sqe->user_data = URING_RECV_REQUEST;
+            armed = true;
+        }
+
+        // exits after this time if no data has been received to check whether we should exit
+        if (uring_->submit_and_wait(1, 100) == RTP_GENERIC_ERROR)
+        {
+            UVG_LOG_ERROR("io_uring_enter(2) failed! Reception flow cannot continue!");
+            should_stop_ = true;
+            break;
+        }
+
+        unsigned int received = 0;
+        io_uring_cqe cqe;
+
+        // used for the reads the kernel did not timestamp
+        uint64_t read_time = uvgrtp::clock::ntp::now();
+
+        while (uring_->next_completion(cqe))
+        {
+            // the kernel ends a multishot receive if it runs out of buffers or an error occurs
+            if (!(cqe.flags & IORING_CQE_F_MORE))
+            {
+                armed = false;
+            }
+
+            if (cqe.flags & IORING_CQE_F_BUFFER)
+            {
+                size_t index = (size_t)((head + received) % size);
+                uint16_t bid = (uint16_t)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+                if (bid != index)
+                {
+                    UVG_LOG_ERROR("io_uring filled ring buffer slot %u instead of %zu! Reception flow cannot continue!",
+                        bid, index);
                     should_stop_ = true;
                     break;
                 }
 
-                ++read_packets;
+                Buffer& slot = ring_buffer_[index];
 
-                // finally we update the ring buffer so processing (reading) knows that there is a new frame
-                last_ring_write_index_ = next_write_index;
+                if (cqe.res < (int)read_header)
+                {
+                    slot.read = cqe.res < 0 ? cqe.res : 0;
+                }
+                else
+                {
+                    io_uring_recvmsg_out out;
+                    memcpy(&out, slot.data, sizeof(out));
+
+                    // parse the ancillary data the same way as recvmmsg() does
+                    struct msghdr control;
+                    memset(&control, 0, sizeof(control));
+                    control.msg_control    = slot.data + sizeof(out) + out.namelen;
+                    control.msg_controllen = out.controllen;
+
+                    uvgrtp::recv_info info;
+                    uvgrtp::socket::parse_recv_info(&control, info);
+
+                    slot.offset       = (int)read_header;
+                    slot.read         = (int)std::min((size_t)out.payloadlen, (size_t)cqe.res - read_header);
+                    slot.segment_size = gro_ ? info.segment_size : 0;
+                    slot.arrival_ntp  = (timestamps_ && info.arrival_ntp) ? info.arrival_ntp : read_time;
+                }
+                ++received;
+            }
+            else if (cqe.res < 0 && cqe.res != -ENOBUFS)
+            {
+                UVG_LOG_ERROR("Multishot receive failed: %s! Reception flow cannot continue!", strerror(-cqe.res));
+                should_stop_ = true;
+                break;
+            }
+        }
+
+        if (received)
+        {
+            received_packets_ += received;
+            ++receive_batches_;
+            largest_batch_ = std::max(largest_batch_, received);
+
+            // publish the packets to processor
+            ring_head_.store(head + received);
+
+            if (run_to_completion)
+            {
+                process_available_packets(rce_flags);
+            }
+            else
+            {
+                wake_processor();
             }
+        }
+    }
 
-            // start processing the packets by waking the processing thread
-            process_cond_.notify_one();
+    /* Cancel the receive and wait for its last completion so that the kernel
+     * no longer writes to the ring buffer when the thread exits */
+    if (armed)
+    {
+        io_uring_sqe *sqe = uring_->get_sqe();
+        if (!sqe && uring_->submit_and_wait(0, 0) == RTP_OK)
+        {
+            sqe = uring_->get_sqe();
         }
 
-        if (pfds)
+        if (!sqe)
         {
-            delete pfds;
-            pfds = nullptr;
+            UVG_LOG_ERROR("Failed to get an io_uring submission queue entry for cancelling the receive");
+        }
+        else
+        {
+            sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+            sqe->addr      = URING_RECV_REQUEST;
+            sqe->user_data = URING_CANCEL_REQUEST;
+        }
+
+        for (int i = 0; sqe && armed && i < 10; ++i)
+        {
+            if (uring_->submit_and_wait(1, 100) == RTP_GENERIC_ERROR)
+                break;
+
+            io_uring_cqe cqe;
+            while (uring_->next_completion(cqe))
+            {
+                if (cqe.user_data == URING_RECV_REQUEST && !(cqe.flags & IORING_CQE_F_MORE))
+                {
+                    armed = false;
+                }
+            }
         }
     }
 
-    UVG_LOG_DEBUG("Total read packets from buffer: %li", read_packets);
+    log_receive_statistics(rce_flags);
+#else
+    receiver(socket, rce_flags);
+#endif
 }
 
-void uvgrtp::reception_flow::process_packet(int rce_flags)
+rtp_error_t uvgrtp::reception_flow::read_socket(std::shared_ptr<uvgrtp::socket> socket, int rce_flags)
 {
-    std::unique_lock<std::mutex> lk(wait_mtx_);
+    uint8_t* batch_buffers[uvgrtp::MAX_RECV_BATCH];
+    int batch_reads[uvgrtp::MAX_RECV_BATCH];
+    uvgrtp::recv_info batch_info[uvgrtp::MAX_RECV_BATCH];
 
-    int processed_packets = 0;
+    bool run_to_completion = rce_flags & RCE_RUN_TO_COMPLETION;
 
+    // we write as many packets as socket has in the buffer
     while (!should_stop_)
     {
-        // go to sleep waiting for something to process
-        process_cond_.wait(lk); 
+        apply_ring_resize();
+
+        const size_t size = ring_buffer_.size();
+        uint64_t head = ring_head_.load(std::memory_order_relaxed);
+        uint64_t tail = ring_tail_.load(std::memory_order_acquire);
+
+        /* Read as many packets as there is contiguous free space after the head */
+        size_t free_slots = size - (size_t)(head - tail);
+        size_t write_index = head % size;
+        size_t batch_size = std::min(free_slots, size - write_index);
+        batch_size = std::min(batch_size, (size_t)uvgrtp::MAX_RECV_BATCH);
+
+        if (batch_size == 0)
+        {
+            /* The ring buffer is full. Instead of overwriting unprocessed packets,
+             * leave the packets in the socket until the processor catches up */
+            if (ring_overruns_++ == 0)
+            {
+                UVG_LOG_WARN("Reception ring buffer is full, consider increasing RCC_RING_BUFFER_SIZE");
+            }
+
+            wake_processor();
+            while (!should_stop_ && ring_tail_.load(std::memory_order_acquire) == tail)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            continue;
+        }
 
-        if (should_stop_)
+        for (size_t i = 0; i < batch_size; ++i)
+        {
+            batch_buffers[i] = ring_buffer_[write_index + i].data;
+        }
+
+        unsigned int received = 0;
+        rtp_error_t ret = socket->recvmmsg(batch_buffers, slot_size_, batch_reads,
+            (unsigned int)batch_size, MSG_DONTWAIT, &received, (gro_ || timestamps_) ? batch_info : nullptr);
+
+        if (ret == RTP_INTERRUPTED)
         {
             break;
         }
+        else if (ret != RTP_OK) {
+            UVG_LOG_ERROR("recvmmsg(2) failed! Reception flow cannot continue %d!", ret);
+            return ret;
+        }
+
+        uint64_t read_time = uvgrtp::clock::ntp::now();
 
-        // process all available reads in one go
-        while (ring_read_index_ != last_ring_write_index_)
+        for (unsigned int i = 0; i < received; ++i)
         {
-            // first update the read location
-            ring_read_index_ = next_buffer_location(ring_read_index_);
+            ring_buffer_[write_index + i].read = batch_reads[i];
+            ring_buffer_[write_index + i].segment_size = gro_ ? batch_info[i].segment_size : 0;
+            ring_buffer_[write_index + i].arrival_ntp = (timestamps_ && batch_info[i].arrival_ntp) ?
+                batch_info[i].arrival_ntp : read_time;
+        }
 
-            if (ring_buffer_[ring_read_index_].read > 0)
-            {
-                rtp_error_t ret = RTP_OK;
-
-                // process the ring buffer location through all the handlers
-                for (auto& handler : packet_handlers_) {
-                    uvgrtp::frame::rtp_frame* frame = nullptr;
-
-                    // Here we don't lock ring mutex because the chaging is only done above. 
-                    // NOTE: If there is a need for multiple processing threads, the read should be guarded
-                    switch ((ret = (*handler.second.primary)(ring_buffer_[ring_read_index_].read,
-                        ring_buffer_[ring_read_index_].data, rce_flags, &frame))) {
-                        case RTP_OK:
-                        {
-                            // packet was handled successfully
-                            break;
-                        }
-                        case RTP_PKT_NOT_HANDLED:
-                        {
-                            // packet was not handled by this primary handlers, proceed to the next one
-                            continue;
-                            /* packet was handled by the primary handler
-                             * and should be dispatched to the auxiliary handler(s) */
-                        }
-                        case RTP_PKT_MODIFIED:
-                        {
-                            call_aux_handlers(handler.first, rce_flags, &frame);
-                            break;
-                        }
-                        case RTP_GENERIC_ERROR:
-                        {
-                            UVG_LOG_DEBUG("Error in handling of received packet!");
-                            break;
-                        }
-                        default:
-                        {
-                            UVG_LOG_ERROR("Unknown error code from packet handler: %d", ret);
-                            break;
-                        }
-                    }
-                }
+        received_packets_ += received;
+        ++receive_batches_;
+        largest_batch_ = std::max(largest_batch_, received);
 
-                // to make sure we don't process this packet again
-                ring_buffer_[ring_read_index_].read = 0;
-                ++processed_packets;
-            }
-            else
-            {
-#ifndef NDEBUG 
-#ifndef __RTP_SILENT__
-                ssize_t write = last_ring_write_index_;
-                ssize_t read = ring_read_index_;
-                UVG_LOG_DEBUG("Found invalid frame in read buffer: %li. R: %lli, W: %lli", 
-                    ring_buffer_[ring_read_index_].read, read, write);
-#endif
-#endif
-            }
+        // publish the packets to processor
+        ring_head_.store(head + received);
+
+        if (run_to_completion)
+        {
+            // this thread is the processor, handle the batch while it is still in cache
+            process_available_packets(rce_flags);
+        }
+        else
+        {
+            wake_processor();
         }
+
+        // a partial batch means the socket has been drained
+        if (received < batch_size)
+        {
+            break;
+        }
+    }
+
+    return RTP_OK;
+}
+
+void uvgrtp::reception_flow::wake_processor()
+{
+    // the store to head and this load are sequentially consistent with the ones in wait_for_packets()
+    if (processor_parked_.load())
+    {
+        std::lock_guard<std::mutex> lk(wait_mtx_);
+        process_cond_.notify_one();
     }
+}
+
+bool uvgrtp::reception_flow::wait_for_packets()
+{
+    uint64_t tail = ring_tail_.load(std::memory_order_relaxed);
+
+    for (int i = 0; i < spin_limit_; ++i)
+    {
+        if (ring_head_.load(std::memory_order_acquire) != tail)
+        {
+            // spinning paid off, allow spinning a bit longer next time
+            spin_limit_ = std::min(spin_limit_ * 2, MAX_SPIN_LIMIT);
+            return true;
+        }
+        cpu_relax();
+    }
+
+    spin_limit_ = std::max(spin_limit_ / 2, MIN_SPIN_LIMIT);
+
+    std::unique_lock<std::mutex> lk(wait_mtx_);
+    processor_parked_.store(true);
+
+    // the receiver either sees the parked flag or we see the new head here
+    process_cond_.wait_for(lk, std::chrono::milliseconds(100), [this, tail] {
+        return should_stop_ || ring_head_.load() != tail;
+    });
 
-    UVG_LOG_DEBUG("Total processed packets: %li", processed_packets);
+    processor_parked_.store(false);
+
+    return !should_stop_ && ring_head_.load(std::memory_order_acquire) != tail;
 }
 
-ssize_t uvgrtp::reception_flow::next_buffer_location(ssize_t current_location)
+void uvgrtp::reception_flow::process_packet(int rce_flags)
 {
-/*
-#ifndef NDEBUG
-    if (current_location + 1 == ring_buffer_.size())
+    while (!should_stop_)
     {
-        ssize_t read = ring_read_index_;
-        ssize_t write = last_ring_write_index_;
-        UVG_LOG_DEBUG("Ring buffer (%lli) rotation. R: %lli, W: %lli", ring_buffer_.size(), read, write);
+        if (wait_for_packets())
+        {
+            process_available_packets(rce_flags);
+        }
     }
-#endif // !NDEBUG
-*/
 
-    // rotates to beginning after buffer end
-    return (current_location + 1) % ring_buffer_.size();
+    UVG_LOG_DEBUG("Total processed packets: %llu", (unsigned long long)processed_packets_);
 }
 
-void uvgrtp::reception_flow::increase_buffer_size(ssize_t next_write_index)
+void uvgrtp::reception_flow::process_available_packets(int rce_flags)
 {
-    // create new buffer spaces if the process/read hasn't freed any spots on the ring buffer
-    if (next_write_index == ring_read_index_)
+    const size_t size = ring_buffer_.size();
+    uint64_t head = ring_head_.load(std::memory_order_acquire);
+    uint64_t tail = ring_tail_.load(std::memory_order_relaxed);
+
+    // process all available reads in one go
+    for (; tail != head && !should_stop_; ++tail)
     {
-        // increase the buffer size by 25%
-        ssize_t increase = ring_buffer_.size() / 4;
-        if (increase == 0) // just so there is some increase
-            ++increase;
+        Buffer& slot = ring_buffer_[tail % size];
 
-        UVG_LOG_DEBUG("Reception buffer ran out, increasing the buffer size: %lli -> %lli",
-            ring_buffer_.size(), ring_buffer_.size() + increase);
-        for (unsigned int i = 0; i < increase; ++i)
+        if (slot.read > 0)
         {
-            ring_buffer_.insert(ring_buffer_.begin() + next_write_index, { new uint8_t[payload_size_] , -1 });
+            // a coalesced GRO read holds datagrams of "segment_size" bytes, only the last one may be shorter
+            int step = slot.segment_size > 0 ? slot.segment_size : slot.read;
+
+            for (int offset = 0; offset < slot.read; offset += step)
+            {
+                process_datagram(slot, slot.data + slot.offset + offset, std::min(step, slot.read - offset), rce_flags);
+                ++processed_packets_;
+            }
+
+            // frames may still point to this slot, in which case it gets new memory
+            if (rce_flags & RCE_ZERO_COPY_RECEIVE)
+            {
+                recycle_ring_buffer(slot);
+            }
         }
+        else
+        {
+            UVG_LOG_DEBUG("Found invalid frame in read buffer: %i", slot.read);
+        }
+
+        // to make sure we don't process this packet again and give the slot back to receiver
+        slot.read = 0;
+        ring_tail_.store(tail + 1, std::memory_order_release);
+    }
+}
+
+void uvgrtp::reception_flow::process_datagram(Buffer& slot, uint8_t* datagram, int size, int rce_flags)
+{
+    rtp_error_t ret = RTP_OK;
+
+    // process the ring buffer location through all the handlers
+    for (auto& handler : packet_handlers_) {
+        uvgrtp::frame::rtp_frame* frame = nullptr;
+
+        // The slot belongs to processor until the tail is moved past it
+        switch ((ret = (*handler.second.primary)(size, datagram, rce_flags, &frame))) {
+            case RTP_OK:
+            {
+                // packet was handled successfully
+                break;
+            }
+            case RTP_PKT_NOT_HANDLED:
+            {
+                // packet was not handled by this primary handlers, proceed to the next one
+                continue;
+                /* packet was handled by the primary handler
+                 * and should be dispatched to the auxiliary handler(s) */
+            }
+            case RTP_PKT_MODIFIED:
+            {
+                if (frame && !frame->arrival_ntp)
+                {
+                    frame->arrival_ntp = slot.arrival_ntp;
+                }
+
+                if (rce_flags & RCE_ZERO_COPY_RECEIVE)
+                {
+                    attach_ring_buffer(slot, datagram, frame);
+                }
 
-        // this works, because we have just added increase amount of spaces
-        ring_read_index_ += increase;
+                call_aux_handlers(handler.first, rce_flags, &frame);
+                break;
+            }
+            case RTP_GENERIC_ERROR:
+            {
+                UVG_LOG_DEBUG("Error in handling of received packet!");
+                break;
+            }
+            default:
+            {
+                UVG_LOG_ERROR("Unknown error code from packet handler: %d", ret);
+                break;
+            }
+        }
     }
-}
\ No newline at end of file
+}
@@ -2,6 +2,8 @@
 
 #include "uvgrtp/util.hh"
 
+#include "bounded_queue.hh"
+
 #include <mutex>
 #include <unordered_map>
 #include <vector>
@@ -10,15 +12,17 @@
 #include <thread>
 #include <condition_variable>
 #include <atomic>
-#include <deque>
 
 namespace uvgrtp {
 
     namespace frame {
         struct rtp_frame;
+        struct rx_buffer;
     }
 
     class socket;
+    class reactor;
+    class uring;
 
     typedef rtp_error_t (*packet_handler)(ssize_t, void *, int, uvgrtp::frame::rtp_frame **);
     typedef rtp_error_t (*packet_handler_aux)(void *, int, uvgrtp::frame::rtp_frame **);
@@ -82,7 +86,9 @@ namespace uvgrtp {
 
     class reception_flow{
         public:
-            reception_flow();
+            /* If "reactor" is given, the socket is served by the I/O threads of the reactor
+             * and reception flow does not create threads of its own */
+            reception_flow(std::shared_ptr<uvgrtp::reactor> reactor);
             ~reception_flow();
 
             /* Install a primary handler for an incoming UDP datagram
@@ -124,6 +130,9 @@ namespace uvgrtp {
             rtp_error_t install_receive_hook(void *arg, void (*hook)(void *, uvgrtp::frame::rtp_frame *));
 
             /* Start the RTP reception flow. Start querying for received packets and processing them.
+             *
+             * With a reactor, the socket is registered to it and packets are processed by the
+             * I/O thread that received them. If the registration fails, threads are used instead.
              *
              * Return RTP_OK on success
              * Return RTP_MEMORY_ERROR if allocation of a thread object fails */
@@ -146,58 +155,178 @@ namespace uvgrtp {
             uvgrtp::frame::rtp_frame *pull_frame();
             uvgrtp::frame::rtp_frame *pull_frame(ssize_t timeout_ms);
 
+            /* Set the maximum number of frames held for pull_frame(). If the frames are being
+             * processed, the queue is replaced by the processing thread when it returns the next frame
+             *
+             * Return RTP_OK on success
+             * Return RTP_INVALID_VALUE if "size" is zero */
+            rtp_error_t set_frame_queue_size(size_t size);
+
+            /* Set what is dropped when the frame queue is full, see RTP_FRAME_QUEUE_POLICY
+             *
+             * Return RTP_OK on success
+             * Return RTP_INVALID_VALUE if "policy" is not valid */
+            rtp_error_t set_frame_queue_policy(int policy);
+
+            /* Set the size of the ring buffer and the largest datagram it has to fit. The ring is allocated
+             * in start(). If packets are already being received, the receiving thread rebuilds the ring
+             * once all packets in it have been processed */
             void set_buffer_size(const ssize_t& value);
             void set_payload_size(const size_t& value);
 
         private:
+            struct Buffer
+            {
+                uint8_t* data;
+                int read;
+                uvgrtp::frame::rx_buffer* buffer; // owner of "data"
+                int segment_size; // size of the datagrams in a coalesced UDP GRO read, 0 otherwise
+                uint64_t arrival_ntp; // arrival time of the read as an NTP timestamp
+                int offset; // start of the read in "data", io_uring writes a header in front of it
+            };
+
             /* RTP packet receiver thread */
-            void receiver(std::shared_ptr<uvgrtp::socket> socket);
+            void receiver(std::shared_ptr<uvgrtp::socket> socket, int rce_flags);
+
+            /* RTP packet receiver thread for RCE_IO_URING. Keeps a multishot recvmsg armed which
+             * reads the packets directly to the ring buffer slots, given to the kernel as provided buffers.
+             * The kernel writes the UDP GRO segment size and receive timestamp in front of each read */
+            void receiver_uring(std::shared_ptr<uvgrtp::socket> socket, int rce_flags);
+
+            /* Set up "uring_" for receiving to the ring buffer
+             *
+             * Return RTP_OK on success
+             * Return RTP_NOT_SUPPORTED if io_uring cannot be used */
+            rtp_error_t create_uring();
+
+            /* Read packets from "socket" to the ring buffer in batches until the socket has been drained.
+             * With RCE_RUN_TO_COMPLETION each batch is also processed by the calling thread
+             *
+             * Return RTP_OK on success
+             * Return RTP_GENERIC_ERROR if reading the socket failed */
+            rtp_error_t read_socket(std::shared_ptr<uvgrtp::socket> socket, int rce_flags);
+
+            void log_receive_statistics(int rce_flags);
 
             /* RTP packet dispatcher thread */
             void process_packet(int rce_flags);
 
+            /* Run all packets published to the ring buffer through the packet handlers */
+            void process_available_packets(int rce_flags);
+
+            /* Run one datagram of a ring buffer slot through the packet handlers. A slot holds several
+             * datagrams if UDP GRO has coalesced them, "datagram" points to the one to be processed */
+            void process_datagram(Buffer& slot, uint8_t* datagram, int size, int rce_flags);
+
             /* Return a processed RTP frame to user either through frame queue or receive hook */
             void return_frame(uvgrtp::frame::rtp_frame *frame);
 
             /* Call auxiliary handlers of a primary handler */
             void call_aux_handlers(uint32_t key, int rce_flags, uvgrtp::frame::rtp_frame **frame);
 
-            inline void increase_buffer_size(ssize_t next_write_index);
-
             /* Primary handlers for the socket */
             std::unordered_map<uint32_t, packet_handlers> packet_handlers_;
 
-            inline ssize_t next_buffer_location(ssize_t current_location);
+            /* Block the processor until the receiver has published packets to the ring buffer.
+             * The processor first spins for a while since packets tend to arrive in bursts
+             * and only parks itself on the condition variable if nothing arrives.
+             *
+             * Return true if there are packets to process
+             * Return false if the wait timed out or reception flow is stopping */
+            bool wait_for_packets();
+
+            /* Wake up the processor if it has parked itself */
+            void wake_processor();
 
-            void create_ring_buffer();
+            /* Allocate the slots of the ring buffer from one contiguous region. The old ring is
+             * released only if the allocation succeeds */
+            rtp_error_t create_ring_buffer();
             void destroy_ring_buffer();
 
+            /* Called by the receiving thread to apply a new ring buffer size at a point where
+             * the processor is not using the ring */
+            void apply_ring_resize();
+
+            /* Give the frame a reference to the ring buffer slot its payload points to (RCE_ZERO_COPY_RECEIVE) */
+            void attach_ring_buffer(Buffer& slot, uint8_t* datagram, uvgrtp::frame::rtp_frame* frame);
+
+            /* Replace the memory of a ring buffer slot if a frame still references it */
+            void recycle_ring_buffer(Buffer& slot);
+
             void clear_frames();
 
+            /* Take a frame from the frame queue, waiting at most "timeout_ms" for one to arrive
+             *
+             * Return the frame on success
+             * Return nullptr if there were no frames or reception flow is stopping */
+            uvgrtp::frame::rtp_frame *wait_for_frame(ssize_t timeout_ms);
+
+            /* Replace the frame queue if its size has been changed. Must be called by the thread returning frames */
+            void resize_frame_queue();
+
+            /* Pop a frame from the current frame queue. Return false if the queue is empty */
+            bool pop_frame(uvgrtp::frame::rtp_frame*& frame);
+
+            /* Free the replaced frame queues if no application thread can be popping from them anymore */
+            void free_retired_frame_queues();
+
             /* If receive hook has not been installed, frames are pushed to "frames_"
-             * and they can be retrieved using pull_frame() */
-            std::deque<uvgrtp::frame::rtp_frame *> frames_;
-            std::mutex frames_mtx_;
+             * and they can be retrieved using pull_frame(). When the queue is resized, the old queue
+             * is moved to "retired_frame_queues_" and freed once "frame_queue_readers_" shows that
+             * no application thread may still be popping from it */
+            std::atomic<uvgrtp::bounded_queue<uvgrtp::frame::rtp_frame *> *> frames_;
+            std::unique_ptr<uvgrtp::bounded_queue<uvgrtp::frame::rtp_frame *>> frame_queue_;
+            std::vector<std::unique_ptr<uvgrtp::bounded_queue<uvgrtp::frame::rtp_frame *>>> retired_frame_queues_;
+            std::atomic<int> frame_queue_readers_;
+            std::atomic<size_t> pending_frame_queue_size_;
+            std::atomic<int> frame_queue_policy_;
+            std::atomic<uint64_t> dropped_frames_;
+
+            // pull_frame() parks here when the frame queue is empty
+            std::mutex pull_mtx_;
+            std::condition_variable pull_cond_;
+            std::atomic<int> pull_waiters_;
 
             void *recv_hook_arg_;
             void (*recv_hook_)(void *arg, uvgrtp::frame::rtp_frame *frame);
 
-            bool should_stop_;
+            std::atomic<bool> should_stop_;
 
             std::unique_ptr<std::thread> receiver_;
             std::unique_ptr<std::thread> processor_;
 
-            struct Buffer
-            {
-                uint8_t* data;
-                int read;
-            };
+            // context-level I/O reactor serving the socket instead of the threads above
+            std::shared_ptr<uvgrtp::reactor> reactor_;
+            uint64_t reactor_key_;
+
+            // io_uring instance of receiver_uring()
+            std::unique_ptr<uvgrtp::uring> uring_;
 
             std::vector<Buffer> ring_buffer_;
 
-            // these uphold the ring buffer details
-            std::atomic<ssize_t> ring_read_index_;
-            std::atomic<ssize_t> last_ring_write_index_;
+            /* Single-producer single-consumer positions of the ring buffer. Receiver thread owns the head
+             * and processor thread owns the tail. Both increase monotonically and the slot is
+             * position % ring_buffer_.size(), so head - tail is the number of unprocessed packets.
+             * They are kept on separate cache lines so that the threads don't invalidate each other's cache */
+            alignas(UVGRTP_CACHE_LINE_SIZE) std::atomic<uint64_t> ring_head_;
+            alignas(UVGRTP_CACHE_LINE_SIZE) std::atomic<uint64_t> ring_tail_;
+
+            alignas(UVGRTP_CACHE_LINE_SIZE) std::atomic<bool> processor_parked_;
+
+            // set_buffer_size() or set_payload_size() was called while receiving
+            std::atomic<bool> ring_resize_pending_;
+
+            // how many times the processor spins before parking, adapted to the packet rate
+            int spin_limit_;
+
+            // how many times the receiver found the ring buffer full
+            uint64_t ring_overruns_;
+
+            // receive statistics
+            uint64_t received_packets_;
+            uint64_t receive_batches_;
+            unsigned int largest_batch_;
+            uint64_t processed_packets_;
 
             std::mutex wait_mtx_; // for waking up the processing thread (read)
 
@@ -205,6 +334,18 @@ namespace uvgrtp {
 
             ssize_t buffer_size_kbytes_;
             size_t payload_size_;
+
+            // is UDP GRO enabled for the socket, in which case each slot fits a coalesced read
+            bool gro_;
+
+            // does the socket report kernel receive timestamps
+            bool timestamps_;
+
+            // size of the memory of each ring buffer slot
+            size_t slot_size_;
+
+            // room reserved in each slot in front of the read, used by the io_uring receiver
+            size_t slot_headroom_;
     };
 }
 
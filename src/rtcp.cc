@@ -6,6 +6,7 @@
 #include "socket.hh"
 #include "hostname.hh"
 #include "poll.hh"
+#include "reactor.hh"
 #include "rtp.hh"
 #include "debug.hh"
 #include "srtp/srtcp.hh"
@@ -16,6 +17,8 @@
 
 #ifndef _WIN32
 #include <sys/time.h>
+#else
+#define MSG_DONTWAIT 0
 #endif
 
 #include <cassert>
@@ -56,6 +59,9 @@ uvgrtp::rtcp::rtcp(std::shared_ptr<uvgrtp::rtp> rtp, std::shared_ptr<std::atomic
     sdes_hook_u_(nullptr),
     app_hook_f_(nullptr),
     app_hook_u_(nullptr),
+    reactor_(nullptr),
+    reactor_keys_(),
+    reactor_buffer_(nullptr),
     active_(false),
     interval_ms_(DEFAULT_RTCP_INTERVAL_MS),
     ourItems_(),
@@ -188,7 +194,7 @@ void uvgrtp::rtcp::free_participant(std::unique_ptr<rtcp_participant> participan
     }
 }
 
-rtp_error_t uvgrtp::rtcp::start()
+rtp_error_t uvgrtp::rtcp::start(std::shared_ptr<uvgrtp::reactor> reactor)
 {
     if (sockets_.empty())
     {
@@ -197,11 +203,98 @@ rtp_error_t uvgrtp::rtcp::start()
     }
     active_ = true;
 
+    if (reactor)
+    {
+        reactor_ = reactor;
+
+        if (start_on_reactor() == RTP_OK)
+        {
+            return RTP_OK;
+        }
+
+        UVG_LOG_WARN("Failed to register RTCP to the reactor, creating the RTCP runner thread instead");
+    }
+
     report_generator_.reset(new std::thread(rtcp_runner, this, interval_ms_));
 
     return RTP_OK;
 }
 
+rtp_error_t uvgrtp::rtcp::start_on_reactor()
+{
+    UVG_LOG_INFO("RTCP instance created on the reactor! RTCP interval: %u ms", interval_ms_);
+
+    reactor_buffer_ = std::unique_ptr<uint8_t[]>(new uint8_t[MAX_PACKET]);
+
+    // RFC 3550 says to wait half interval before sending first report
+    uint64_t timer_key = reactor_->add_timer(interval_ms_ / 2, interval_ms_, [this]() {
+        rtp_error_t ret = generate_report();
+
+        if (ret != RTP_OK && ret != RTP_NOT_READY)
+        {
+            UVG_LOG_ERROR("Failed to send RTCP status report!");
+        }
+        return RTP_OK;
+    });
+
+    if (timer_key)
+    {
+        reactor_keys_.push_back(timer_key);
+
+        // the sockets are served by the same thread as the timer, so reports and packets are not handled at the same time
+        for (auto& socket : sockets_)
+        {
+            uvgrtp::socket *sock = socket.get();
+            uint64_t key = reactor_->add_source(sock->get_raw_socket(), [this, sock]() {
+                return read_socket(*sock);
+            }, timer_key);
+
+            if (!key)
+                break;
+
+            reactor_keys_.push_back(key);
+        }
+
+        if (reactor_keys_.size() == sockets_.size() + 1)
+        {
+            return RTP_OK;
+        }
+    }
+
+    for (auto key : reactor_keys_)
+    {
+        reactor_->remove_source(key);
+    }
+    reactor_keys_.clear();
+
+    return RTP_GENERIC_ERROR;
+}
+
+rtp_error_t uvgrtp::rtcp::read_socket(uvgrtp::socket& socket)
+{
+    while (true)
+    {
+        int nread = 0;
+        rtp_error_t ret = socket.recv(reactor_buffer_.get(), MAX_PACKET, MSG_DONTWAIT, &nread);
+
+        if (ret == RTP_INTERRUPTED)
+        {
+            return RTP_OK;
+        }
+
+        if (ret != RTP_OK)
+        {
+            UVG_LOG_ERROR("Failed to read an RTCP socket, %d", ret);
+            return ret;
+        }
+
+        if (nread > 0)
+        {
+            (void)handle_incoming_packet(reactor_buffer_.get(), (size_t)nread);
+        }
+    }
+}
+
 rtp_error_t uvgrtp::rtcp::stop()
 {
     UVG_LOG_DEBUG("Stopping RTCP");
@@ -221,6 +314,13 @@ rtp_error_t uvgrtp::rtcp::stop()
         report_generator_->join();
     }
 
+    // returns once the callbacks are no longer running
+    for (auto key : reactor_keys_)
+    {
+        reactor_->remove_source(key);
+    }
+    reactor_keys_.clear();
+
     /* when the member count is less than 50,
      * we can just send the BYE message and destroy the session */
     if (members_ >= 50)
@@ -851,7 +951,8 @@ rtp_error_t uvgrtp::rtcp::init_new_participant(const uvgrtp::frame::rtp_frame *f
     /* This is the first RTP frame from remote to frame->header.timestamp represents t = 0
      * Save the timestamp and current NTP timestamp so we can do jitter calculations later on */
     participants_[frame->header.ssrc]->stats.initial_rtp = frame->header.timestamp;
-    participants_[frame->header.ssrc]->stats.initial_ntp = uvgrtp::clock::ntp::now();
+    participants_[frame->header.ssrc]->stats.initial_ntp = frame->arrival_ntp ?
+        frame->arrival_ntp : uvgrtp::clock::ntp::now();
     participants_mutex_.unlock();
 
     senders_++;
@@ -1001,10 +1102,12 @@ void uvgrtp::rtcp::update_session_statistics(const uvgrtp::frame::rtp_frame *fra
     int dropped = expected - participants_[frame->header.ssrc]->stats.received_pkts;
     participants_[frame->header.ssrc]->stats.dropped_pkts = dropped >= 0 ? dropped : 0;
 
-    // the arrival time expressed as an RTP timestamp
+    /* The arrival time expressed as an RTP timestamp. The kernel receive timestamp of the packet
+     * is used so that queuing in uvgRTP does not show up as jitter */
+    uint64_t arrival_ntp = frame->arrival_ntp ? frame->arrival_ntp : uvgrtp::clock::ntp::now();
     uint32_t arrival = participants_[frame->header.ssrc]->stats.initial_rtp +
-        (uint32_t)uvgrtp::clock::ntp::diff_now(participants_[frame->header.ssrc]->stats.initial_ntp)*
-        (participants_[frame->header.ssrc]->stats.clock_rate / 1000);
+        (uint32_t)uvgrtp::clock::ntp::diff_clock(participants_[frame->header.ssrc]->stats.initial_ntp,
+            arrival_ntp, participants_[frame->header.ssrc]->stats.clock_rate);
 
     // calculate interarrival jitter. See RFC 3550 A.8
     uint32_t transit = arrival - frame->header.timestamp; // A.8: int transit = arrival - r->ts
@@ -1114,8 +1217,7 @@ rtp_error_t uvgrtp::rtcp::handle_incoming_packet(uint8_t *buffer, size_t size)
     if (size > RTCP_HEADER_SIZE + SSRC_CSRC_SIZE)
     {
         sender_ssrc = ntohl(*(uint32_t*)& buffer[read_ptr + RTCP_HEADER_SIZE]);
-        if (srtcp_ && (ret = srtcp_->handle_rtcp_decryption(rce_flags_, sender_ssrc, 
-            buffer + RTCP_HEADER_SIZE + SSRC_CSRC_SIZE, size)) != RTP_OK)
+        if (srtcp_ && (ret = srtcp_->handle_rtcp_decryption(rce_flags_, sender_ssrc, buffer, size)) != RTP_OK)
         {
             UVG_LOG_ERROR("Failed at decryption");
             return ret;
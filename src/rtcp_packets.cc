@@ -19,7 +19,7 @@ uint32_t uvgrtp::get_rr_packet_size(int rce_flags, uint16_t reports)
         + (size_t)REPORT_BLOCK_SIZE * reports;
     if (rce_flags & RCE_SRTP)
     {
-        size += UVG_SRTCP_INDEX_LENGTH + UVG_AUTH_TAG_LENGTH;
+        size += UVG_SRTCP_INDEX_LENGTH + (uint32_t)srtp_auth_tag_length(rce_flags);
     }
 
     return size;
@@ -4,7 +4,7 @@
 
 #include "debug.hh"
 #include "random.hh"
-#include "memory.hh"
+#include "pool.hh"
 
 #include "global.hh"
 
@@ -14,6 +14,7 @@
 #endif
 
 #include <chrono>
+#include <cstring>
 
 #define INVALID_TS UINT64_MAX
 
@@ -29,7 +30,8 @@ uvgrtp::rtp::rtp(rtp_format_t fmt, std::shared_ptr<std::atomic<std::uint32_t>> s
     sent_pkts_(0),
     timestamp_(INVALID_TS),
     payload_size_(MAX_IPV4_MEDIA_PAYLOAD),
-    delay_(PKT_MAX_DELAY_MS)
+    delay_(PKT_MAX_DELAY_MS),
+    reassembly_limit_(REASSEMBLY_MEMORY_LIMIT)
 {
     set_default_clock_rate(fmt);
 }
@@ -204,9 +206,21 @@ size_t uvgrtp::rtp::get_pkt_max_delay() const
     return delay_;
 }
 
+void uvgrtp::rtp::set_reassembly_limit(size_t limit)
+{
+    reassembly_limit_ = limit;
+}
+
+size_t uvgrtp::rtp::get_reassembly_limit() const
+{
+    return reassembly_limit_;
+}
+
 rtp_error_t uvgrtp::rtp::packet_handler(ssize_t size, void *packet, int rce_flags, uvgrtp::frame::rtp_frame **out)
 {
-    (void)rce_flags;
+    /* With zero-copy reception the payload and extension data are not copied out of the datagram.
+     * Reception flow attaches the receive buffer to the frame which keeps the datagram alive */
+    bool zero_copy = rce_flags & RCE_ZERO_COPY_RECEIVE;
 
     /* not an RTP frame */
     if (size < 12)
@@ -257,7 +271,7 @@ rtp_error_t uvgrtp::rtp::packet_handler(ssize_t size, void *packet, int rce_flag
         }
         UVG_LOG_DEBUG("Allocating %u CSRC entries", (*out)->header.cc);
 
-        (*out)->csrc         = new uint32_t[(*out)->header.cc];
+        (*out)->csrc         = uvgrtp::frame::alloc_csrc(*out);
         (*out)->payload_len -= (*out)->header.cc * sizeof(uint32_t);
 
         for (size_t i = 0; i < (*out)->header.cc; ++i) {
@@ -268,11 +282,12 @@ rtp_error_t uvgrtp::rtp::packet_handler(ssize_t size, void *packet, int rce_flag
 
     if ((*out)->header.ext) {
         UVG_LOG_DEBUG("Frame contains extension information");
-        (*out)->ext = new uvgrtp::frame::ext_header;
+        (*out)->ext = uvgrtp::frame::alloc_ext(*out);
 
         (*out)->ext->type    = ntohs(*(uint16_t *)&ptr[0]);
         (*out)->ext->len     = ntohs(*(uint16_t *)&ptr[2]) * sizeof(uint32_t);
-        (*out)->ext->data    = (uint8_t *)memdup(ptr + 2 * sizeof(uint16_t), (*out)->ext->len);
+        (*out)->ext->data    = zero_copy ? ptr + 2 * sizeof(uint16_t) :
+                               uvgrtp::frame::dup_ext_data(*out, ptr + 2 * sizeof(uint16_t), (*out)->ext->len);
         (*out)->payload_len -= 2 * sizeof(uint16_t) + (*out)->ext->len;
         ptr                 += 2 * sizeof(uint16_t) + (*out)->ext->len;
     }
@@ -282,9 +297,12 @@ rtp_error_t uvgrtp::rtp::packet_handler(ssize_t size, void *packet, int rce_flag
      * valid and subtract the amount of padding bytes from payload length */
     if ((*out)->header.padding) {
         UVG_LOG_DEBUG("Frame contains padding");
-        uint8_t padding_len = (*out)->payload[(*out)->payload_len - 1];
+        uint8_t padding_len = ptr[(*out)->payload_len - 1];
 
         if (!padding_len || (*out)->payload_len <= padding_len) {
+            if (zero_copy && (*out)->ext)
+                (*out)->ext->data = nullptr;
+
             uvgrtp::frame::dealloc_frame(*out);
             return RTP_GENERIC_ERROR;
         }
@@ -293,7 +311,12 @@ rtp_error_t uvgrtp::rtp::packet_handler(ssize_t size, void *packet, int rce_flag
         (*out)->padding_len  = padding_len;
     }
 
-    (*out)->payload    = (uint8_t *)memdup(ptr, (*out)->payload_len);
+    if (zero_copy)
+        (*out)->payload = ptr;
+    else
+        std::memcpy(uvgrtp::frame::alloc_payload(*out, (*out)->payload_len, uvgrtp::frame::PAYLOAD_HEADROOM),
+            ptr, (*out)->payload_len);
+
     (*out)->dgram      = (uint8_t *)packet;
     (*out)->dgram_size = size;
 
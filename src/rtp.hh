@@ -24,6 +24,7 @@ namespace uvgrtp {
             uint32_t     get_clock_rate()    const;
             size_t       get_payload_size()  const;
             size_t       get_pkt_max_delay() const;
+            size_t       get_reassembly_limit() const;
             rtp_format_t get_payload()       const;
 
             void inc_sent_pkts();
@@ -35,6 +36,7 @@ namespace uvgrtp {
             void set_timestamp(uint64_t timestamp);
             void set_payload_size(size_t payload_size);
             void set_pkt_max_delay(size_t delay);
+            void set_reassembly_limit(size_t limit);
 
             void fill_header(uint8_t *buffer);
             void update_sequence(uint8_t *buffer);
@@ -70,6 +72,10 @@ namespace uvgrtp {
              *
              * Default value is 100ms */
             size_t delay_;
+
+            /* How many bytes of fragments the receiver may hold while waiting
+             * for the rest of the fragments of generic frames */
+            size_t reassembly_limit_;
     };
 }
 
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "uvgrtp/util.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace uvgrtp {
+    namespace frame {
+
+        /* Reference counted datagram buffer used by the reception ring
+         *
+         * With RCE_ZERO_COPY_RECEIVE, the payload of a received rtp_frame points directly
+         * into one of these buffers. The ring holds one reference to the buffer and each frame
+         * that points into it holds another. The memory is released when the last reference is dropped
+         * so the ring can move on to a new buffer while frames or fragments are still in use. */
+        struct rx_buffer {
+            uint8_t *data = nullptr;
+            size_t size = 0;
+            std::atomic<uint32_t> refs{1};
+
+            /* Buffers carved from a region hold a reference to the region instead of owning "data" */
+            rx_buffer *parent = nullptr;
+
+            /* Non-zero if this buffer is a region, in which case it is the size of the allocation
+             * that holds both the buffer headers and the memory */
+            size_t region_size = 0;
+            bool mapped = false;
+        };
+
+        /* Allocate a buffer with "size" bytes of memory, the reference count is initialized to one
+         *
+         * Return pointer to buffer on success
+         * Return nullptr if allocation failed */
+        rx_buffer *alloc_rx_buffer(size_t size);
+
+        /* Allocate "count" buffers of "size" bytes from one contiguous region and write them to "buffers"
+         *
+         * Each buffer starts at a cache line boundary and has a reference count of one. The region is
+         * mapped with huge pages if the system has them reserved and otherwise transparent huge pages
+         * are requested for it. The region is freed once all of its buffers have been released
+         *
+         * Return true on success
+         * Return false if allocation failed */
+        bool alloc_rx_region(size_t count, size_t size, std::vector<rx_buffer *>& buffers);
+
+        /* Add a reference to "buffer" */
+        void retain_rx_buffer(rx_buffer *buffer);
+
+        /* Drop a reference to "buffer" and free it if it was the last one */
+        void release_rx_buffer(rx_buffer *buffer);
+
+        /* Return true if the caller holds the only reference to "buffer" */
+        bool rx_buffer_unique(const rx_buffer *buffer);
+
+        struct rtp_frame;
+
+        /* Copy the payload and extension data of a zero-copy frame to memory owned by the frame
+         * and drop its reference to the receive buffer. Does nothing if "frame" owns its memory */
+        void detach_rx_buffer(rtp_frame *frame);
+    }
+}
+
+namespace uvg_rtp = uvgrtp;
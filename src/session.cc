@@ -7,24 +7,27 @@
 #include "debug.hh"
 
 
-uvgrtp::session::session(std::string cname, std::string addr) :
+uvgrtp::session::session(std::string cname, std::string addr, std::shared_ptr<uvgrtp::reactor> reactor) :
 #ifdef __RTP_CRYPTO__
     zrtp_(new uvgrtp::zrtp()),
 #endif
     generic_address_(addr),
     remote_address_(""),
     local_address_(""),
-    cname_(cname)
+    cname_(cname),
+    reactor_(reactor)
 {}
 
-uvgrtp::session::session(std::string cname, std::string remote_addr, std::string local_addr):
+uvgrtp::session::session(std::string cname, std::string remote_addr, std::string local_addr,
+    std::shared_ptr<uvgrtp::reactor> reactor):
 #ifdef __RTP_CRYPTO__
     zrtp_(new uvgrtp::zrtp()),
 #endif
     generic_address_(""),
     remote_address_(remote_addr),
     local_address_(local_addr),
-    cname_(cname)
+    cname_(cname),
+    reactor_(reactor)
 {}
 
 uvgrtp::session::~session()
@@ -101,8 +104,12 @@ uvgrtp::media_stream* uvgrtp::session::create_stream(uint16_t src_port, uint16_t
         return  nullptr;
     }
 
+    // replay protection relies on the authentication tag
+    if ((rce_flags & RCE_SRTP) && (rce_flags & RCE_SRTP_REPLAY_PROTECTION))
+        rce_flags |= RCE_SRTP_AUTHENTICATE_RTP;
+
     uvgrtp::media_stream* stream =
-        new uvgrtp::media_stream(cname_, remote_address_, local_address_, src_port, dst_port, fmt, rce_flags);
+        new uvgrtp::media_stream(cname_, remote_address_, local_address_, src_port, dst_port, fmt, rce_flags, reactor_);
 
     if (rce_flags & RCE_SRTP) {
         if (!uvgrtp::crypto::enabled()) {
@@ -112,9 +119,6 @@ uvgrtp::media_stream* uvgrtp::session::create_stream(uint16_t src_port, uint16_t
             return nullptr;
         }
 
-        if (rce_flags & RCE_SRTP_REPLAY_PROTECTION)
-            rce_flags |= RCE_SRTP_AUTHENTICATE_RTP;
-
         if (rce_flags & RCE_SRTP_KMNGMNT_ZRTP) {
 
             if (rce_flags & (RCE_SRTP_KEYSIZE_192 | RCE_SRTP_KEYSIZE_256)) {
@@ -1,9 +1,12 @@
 #include "socket.hh"
 
 #include "uvgrtp/util.hh"
+#include "uvgrtp/clock.hh"
 
 #include "debug.hh"
 #include "memory.hh"
+#include "uring.hh"
+#include "thread_pool.hh"
 
 #include <thread>
 
@@ -15,6 +18,8 @@
 #include <unistd.h>
 #include <poll.h>
 #include <fcntl.h>
+#include <netinet/udp.h>
+#include <climits>
 #endif
 
 #if defined(__MINGW32__) || defined(__MINGW64__)
@@ -25,6 +30,7 @@ using namespace mingw;
 
 #include <cstring>
 #include <cassert>
+#include <algorithm>
 
 
 #define WSABUF_SIZE 256
@@ -38,8 +44,15 @@ uvgrtp::socket::socket(int rce_flags):
     buffers_()
 #else
     header_(),
-    chunks_()
+    chunks_(),
+    recv_headers_(),
+    recv_chunks_(),
+    recv_control_(),
 #endif
+    send_ring_(nullptr),
+    send_ring_mtx_(),
+    stale_send_completions_(0),
+    gso_(false)
 {}
 
 uvgrtp::socket::~socket()
@@ -74,6 +87,41 @@ rtp_error_t uvgrtp::socket::init(short family, int type, int protocol)
     WSAIoctl(socket_, _WSAIOW(IOC_VENDOR, 12), &bNewBehavior, sizeof(bNewBehavior), NULL, 0, &dwBytesReturned, NULL, NULL);
 #endif
 
+    if ((rce_flags_ & RCE_IO_URING) && !(rce_flags_ & RCE_RECEIVE_ONLY))
+    {
+        send_ring_ = std::unique_ptr<uvgrtp::uring>(new uvgrtp::uring());
+
+        if (send_ring_->init(MAX_URING_SEND_BATCH, MAX_URING_SEND_BATCH) != RTP_OK)
+        {
+            UVG_LOG_WARN("io_uring is not available, sending packets with sendmmsg()");
+            send_ring_ = nullptr;
+        }
+    }
+
+    if ((rce_flags_ & RCE_UDP_GSO) && !(rce_flags_ & RCE_RECEIVE_ONLY))
+    {
+#ifdef UDP_SEGMENT
+        // kernels without UDP GSO do not know the socket option
+        int segment_size = 0;
+        socklen_t optlen = sizeof(segment_size);
+
+        if (send_ring_)
+        {
+            UVG_LOG_WARN("RCE_UDP_GSO is not supported with RCE_IO_URING, sending without GSO");
+        }
+        else if (::getsockopt(socket_, SOL_UDP, UDP_SEGMENT, &segment_size, &optlen) == 0)
+        {
+            gso_ = true;
+        }
+        else
+        {
+            UVG_LOG_WARN("UDP GSO is not available, sending packets with sendmmsg()");
+        }
+#else
+        UVG_LOG_WARN("UDP GSO is not supported on this platform");
+#endif
+    }
+
     return RTP_OK;
 }
 
@@ -201,6 +249,23 @@ rtp_error_t uvgrtp::socket::install_handler(void *arg, packet_handler_vec handle
     return RTP_OK;
 }
 
+rtp_error_t uvgrtp::socket::install_handler(void *arg, packet_handler_vec handler,
+    packet_handler_prepare prepare, packet_handler_batch batch)
+{
+    if (!handler || !prepare || !batch)
+        return RTP_INVALID_VALUE;
+
+    socket_packet_handler hndlr;
+
+    hndlr.arg = arg;
+    hndlr.handler = handler;
+    hndlr.prepare = prepare;
+    hndlr.batch = batch;
+    vec_handlers_.push_back(hndlr);
+
+    return RTP_OK;
+}
+
 rtp_error_t uvgrtp::socket::__sendto(sockaddr_in& addr, uint8_t *buf, size_t buf_len, int send_flags, int *bytes_sent)
 {
     int nsend = 0;
@@ -389,7 +454,7 @@ rtp_error_t uvgrtp::socket::sendto(
 
 rtp_error_t uvgrtp::socket::__sendtov(
     sockaddr_in& addr,
-    uvgrtp::pkt_vec& buffers,
+    uvgrtp::buf_vec *packets, size_t count,
     int send_flags, int *bytes_sent
 )
 {
@@ -398,26 +463,59 @@ rtp_error_t uvgrtp::socket::__sendtov(
 
 #ifndef _WIN32
 
-    struct mmsghdr *headers = new struct mmsghdr[buffers.size()];
-    struct mmsghdr *hptr = headers;
+    std::unique_ptr<send_descriptor> desc = acquire_send_descriptor();
 
-    for (size_t i = 0; i < buffers.size(); ++i) {
-        headers[i].msg_hdr.msg_iov        = new struct iovec[buffers[i].size()];
-        headers[i].msg_hdr.msg_iovlen     = buffers[i].size();
+    size_t total_chunks = 0;
+    for (size_t p = 0; p < count; ++p) {
+        total_chunks += packets[p].size();
+    }
+
+    // the headers point to the chunks so they must not be reallocated while filling them
+    if (desc->headers.size() < count)
+        desc->headers.resize(count);
+    if (desc->chunks.size() < total_chunks)
+        desc->chunks.resize(total_chunks);
+
+    struct mmsghdr *headers = desc->headers.data();
+    struct mmsghdr *hptr    = headers;
+    struct iovec   *chunks  = desc->chunks.data();
+
+    for (size_t i = 0; i < count; ++i) {
+        headers[i].msg_hdr.msg_iov        = chunks;
+        headers[i].msg_hdr.msg_iovlen     = packets[i].size();
         headers[i].msg_hdr.msg_name       = (void *)&addr;
         headers[i].msg_hdr.msg_namelen    = sizeof(addr);
         headers[i].msg_hdr.msg_control    = 0;
         headers[i].msg_hdr.msg_controllen = 0;
+        headers[i].msg_hdr.msg_flags      = 0;
 
-        for (size_t k = 0; k < buffers[i].size(); ++k) {
-            headers[i].msg_hdr.msg_iov[k].iov_len   = buffers[i][k].first;
-            headers[i].msg_hdr.msg_iov[k].iov_base  = buffers[i][k].second;
-            sent_bytes                             += buffers[i][k].first;
+        for (size_t k = 0; k < packets[i].size(); ++k) {
+            chunks[k].iov_len   = packets[i][k].first;
+            chunks[k].iov_base  = packets[i][k].second;
+            sent_bytes         += packets[i][k].first;
         }
+        chunks += packets[i].size();
     }
 
     ssize_t npkts = (rce_flags_ & RCE_SYSTEM_CALL_CLUSTERING) ? 1024 : 1;
-    ssize_t bptr  = buffers.size();
+    ssize_t bptr  = count;
+
+    if (send_ring_) {
+        return_value = send_linked(headers, count, send_flags);
+        bptr = 0;
+    } else if (gso_) {
+        size_t packets_sent = 0;
+        return_value = send_segmented(*desc, count, send_flags, &packets_sent);
+
+        // if GSO was rejected, the rest of the packets are sent with sendmmsg()
+        if (return_value == RTP_NOT_SUPPORTED) {
+            return_value = RTP_OK;
+            hptr += packets_sent;
+            bptr -= packets_sent;
+        } else {
+            bptr = 0;
+        }
+    }
 
     while (bptr > npkts) {
         if (sendmmsg(socket_, hptr, npkts, send_flags) < 0) {
@@ -430,7 +528,7 @@ rtp_error_t uvgrtp::socket::__sendtov(
         hptr += npkts;
     }
 
-    if (return_value == RTP_OK)
+    if (return_value == RTP_OK && bptr > 0)
     {
         if (sendmmsg(socket_, hptr, bptr, send_flags) < 0) {
             log_platform_error("sendmmsg(2) failed");
@@ -438,20 +536,14 @@ rtp_error_t uvgrtp::socket::__sendtov(
         }
     }
 
-    for (size_t i = 0; i < buffers.size(); ++i)
-    {
-        if (headers[i].msg_hdr.msg_iov)
-        {
-            delete[] headers[i].msg_hdr.msg_iov;
-        }
-    }
-    delete[] headers;
+    release_send_descriptor(std::move(desc));
 
 #else
     INT ret = 0;
     WSABUF wsa_bufs[WSABUF_SIZE];
 
-    for (auto& buffer : buffers) {
+    for (size_t p = 0; p < count; ++p) {
+        buf_vec& buffer = packets[p];
 
         if (buffer.size() > WSABUF_SIZE) {
             UVG_LOG_ERROR("Input vector to __sendtov() has more than %u elements!", WSABUF_SIZE);
@@ -504,49 +596,274 @@ send_:
 #endif
 
 #ifndef NDEBUG
-    sent_packets_ += buffers.size();
+    sent_packets_ += count;
 #endif // !NDEBUG
 
     set_bytes(bytes_sent, sent_bytes);
     return return_value;
 }
 
-rtp_error_t uvgrtp::socket::sendto(pkt_vec& buffers, int send_flags)
+#ifndef _WIN32
+rtp_error_t uvgrtp::socket::send_linked(struct mmsghdr *headers, size_t count, int send_flags)
 {
-    rtp_error_t ret = RTP_OK;
+#ifdef UVGRTP_HAVE_IO_URING
+    std::lock_guard<std::mutex> lk(send_ring_mtx_);
 
-    for (auto& buffer : buffers) {
-        for (auto& handler : vec_handlers_) {
-            if ((ret = (*handler.handler)(handler.arg, buffer)) != RTP_OK) {
-                UVG_LOG_ERROR("Malformed packet");
-                return ret;
+    rtp_error_t return_value = RTP_OK;
+    struct io_uring_cqe cqe;
+
+    for (size_t sent = 0; sent < count;) {
+        unsigned int max_batch = (unsigned int)std::min(count - sent, (size_t)MAX_URING_SEND_BATCH);
+        unsigned int batch     = 0;
+        struct io_uring_sqe *prev = nullptr;
+
+        while (batch < max_batch) {
+            struct io_uring_sqe *sqe = send_ring_->get_sqe();
+
+            if (!sqe)
+                break;
+
+            sqe->opcode    = IORING_OP_SENDMSG;
+            sqe->fd        = socket_;
+            sqe->addr      = (uint64_t)(uintptr_t)&headers[sent + batch].msg_hdr;
+            sqe->len       = 1;
+            sqe->msg_flags = (uint32_t)send_flags;
+
+            // the link makes the kernel send the packets in order
+            if (prev)
+                prev->flags = IOSQE_IO_LINK;
+
+            prev = sqe;
+            ++batch;
+        }
+
+        if (!batch) {
+            UVG_LOG_ERROR("Failed to get an io_uring submission queue entry for sending");
+            return RTP_SEND_ERROR;
+        }
+
+        unsigned int completed    = 0;
+        unsigned int failed_waits = 0;
+        bool submit_failed        = false;
+
+        while (completed < batch) {
+            rtp_error_t ret = send_ring_->submit_and_wait(batch - completed + stale_send_completions_, -1);
+
+            if (ret != RTP_OK && ret != RTP_INTERRUPTED) {
+                /* The entries the kernel did not take are withdrawn, but the sends it did take
+                 * point to the caller's messages so they must complete before returning */
+                batch        -= send_ring_->discard_unsubmitted();
+                submit_failed = true;
+                return_value  = RTP_SEND_ERROR;
+
+                if (++failed_waits > MAX_URING_SEND_WAIT_FAILURES) {
+                    UVG_LOG_ERROR("Gave up waiting for %u io_uring sends", batch - completed);
+                    stale_send_completions_ += batch - completed;
+                    break;
+                }
+            }
+
+            while (send_ring_->next_completion(cqe)) {
+                // completions of an earlier call that gave up waiting for them
+                if (stale_send_completions_ > 0) {
+                    --stale_send_completions_;
+                    continue;
+                }
+
+                // if a send fails, the rest of the chain is cancelled
+                if (cqe.res < 0 && return_value == RTP_OK) {
+                    UVG_LOG_ERROR("Sending with io_uring failed: %s", strerror(-cqe.res));
+                    return_value = RTP_SEND_ERROR;
+                }
+                ++completed;
             }
         }
+
+        if (submit_failed)
+            break;
+
+        sent += batch;
     }
 
-    return __sendtov(remote_address_, buffers, send_flags, nullptr);
+    return return_value;
+#else
+    (void)headers;
+    (void)count;
+    (void)send_flags;
+    return RTP_NOT_SUPPORTED;
+#endif
 }
 
-rtp_error_t uvgrtp::socket::sendto(pkt_vec& buffers, int send_flags, int *bytes_sent)
+rtp_error_t uvgrtp::socket::send_segmented(send_descriptor& desc, size_t count, int send_flags, size_t *packets_sent)
 {
-    rtp_error_t ret = RTP_OK;
+    *packets_sent = 0;
 
-    for (auto& buffer : buffers) {
-        for (auto& handler : vec_handlers_) {
-            if ((ret = (*handler.handler)(handler.arg, buffer)) != RTP_OK) {
-                UVG_LOG_ERROR("Malformed packet");
-                return ret;
+#ifdef UDP_SEGMENT
+    // control messages are stored as 64-bit words to keep them aligned for cmsghdr
+    const size_t control_words = (CMSG_SPACE(sizeof(uint16_t)) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct mmsghdr *headers = desc.headers.data();
+
+    size_t total_chunks = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total_chunks += headers[i].msg_hdr.msg_iovlen;
+    }
+
+    // the super-buffers point to these so they must not be reallocated
+    std::vector<struct mmsghdr>& groups      = desc.groups;
+    std::vector<size_t>&         group_start = desc.group_start;
+    std::vector<struct iovec>&   chunks      = desc.group_chunks;
+
+    groups.clear();
+    group_start.clear();
+    chunks.clear();
+
+    groups.reserve(count);
+    group_start.reserve(count);
+    chunks.reserve(total_chunks);
+
+    if (desc.group_control.size() < count * control_words)
+        desc.group_control.resize(count * control_words);
+
+    auto message_size = [](const struct msghdr& msg) {
+        size_t size = 0;
+        for (size_t k = 0; k < msg.msg_iovlen; ++k) {
+            size += msg.msg_iov[k].iov_len;
+        }
+        return size;
+    };
+
+    for (size_t i = 0; i < count; ) {
+        size_t first        = i;
+        size_t segment_size = message_size(headers[i].msg_hdr);
+        size_t group_size   = segment_size;
+        size_t group_chunks = headers[i].msg_hdr.msg_iovlen;
+
+        /* All segments of a GSO buffer have the same size, except for the last one which
+         * may be shorter. Other packets, such as the last fragment of a frame, start a new group */
+        for (++i; i < count && i - first < MAX_GSO_SEGMENTS; ++i) {
+            size_t size = message_size(headers[i].msg_hdr);
+
+            if (size > segment_size || group_size + size > MAX_GSO_SIZE ||
+                group_chunks + headers[i].msg_hdr.msg_iovlen > IOV_MAX)
+                break;
+
+            group_size   += size;
+            group_chunks += headers[i].msg_hdr.msg_iovlen;
+
+            if (size < segment_size) {
+                ++i;
+                break;
             }
         }
+
+        struct mmsghdr group = {};
+        group.msg_hdr.msg_name    = headers[first].msg_hdr.msg_name;
+        group.msg_hdr.msg_namelen = headers[first].msg_hdr.msg_namelen;
+        group.msg_hdr.msg_iov     = chunks.data() + chunks.size();
+        group.msg_hdr.msg_iovlen  = group_chunks;
+
+        for (size_t k = first; k < i; ++k) {
+            chunks.insert(chunks.end(), headers[k].msg_hdr.msg_iov,
+                headers[k].msg_hdr.msg_iov + headers[k].msg_hdr.msg_iovlen);
+        }
+
+        // a single packet is sent as is
+        if (i - first > 1) {
+            uint16_t gso_size = (uint16_t)segment_size;
+
+            group.msg_hdr.msg_control    = &desc.group_control[groups.size() * control_words];
+            group.msg_hdr.msg_controllen = CMSG_SPACE(sizeof(gso_size));
+
+            struct cmsghdr *cmsg = CMSG_FIRSTHDR(&group.msg_hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type  = UDP_SEGMENT;
+            cmsg->cmsg_len   = CMSG_LEN(sizeof(gso_size));
+            memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+        }
+
+        groups.push_back(group);
+        group_start.push_back(first);
     }
 
-    return __sendtov(remote_address_, buffers, send_flags, bytes_sent);
+    for (size_t g = 0; g < groups.size(); ) {
+        int ret = sendmmsg(socket_, &groups[g], (unsigned int)(groups.size() - g), send_flags);
+
+        if (ret < 0) {
+            *packets_sent = group_start[g];
+
+            // the kernel or the network device does not support GSO for this socket
+            if (groups[g].msg_hdr.msg_controllen &&
+                (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT || errno == EOPNOTSUPP)) {
+                UVG_LOG_WARN("UDP GSO send failed: %s, sending packets with sendmmsg()", strerror(errno));
+                gso_ = false;
+                return RTP_NOT_SUPPORTED;
+            }
+
+            log_platform_error("sendmmsg(2) failed");
+            return RTP_SEND_ERROR;
+        }
+
+        g += ret;
+    }
+
+    *packets_sent = count;
+    return RTP_OK;
+#else
+    (void)desc;
+    (void)count;
+    (void)send_flags;
+
+    gso_ = false;
+    return RTP_NOT_SUPPORTED;
+#endif
 }
+#endif
 
-rtp_error_t uvgrtp::socket::sendto(sockaddr_in& addr, pkt_vec& buffers, int send_flags)
+std::unique_ptr<uvgrtp::send_descriptor> uvgrtp::socket::acquire_send_descriptor()
+{
+    std::lock_guard<std::mutex> lk(send_descriptors_mtx_);
+
+    if (send_descriptors_.empty())
+        return std::unique_ptr<uvgrtp::send_descriptor>(new uvgrtp::send_descriptor());
+
+    std::unique_ptr<uvgrtp::send_descriptor> desc = std::move(send_descriptors_.back());
+    send_descriptors_.pop_back();
+
+    return desc;
+}
+
+void uvgrtp::socket::release_send_descriptor(std::unique_ptr<send_descriptor> desc)
+{
+    std::lock_guard<std::mutex> lk(send_descriptors_mtx_);
+
+    if (send_descriptors_.size() < MAX_SEND_DESCRIPTORS)
+        send_descriptors_.push_back(std::move(desc));
+}
+
+static void handle_parallel_run(void *arg)
+{
+    uvgrtp::parallel_run *run = (uvgrtp::parallel_run *)arg;
+    run->result = (*run->handler->batch)(run->handler->arg, run->packets, run->states, run->count);
+
+    // the descriptor may be reused as soon as the sender sees the last run finish
+    uvgrtp::send_descriptor *desc = run->desc;
+    std::lock_guard<std::mutex> lk(desc->runs_mtx);
+
+    if (--desc->runs_pending == 0)
+        desc->runs_cv.notify_one();
+}
+
+rtp_error_t uvgrtp::socket::handle_and_sendtov(sockaddr_in& addr, pkt_vec& buffers, int send_flags, int *bytes_sent)
 {
     rtp_error_t ret = RTP_OK;
 
+    if ((rce_flags_ & RCE_PARALLEL_SRTP) && buffers.size() >= PARALLEL_SRTP_MIN_PACKETS &&
+        !vec_handlers_.empty() && vec_handlers_.back().batch)
+    {
+        return parallel_handle_and_sendtov(addr, buffers, send_flags, bytes_sent, vec_handlers_.back());
+    }
+
     for (auto& buffer : buffers) {
         for (auto& handler : vec_handlers_) {
             if ((ret = (*handler.handler)(handler.arg, buffer)) != RTP_OK) {
@@ -556,23 +873,122 @@ rtp_error_t uvgrtp::socket::sendto(sockaddr_in& addr, pkt_vec& buffers, int send
         }
     }
 
-    return __sendtov(addr, buffers, send_flags, nullptr);
+    return __sendtov(addr, buffers.data(), buffers.size(), send_flags, bytes_sent);
 }
 
-rtp_error_t uvgrtp::socket::sendto(sockaddr_in& addr, pkt_vec& buffers, int send_flags, int *bytes_sent)
+rtp_error_t uvgrtp::socket::parallel_handle_and_sendtov(sockaddr_in& addr, pkt_vec& buffers, int send_flags,
+    int *bytes_sent, const socket_packet_handler& parallel)
 {
     rtp_error_t ret = RTP_OK;
 
-    for (auto& buffer : buffers) {
-        for (auto& handler : vec_handlers_) {
-            if ((ret = (*handler.handler)(handler.arg, buffer)) != RTP_OK) {
+    std::unique_ptr<send_descriptor> desc = acquire_send_descriptor();
+    std::vector<uint64_t>& states = desc->states;
+    states.resize(buffers.size());
+
+    /* The prepare parts see the packets in order, so only the batch parts are run on the workers */
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        for (size_t k = 0; k < vec_handlers_.size() - 1; ++k) {
+            if ((ret = (*vec_handlers_[k].handler)(vec_handlers_[k].arg, buffers[i])) != RTP_OK) {
                 UVG_LOG_ERROR("Malformed packet");
+                release_send_descriptor(std::move(desc));
                 return ret;
             }
         }
+
+        if ((ret = (*parallel.prepare)(parallel.arg, buffers[i], states[i])) != RTP_OK) {
+            UVG_LOG_ERROR("Malformed packet");
+            release_send_descriptor(std::move(desc));
+            return ret;
+        }
     }
 
-    return __sendtov(addr, buffers, send_flags, bytes_sent);
+    auto& pool     = uvgrtp::thread_pool::shared();
+    size_t run_len = std::max(PARALLEL_SRTP_MIN_RUN,
+        (PARALLEL_SRTP_BATCH_SIZE + pool.thread_count() - 1) / pool.thread_count());
+
+    // only one batch is handled at a time, so the runs of the descriptor are reused for every batch
+    desc->runs.resize((PARALLEL_SRTP_BATCH_SIZE + run_len - 1) / run_len);
+
+    auto submit_batch = [&](size_t first) {
+        size_t end  = std::min(first + PARALLEL_SRTP_BATCH_SIZE, buffers.size());
+        size_t runs = (end - first + run_len - 1) / run_len;
+
+        {
+            std::lock_guard<std::mutex> lk(desc->runs_mtx);
+            desc->runs_pending = runs;
+        }
+
+        for (size_t i = 0; i < runs; ++i) {
+            size_t begin = first + i * run_len;
+            desc->runs[i] = { &parallel, &buffers[begin], &states[begin],
+                std::min(run_len, end - begin), RTP_OK, desc.get() };
+
+            pool.submit(handle_parallel_run, &desc->runs[i]);
+        }
+    };
+
+    auto wait_batch = [&]() {
+        std::unique_lock<std::mutex> lk(desc->runs_mtx);
+        desc->runs_cv.wait(lk, [&] { return desc->runs_pending == 0; });
+
+        rtp_error_t r = RTP_OK;
+        for (auto& run : desc->runs) {
+            if (run.result != RTP_OK)
+                r = run.result;
+            run.result = RTP_OK;
+        }
+        return r;
+    };
+
+    /* Batch N is sent while the workers handle batch N + 1. The batches must have finished
+     * before returning since the workers use the packets of the caller */
+    int total_sent = 0;
+    submit_batch(0);
+
+    for (size_t first = 0; first < buffers.size(); first += PARALLEL_SRTP_BATCH_SIZE) {
+        if ((ret = wait_batch()) != RTP_OK) {
+            UVG_LOG_ERROR("Failed to handle packets before sending");
+            break;
+        }
+
+        if (first + PARALLEL_SRTP_BATCH_SIZE < buffers.size())
+            submit_batch(first + PARALLEL_SRTP_BATCH_SIZE);
+
+        int batch_sent = 0;
+        size_t count   = std::min(PARALLEL_SRTP_BATCH_SIZE, buffers.size() - first);
+
+        if ((ret = __sendtov(addr, &buffers[first], count, send_flags, &batch_sent)) != RTP_OK) {
+            wait_batch();
+            break;
+        }
+
+        total_sent += batch_sent;
+    }
+
+    release_send_descriptor(std::move(desc));
+
+    set_bytes(bytes_sent, (ret == RTP_OK) ? total_sent : -1);
+    return ret;
+}
+
+rtp_error_t uvgrtp::socket::sendto(pkt_vec& buffers, int send_flags)
+{
+    return handle_and_sendtov(remote_address_, buffers, send_flags, nullptr);
+}
+
+rtp_error_t uvgrtp::socket::sendto(pkt_vec& buffers, int send_flags, int *bytes_sent)
+{
+    return handle_and_sendtov(remote_address_, buffers, send_flags, bytes_sent);
+}
+
+rtp_error_t uvgrtp::socket::sendto(sockaddr_in& addr, pkt_vec& buffers, int send_flags)
+{
+    return handle_and_sendtov(addr, buffers, send_flags, nullptr);
+}
+
+rtp_error_t uvgrtp::socket::sendto(sockaddr_in& addr, pkt_vec& buffers, int send_flags, int *bytes_sent)
+{
+    return handle_and_sendtov(addr, buffers, send_flags, bytes_sent);
 }
 
 rtp_error_t uvgrtp::socket::__recv(uint8_t *buf, size_t buf_len, int recv_flags, int *bytes_read)
@@ -714,6 +1130,130 @@ rtp_error_t uvgrtp::socket::recvfrom(uint8_t *buf, size_t buf_len, int recv_flag
     return __recvfrom(buf, buf_len, recv_flags, nullptr, nullptr);
 }
 
+rtp_error_t uvgrtp::socket::enable_gro()
+{
+#if defined(UDP_GRO) && defined(UVGRTP_HAVE_RECVMMSG)
+    int enable = 1;
+
+    if (::setsockopt(socket_, SOL_UDP, UDP_GRO, &enable, sizeof(enable)) < 0) {
+        UVG_LOG_DEBUG("Failed to enable UDP GRO: %s", strerror(errno));
+        return RTP_NOT_SUPPORTED;
+    }
+
+    return RTP_OK;
+#else
+    return RTP_NOT_SUPPORTED;
+#endif
+}
+
+rtp_error_t uvgrtp::socket::enable_timestamps()
+{
+#if defined(SO_TIMESTAMPNS) && defined(UVGRTP_HAVE_RECVMMSG)
+    int enable = 1;
+
+    if (::setsockopt(socket_, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0) {
+        UVG_LOG_DEBUG("Failed to enable receive timestamps: %s", strerror(errno));
+        return RTP_NOT_SUPPORTED;
+    }
+
+    return RTP_OK;
+#else
+    return RTP_NOT_SUPPORTED;
+#endif
+}
+
+#ifndef _WIN32
+void uvgrtp::socket::parse_recv_info(struct msghdr *msg, recv_info& info)
+{
+    info = recv_info();
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+#ifdef UDP_GRO
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+            int segment_size = 0;
+            memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+            info.segment_size = segment_size;
+        }
+#endif
+#ifdef SO_TIMESTAMPNS
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            info.arrival_ntp = uvgrtp::clock::ntp::from_unix((uint64_t)ts.tv_sec, (uint64_t)ts.tv_nsec);
+        }
+#endif
+    }
+}
+#endif
+
+rtp_error_t uvgrtp::socket::recvmmsg(uint8_t **buffers, size_t buf_len, int *bytes_read,
+    unsigned int count, int recv_flags, unsigned int *packets_read, recv_info *info)
+{
+    *packets_read = 0;
+
+    if (!buffers || !bytes_read || !buf_len || !count)
+        return RTP_INVALID_VALUE;
+
+    if (count > MAX_RECV_BATCH)
+        count = MAX_RECV_BATCH;
+
+#ifdef UVGRTP_HAVE_RECVMMSG
+    for (unsigned int i = 0; i < count; ++i) {
+        recv_chunks_[i].iov_base = buffers[i];
+        recv_chunks_[i].iov_len  = buf_len;
+
+        recv_headers_[i].msg_hdr.msg_name       = nullptr;
+        recv_headers_[i].msg_hdr.msg_namelen    = 0;
+        recv_headers_[i].msg_hdr.msg_iov        = &recv_chunks_[i];
+        recv_headers_[i].msg_hdr.msg_iovlen     = 1;
+        recv_headers_[i].msg_hdr.msg_control    = info ? recv_control_[i] : nullptr;
+        recv_headers_[i].msg_hdr.msg_controllen = info ? sizeof(recv_control_[i]) : 0;
+        recv_headers_[i].msg_hdr.msg_flags      = 0;
+        recv_headers_[i].msg_len                = 0;
+    }
+
+    int ret = ::recvmmsg(socket_, recv_headers_, count, recv_flags, nullptr);
+
+    if (ret == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            return RTP_INTERRUPTED;
+
+        UVG_LOG_ERROR("recvmmsg(2) failed: %s", strerror(errno));
+        return RTP_GENERIC_ERROR;
+    }
+
+    for (int i = 0; i < ret; ++i) {
+        bytes_read[i] = (int)recv_headers_[i].msg_len;
+
+        if (info)
+            parse_recv_info(&recv_headers_[i].msg_hdr, info[i]);
+    }
+
+    *packets_read = (unsigned int)ret;
+
+#ifndef NDEBUG
+    received_packets_ += ret;
+#endif // !NDEBUG
+#else
+    for (unsigned int i = 0; i < count; ++i) {
+        rtp_error_t ret = __recvfrom(buffers[i], buf_len, recv_flags, nullptr, &bytes_read[i]);
+
+        if (ret == RTP_INTERRUPTED || (ret == RTP_OK && bytes_read[i] == 0))
+            break;
+
+        if (ret != RTP_OK)
+            return (*packets_read) ? RTP_OK : ret;
+
+        if (info)
+            info[i] = recv_info();
+
+        ++(*packets_read);
+    }
+#endif
+
+    return (*packets_read) ? RTP_OK : RTP_INTERRUPTED;
+}
+
 sockaddr_in& uvgrtp::socket::get_out_address()
 {
     return remote_address_;
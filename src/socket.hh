@@ -12,8 +12,12 @@
 #include <sys/uio.h>
 #endif
 
+#include <atomic>
 #include <vector>
 #include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 
 #ifdef _WIN32
 typedef SOCKET socket_t;
@@ -51,6 +55,46 @@ namespace uvgrtp {
 
     const int MAX_BUFFER_COUNT = 256;
 
+    /* Maximum number of linked send requests submitted to io_uring at once (RCE_IO_URING) */
+    const unsigned int MAX_URING_SEND_BATCH = 256;
+
+    /* How many failed waits for in-flight io_uring sends are tolerated before giving up on them */
+    const unsigned int MAX_URING_SEND_WAIT_FAILURES = 10;
+
+    /* Maximum number of datagrams the kernel accepts in one UDP GSO send (RCE_UDP_GSO) */
+    const size_t MAX_GSO_SEGMENTS = 64;
+
+    /* Maximum size of one UDP GSO send, the largest UDP payload of an IPv4 packet */
+    const size_t MAX_GSO_SIZE = 65507;
+
+    /* Maximum number of datagrams read with one recvmmsg() call */
+    const unsigned int MAX_RECV_BATCH = 64;
+
+    /* Size of the ancillary data buffer of each datagram read with recvmmsg() */
+    const size_t RECV_CONTROL_SIZE = 64;
+
+    /* Maximum number of send descriptors a socket keeps for reuse */
+    const size_t MAX_SEND_DESCRIPTORS = 4;
+
+    /* With RCE_PARALLEL_SRTP, smaller transactions are protected on the sending thread */
+    const size_t PARALLEL_SRTP_MIN_PACKETS = 64;
+
+    /* Number of packets protected by the workers before they are sent (RCE_PARALLEL_SRTP) */
+    const size_t PARALLEL_SRTP_BATCH_SIZE = 256;
+
+    /* Minimum number of packets given to one worker at a time (RCE_PARALLEL_SRTP) */
+    const size_t PARALLEL_SRTP_MIN_RUN = 16;
+
+    /* Information about a received datagram from its ancillary data, see socket::parse_recv_info() */
+    struct recv_info {
+        /* If UDP GRO has coalesced several datagrams into the read, the size of
+         * each of them except possibly the last. Zero if the read is a single datagram */
+        int segment_size = 0;
+
+        /* Kernel receive timestamp of the datagram as an NTP timestamp, zero if not available */
+        uint64_t arrival_ntp = 0;
+    };
+
     /* Vector of buffers that contain a full RTP frame */
     typedef std::vector<std::pair<size_t, uint8_t *>> buf_vec;
 
@@ -59,11 +103,63 @@ namespace uvgrtp {
 
     typedef rtp_error_t (*packet_handler_vec)(void *, buf_vec&);
 
+    /* A packet handler may be split into two parts so that the packets of a large transaction
+     * can be handled on several threads (RCE_PARALLEL_SRTP). The prepare part is called for each
+     * packet in order on the sending thread and writes the state the packet needs to "state".
+     * The batch part is then called from the worker threads for runs of consecutive packets
+     * and their states. Batch parts of different runs may be called at the same time */
+    typedef rtp_error_t (*packet_handler_prepare)(void *, buf_vec&, uint64_t& state);
+    typedef rtp_error_t (*packet_handler_batch)(void *, buf_vec *packets, const uint64_t *states, size_t count);
+
     struct socket_packet_handler {
         void *arg = nullptr;
         packet_handler_vec handler = nullptr;
+
+        /* optional split of "handler", see packet_handler_prepare */
+        packet_handler_prepare prepare = nullptr;
+        packet_handler_batch batch = nullptr;
+    };
+
+    struct send_descriptor;
+
+    /* A run of consecutive packets whose batch handler is called by a worker thread (RCE_PARALLEL_SRTP) */
+    struct parallel_run {
+        const socket_packet_handler *handler;
+        buf_vec *packets;
+        const uint64_t *states;
+        size_t count;
+        rtp_error_t result;
+        send_descriptor *desc; // signaled when the run has been handled
     };
 
+    /* Message headers, I/O vectors and handler state needed to send a packet vector
+     *
+     * Sending a frame needs a message header per packet and an I/O vector per buffer.
+     * Descriptors are reused between sends so that flushing a frame does not allocate memory
+     * once the vectors have grown to the size of the largest frame */
+    struct send_descriptor {
+#ifndef _WIN32
+        std::vector<struct mmsghdr> headers;
+        std::vector<struct iovec>   chunks;
+
+        /* UDP GSO super-buffers, the index of their first packet and their control messages */
+        std::vector<struct mmsghdr> groups;
+        std::vector<size_t>         group_start;
+        std::vector<struct iovec>   group_chunks;
+        std::vector<uint64_t>       group_control;
+#endif
+
+        /* states of the packets and the runs of the batch being handled by the workers (RCE_PARALLEL_SRTP).
+         * "runs_pending" counts the runs not yet handled and is protected by "runs_mtx" */
+        std::vector<uint64_t>     states;
+        std::vector<parallel_run> runs;
+        size_t                    runs_pending = 0;
+        std::mutex                runs_mtx;
+        std::condition_variable   runs_cv;
+    };
+
+    class uring;
+
     class socket {
         public:
             socket(int rce_flags);
@@ -138,6 +234,41 @@ namespace uvgrtp {
             rtp_error_t recvfrom(uint8_t *buf, size_t buf_len, int recv_flags, int *bytes_read);
             rtp_error_t recvfrom(uint8_t *buf, size_t buf_len, int recv_flags);
 
+            /* Receive up to "count" datagrams into "buffers", each of which is "buf_len" bytes long.
+             * If the platform supports recvmmsg(2), all datagrams are read with one system call.
+             * Otherwise recvfrom() is called until the socket has no more data or "count" is reached
+             *
+             * "count" is capped to MAX_RECV_BATCH. The size of the i:th datagram is written to
+             * "bytes_read[i]" and the number of received datagrams is written to "packets_read"
+             *
+             * If "info" is not NULL, the ancillary data of the i:th datagram is parsed to "info[i]"
+             *
+             * Return RTP_OK on success
+             * Return RTP_INTERRUPTED if there was nothing to read and set "packets_read" to 0
+             * Return RTP_GENERIC_ERROR on error and set "packets_read" to 0 */
+            rtp_error_t recvmmsg(uint8_t **buffers, size_t buf_len, int *bytes_read,
+                unsigned int count, int recv_flags, unsigned int *packets_read, recv_info *info = nullptr);
+
+            /* Enable UDP generic receive offload on the socket. Reads may then contain several
+             * datagrams, the size of which is reported in recv_info::segment_size by recvmmsg()
+             *
+             * Return RTP_OK on success
+             * Return RTP_NOT_SUPPORTED if the platform or kernel does not support UDP GRO */
+            rtp_error_t enable_gro();
+
+            /* Have the kernel timestamp received datagrams. The timestamps are reported
+             * in recv_info::arrival_ntp by recvmmsg()
+             *
+             * Return RTP_OK on success
+             * Return RTP_NOT_SUPPORTED if the platform does not support receive timestamps */
+            rtp_error_t enable_timestamps();
+
+#ifndef _WIN32
+            /* Parse the UDP GRO segment size and the kernel receive timestamp
+             * from the ancillary data of a received message to "info" */
+            static void parse_recv_info(struct msghdr *msg, recv_info& info);
+#endif
+
             /* Create sockaddr_in object using the provided information
              * NOTE: "family" must be AF_INET */
             sockaddr_in create_sockaddr(short family, unsigned host, short port) const;
@@ -169,6 +300,14 @@ namespace uvgrtp {
              * "arg" is an optional parameter that can be passed to the handler when it's called */
             rtp_error_t install_handler(void *arg, packet_handler_vec handler);
 
+            /* Install a packet handler which is split into a prepare part and a batch part
+             * in addition to "handler", see packet_handler_prepare.
+             *
+             * The split is used for transactions sent with RCE_PARALLEL_SRTP if the handler
+             * is the last one installed. Otherwise "handler" is called as usual */
+            rtp_error_t install_handler(void *arg, packet_handler_vec handler,
+                packet_handler_prepare prepare, packet_handler_batch batch);
+
         private:
 
             /* helper function for sending UPD packets, see documentation for sendto() above */
@@ -178,7 +317,38 @@ namespace uvgrtp {
 
             /* __sendtov() does the same as __sendto but it combines multiple buffers into one frame and sends them */
             rtp_error_t __sendtov(sockaddr_in& addr, buf_vec& buffers, int send_flags, int *bytes_sent);
-            rtp_error_t __sendtov(sockaddr_in& addr, uvgrtp::pkt_vec& buffers, int send_flags, int *bytes_sent);
+            rtp_error_t __sendtov(sockaddr_in& addr, buf_vec *packets, size_t count, int send_flags, int *bytes_sent);
+
+            /* Call the packet handlers for each packet of "buffers" and send the packets */
+            rtp_error_t handle_and_sendtov(sockaddr_in& addr, pkt_vec& buffers, int send_flags, int *bytes_sent);
+
+            /* Same as handle_and_sendtov() but the batch part of "parallel" is called from the shared
+             * worker pool and each batch of packets is sent while the next one is being handled */
+            rtp_error_t parallel_handle_and_sendtov(sockaddr_in& addr, pkt_vec& buffers, int send_flags,
+                int *bytes_sent, const socket_packet_handler& parallel);
+
+#ifndef _WIN32
+            /* Send "count" messages as linked io_uring send requests so that they are sent in order
+             * with one system call per MAX_URING_SEND_BATCH messages. Waits until all have been sent
+             *
+             * Return RTP_OK on success
+             * Return RTP_SEND_ERROR if sending any of the messages failed */
+            rtp_error_t send_linked(struct mmsghdr *headers, size_t count, int send_flags);
+
+            /* Send the first "count" messages of "desc" so that each run of equally sized messages is given
+             * to the kernel as one UDP GSO buffer. The number of messages sent is written to "packets_sent"
+             *
+             * Return RTP_OK on success
+             * Return RTP_NOT_SUPPORTED if the kernel rejected GSO, in which case GSO is disabled
+             * and the rest of the messages must be sent normally
+             * Return RTP_SEND_ERROR if sending failed */
+            rtp_error_t send_segmented(send_descriptor& desc, size_t count, int send_flags, size_t *packets_sent);
+#endif
+
+            /* Get a send descriptor from the cache or allocate a new one if the cache is empty.
+             * Descriptors are returned to the cache with release_send_descriptor() */
+            std::unique_ptr<send_descriptor> acquire_send_descriptor();
+            void release_send_descriptor(std::unique_ptr<send_descriptor> desc);
 
             socket_t socket_;
             sockaddr_in remote_address_;
@@ -201,7 +371,28 @@ namespace uvgrtp {
 #else
             struct mmsghdr header_;
             struct iovec   chunks_[MAX_BUFFER_COUNT];
+
+            /* headers used by recvmmsg(), only touched by the receiver thread */
+            struct mmsghdr recv_headers_[MAX_RECV_BATCH];
+            struct iovec   recv_chunks_[MAX_RECV_BATCH];
+            uint64_t       recv_control_[MAX_RECV_BATCH][RECV_CONTROL_SIZE / sizeof(uint64_t)];
 #endif
+
+            /* io_uring instance for sending packet vectors if RCE_IO_URING was given and io_uring is available */
+            std::unique_ptr<uvgrtp::uring> send_ring_;
+            std::mutex send_ring_mtx_;
+
+            /* sends still in flight when send_linked() gave up waiting for them,
+             * their completions are skipped by the next call */
+            unsigned int stale_send_completions_;
+
+            /* is UDP GSO used for sending packet vectors (RCE_UDP_GSO).
+             * Cleared by whichever sender first finds GSO rejected by the kernel */
+            std::atomic<bool> gso_;
+
+            /* packet vectors may be sent from several threads so each send takes its own descriptor */
+            std::vector<std::unique_ptr<send_descriptor>> send_descriptors_;
+            std::mutex send_descriptors_mtx_;
     };
 }
 
@@ -9,7 +9,9 @@
 uvgrtp::base_srtp::base_srtp():
     local_srtp_ctx_(std::shared_ptr<srtp_ctx_t>(new srtp_ctx_t)),
     remote_srtp_ctx_(std::shared_ptr<srtp_ctx_t>(new srtp_ctx_t)),
-    use_null_cipher_(false)
+    use_null_cipher_(false),
+    use_aead_(false),
+    replay_window_(UVG_REPLAY_WINDOW_DEFAULT)
 {}
 
 uvgrtp::base_srtp::~base_srtp()
@@ -24,6 +26,11 @@ bool uvgrtp::base_srtp::use_null_cipher()
     return use_null_cipher_;
 }
 
+bool uvgrtp::base_srtp::use_aead() const
+{
+    return use_aead_;
+}
+
 std::shared_ptr<uvgrtp::srtp_ctx_t> uvgrtp::base_srtp::get_local_ctx()
 {
     return local_srtp_ctx_;
@@ -73,23 +80,68 @@ rtp_error_t uvgrtp::base_srtp::create_iv(uint8_t *out, uint32_t ssrc, uint64_t i
     return RTP_OK;
 }
 
-bool uvgrtp::base_srtp::is_replayed_packet(uint8_t *digest)
+void uvgrtp::base_srtp::create_aead_iv(uint8_t *out, uint32_t ssrc, uint64_t index, const uint8_t *salt)
+{
+    /* 2 zero bytes, SSRC and 48-bit packet index in network byte order, XORed with the salt */
+    out[0] = 0;
+    out[1] = 0;
+
+    for (int i = 0; i < 4; ++i)
+        out[2 + i] = (uint8_t)(ssrc >> (24 - 8 * i));
+
+    for (int i = 0; i < 6; ++i)
+        out[6 + i] = (uint8_t)(index >> (40 - 8 * i));
+
+    for (int i = 0; i < UVG_AEAD_IV_LENGTH; ++i)
+        out[i] ^= salt[i];
+}
+
+bool uvgrtp::base_srtp::is_replayed_packet(uint64_t index)
 {
     if (!(remote_srtp_ctx_->rce_flags & RCE_SRTP_REPLAY_PROTECTION))
         return false;
 
-    uint64_t truncated;
-    memcpy(&truncated, digest, sizeof(uint64_t));
-
-    if (replay_list_.find(truncated) != replay_list_.end()) {
-        UVG_LOG_ERROR("Replayed packet received, discarding!");
-        return true;
+    auto& ctx = *remote_srtp_ctx_;
+
+    auto bit = [](uint64_t i) { return (uint64_t)1 << (i % 64); };
+    auto word = [&ctx](uint64_t i) -> uint64_t& { return ctx.replay[i % UVG_REPLAY_WINDOW_MAX / 64]; };
+
+    if (!ctx.s_l_valid) {
+        ctx.s_l_valid = true;
+        ctx.s_l = index;
+    } else if (index > ctx.s_l) {
+        /* The window moves forward, forget the packets that fall out of it */
+        if (index - ctx.s_l >= UVG_REPLAY_WINDOW_MAX) {
+            memset(ctx.replay, 0, sizeof(ctx.replay));
+        } else {
+            for (uint64_t i = ctx.s_l + 1; i < index; ++i)
+                word(i) &= ~bit(i);
+        }
+
+        ctx.s_l = index;
+    } else {
+        if (ctx.s_l - index >= replay_window_.load(std::memory_order_relaxed)) {
+            UVG_LOG_DEBUG("Packet %llu is older than the replay window", (unsigned long long)index);
+            return true;
+        }
+
+        if (word(index) & bit(index))
+            return true;
     }
 
-    replay_list_.insert(truncated);
+    word(index) |= bit(index);
     return false;
 }
 
+rtp_error_t uvgrtp::base_srtp::set_replay_window(size_t size)
+{
+    if (size < UVG_REPLAY_WINDOW_MIN || size > UVG_REPLAY_WINDOW_MAX)
+        return RTP_INVALID_VALUE;
+
+    replay_window_.store(size, std::memory_order_relaxed);
+    return RTP_OK;
+}
+
 rtp_error_t uvgrtp::base_srtp::init(int type, int rce_flags, uint8_t* local_key, uint8_t* remote_key,
                                     uint8_t* local_salt, uint8_t* remote_salt)
 {
@@ -97,6 +149,12 @@ rtp_error_t uvgrtp::base_srtp::init(int type, int rce_flags, uint8_t* local_key,
         return RTP_INVALID_VALUE;
 
     use_null_cipher_ = (rce_flags & RCE_SRTP_NULL_CIPHER);
+    use_aead_        = (rce_flags & RCE_SRTP_AEAD_AES_GCM);
+
+    if (use_aead_ && (use_null_cipher_ || get_key_size(rce_flags) == AES192_KEY_SIZE)) {
+        UVG_LOG_ERROR("AES-GCM is only supported with 128-bit and 256-bit keys and cannot use NULL cipher");
+        return RTP_INVALID_VALUE;
+    }
 
     init_srtp_context(local_srtp_ctx_,  type, rce_flags, local_key,  local_salt);
     init_srtp_context(remote_srtp_ctx_, type, rce_flags, remote_key, remote_salt);
@@ -131,7 +189,7 @@ rtp_error_t uvgrtp::base_srtp::init_srtp_context(std::shared_ptr<uvgrtp::srtp_ct
 
     switch (key_size) {
     case AES128_KEY_SIZE:
-        context->enc = AES_128;
+        context->enc = (rce_flags & RCE_SRTP_AEAD_AES_GCM) ? AEAD_AES_128_GCM : AES_128;
         break;
 
     case AES192_KEY_SIZE:
@@ -139,7 +197,7 @@ rtp_error_t uvgrtp::base_srtp::init_srtp_context(std::shared_ptr<uvgrtp::srtp_ct
         break;
 
     case AES256_KEY_SIZE:
-        context->enc = AES_256;
+        context->enc = (rce_flags & RCE_SRTP_AEAD_AES_GCM) ? AEAD_AES_256_GCM : AES_256;
         break;
     }
 
@@ -151,8 +209,9 @@ rtp_error_t uvgrtp::base_srtp::init_srtp_context(std::shared_ptr<uvgrtp::srtp_ct
     context->n_e = key_size;
     context->n_a = UVG_HMAC_KEY_LENGTH;
 
+    context->s_l_valid = false;
     context->s_l = 0;
-    context->replay = nullptr;
+    memset(context->replay, 0, sizeof(context->replay));
     context->rce_flags = rce_flags;
 
     int label_enc = 0;
@@ -173,6 +232,11 @@ rtp_error_t uvgrtp::base_srtp::init_srtp_context(std::shared_ptr<uvgrtp::srtp_ct
     context->master_key = new uint8_t[key_size];
     memcpy(context->master_key, key, key_size);
     memcpy(context->master_salt, salt, UVG_SALT_LENGTH);
+
+    /* RFC 7714 master salts are 96 bits and the KDF pads them with zeros to 112 bits */
+    if (rce_flags & RCE_SRTP_AEAD_AES_GCM)
+        memset(context->master_salt + UVG_AEAD_SALT_LENGTH, 0, UVG_SALT_LENGTH - UVG_AEAD_SALT_LENGTH);
+
     context->enc_key = new uint8_t[key_size]; // session key
 
     /* Derive session keys */
@@ -201,6 +265,20 @@ rtp_error_t uvgrtp::base_srtp::init_srtp_context(std::shared_ptr<uvgrtp::srtp_ct
         UVG_SALT_LENGTH
     );
 
+    /* RFC 7714 derives the same session keys but only uses the first 96 bits of the session salt */
+    if (rce_flags & RCE_SRTP_AEAD_AES_GCM) {
+        context->aead = std::unique_ptr<uvgrtp::crypto::aes::gcm>(
+            new uvgrtp::crypto::aes::gcm(context->enc_key, key_size));
+        return RTP_OK;
+    }
+
+    uint8_t iv[UVG_IV_LENGTH] = { 0 };
+
+    context->cipher = std::unique_ptr<uvgrtp::crypto::aes::ctr>(
+        new uvgrtp::crypto::aes::ctr(context->enc_key, key_size, iv));
+    context->auth = std::unique_ptr<uvgrtp::crypto::hmac::sha1>(
+        new uvgrtp::crypto::hmac::sha1(context->auth_key, UVG_AUTH_LENGTH));
+
     return RTP_OK;
 }
 
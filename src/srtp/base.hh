@@ -2,6 +2,8 @@
 
 #include "uvgrtp/util.hh"
 
+#include "../crypto.hh"
+
 #ifdef _WIN32
 #include <winsock2.h>
 #include <mswsock.h>
@@ -11,8 +13,8 @@
 #include <arpa/inet.h>
 #endif
 
+#include <atomic>
 #include <cstdint>
-#include <unordered_set>
 #include <vector>
 #include <memory>
 
@@ -32,6 +34,19 @@ enum {
 #define UVG_AUTH_TAG_LENGTH     10
 #define UVG_SRTCP_INDEX_LENGTH   4
 
+/* AEAD_AES_128_GCM and AEAD_AES_256_GCM (RFC 7714) */
+#define UVG_AEAD_SALT_LENGTH    12 /* 96 bits */
+#define UVG_AEAD_IV_LENGTH      12
+#define UVG_AEAD_TAG_LENGTH     16
+
+/* Size of the replay window in packets (RFC 3711 section 3.3.2) */
+#define UVG_REPLAY_WINDOW_MIN       64
+#define UVG_REPLAY_WINDOW_MAX     1024
+#define UVG_REPLAY_WINDOW_DEFAULT  128
+
+/* Maximum number of packets whose keystream is computed ahead of time */
+#define UVG_KEYSTREAM_MAX_PACKETS 4096
+
 namespace uvgrtp {
 
     /* Vector of buffers that contain a full RTP frame */
@@ -43,9 +58,11 @@ namespace uvgrtp {
     };
 
     enum ETYPE {
-        AES_128 = 0,
-        AES_192 = 1,
-        AES_256 = 2
+        AES_128          = 0,
+        AES_192          = 1,
+        AES_256          = 2,
+        AEAD_AES_128_GCM = 3,
+        AEAD_AES_256_GCM = 4
     };
 
     enum HTYPE {
@@ -72,6 +89,14 @@ namespace uvgrtp {
         uint8_t auth_key[UVG_AUTH_LENGTH] = {};
         uint8_t salt_key[UVG_SALT_LENGTH] = {};
 
+        /* The session keys are expanded once when the context is initialized
+         * and only the IV is changed for each packet */
+        std::unique_ptr<uvgrtp::crypto::aes::ctr> cipher;
+        std::unique_ptr<uvgrtp::crypto::hmac::sha1> auth;
+
+        /* Used instead of "cipher" and "auth" with the AES-GCM transforms */
+        std::unique_ptr<uvgrtp::crypto::aes::gcm> aead;
+
         int type = 0;     /* srtp or srtcp */
         uint32_t roc = 0; /* rollover counter */
         uint32_t rts = 0; /* timestamp of the frame that causes ROC update */
@@ -89,12 +114,28 @@ namespace uvgrtp {
         size_t n_a = 0; /* size of hmac key */
 
         /* following fields are receiver-only */
-        uint16_t s_l = 0;    /* highest received sequence number */
-        uint8_t *replay = nullptr; /* list of recently received and authenticated SRTP packets */
+        bool s_l_valid = false; /* has any packet been received */
+        uint64_t s_l = 0;       /* highest received packet index */
+
+        /* Received packets of the last UVG_REPLAY_WINDOW_MAX indices, one bit per packet,
+         * at bit "index % UVG_REPLAY_WINDOW_MAX" */
+        uint64_t replay[UVG_REPLAY_WINDOW_MAX / 64] = {};
 
         int rce_flags = 0; /* context configuration flags */
     } srtp_ctx_t;
 
+    /* Do the SRTP packets of a stream created with "rce_flags" carry an authentication tag */
+    inline bool srtp_authenticates(int rce_flags)
+    {
+        return rce_flags & (RCE_SRTP_AUTHENTICATE_RTP | RCE_SRTP_AEAD_AES_GCM);
+    }
+
+    /* Length of the authentication tag of SRTP and SRTCP packets of a stream created with "rce_flags" */
+    inline size_t srtp_auth_tag_length(int rce_flags)
+    {
+        return (rce_flags & RCE_SRTP_AEAD_AES_GCM) ? UVG_AEAD_TAG_LENGTH : UVG_AUTH_TAG_LENGTH;
+    }
+
     class base_srtp {
         public:
             base_srtp();
@@ -114,13 +155,26 @@ namespace uvgrtp {
             /* Has RTP packet encryption been disabled? */
             bool use_null_cipher();
 
+            /* Are packets encrypted and authenticated with AES-GCM? */
+            bool use_aead() const;
+
             /* Get reference to the SRTP context (including session keys) */
             std::shared_ptr<srtp_ctx_t> get_local_ctx();
             std::shared_ptr<srtp_ctx_t> get_remote_ctx();
 
-            /* Returns true if the packet having this HMAC digest is replayed
+            /* Check the packet index of an authenticated packet against the replay window and record it.
+             * For SRTP the index is ROC || SEQ and for SRTCP it is the SRTCP index
+             *
+             * Returns true if the packet has already been received or is older than the window
              * Returns false if replay protection has not been enabled */
-            bool is_replayed_packet(uint8_t *digest);
+            bool is_replayed_packet(uint64_t index);
+
+            /* Set the size of the replay window in packets, between UVG_REPLAY_WINDOW_MIN and
+             * UVG_REPLAY_WINDOW_MAX. Can be changed while packets are being received
+             *
+             * Return RTP_OK on success
+             * Return RTP_INVALID_VALUE if "size" is out of range */
+            rtp_error_t set_replay_window(size_t size);
 
             uint32_t get_key_size(int rce_flags) const;
 
@@ -130,7 +184,11 @@ namespace uvgrtp {
              *
              * Return RTP_OK on success and place the iv to "out"
              * Return RTP_INVALID_VALUE if one of the parameters is invalid */
-            rtp_error_t create_iv(uint8_t *out, uint32_t ssrc, uint64_t index, uint8_t *salt);
+            static rtp_error_t create_iv(uint8_t *out, uint32_t ssrc, uint64_t index, uint8_t *salt);
+
+            /* Create the 12-byte AES-GCM IV of RFC 7714 for packet "index" to "out".
+             * For SRTP the index is ROC || SEQ and for SRTCP it is the 31-bit SRTCP index */
+            void create_aead_iv(uint8_t *out, uint32_t ssrc, uint64_t index, const uint8_t *salt);
 
             /* SRTP context containing all session information and keys */
             std::shared_ptr<srtp_ctx_t> local_srtp_ctx_;  // for encryption
@@ -140,6 +198,8 @@ namespace uvgrtp {
              * encrypted but other security mechanisms described in RFC 3711 may be used */
             bool use_null_cipher_;
 
+            bool use_aead_;
+
         private:
 
             rtp_error_t init_srtp_context(std::shared_ptr<srtp_ctx_t> context, int type, int rce_flags,
@@ -149,9 +209,7 @@ namespace uvgrtp {
 
             void cleanup_context(std::shared_ptr<srtp_ctx_t> context);
 
-            /* Map containing all authentication tags of received packets (separate for SRTP and SRTCP)
-             * Used to implement replay protection */
-            std::unordered_set<uint64_t> replay_list_;
+            std::atomic<size_t> replay_window_;
     };
 }
 
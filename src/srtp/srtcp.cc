@@ -21,6 +21,13 @@ rtp_error_t uvgrtp::srtcp::handle_rtcp_encryption(int rce_flags, uint32_t packet
 {
     auto ret = RTP_OK;
 
+    /* RTCP packets can be sent both by the RTCP thread and by the application,
+     * but they share the key schedules of the local context */
+    std::lock_guard<std::mutex> lock(encrypt_mutex_);
+
+    if ((rce_flags & RCE_SRTP) && use_aead_)
+        return encrypt_aead(ssrc, packet_number, frame, frame_size);
+
     /* Encrypt the packet if NULL cipher has not been enabled,
      * calculate authentication tag for the packet and add SRTCP index at the end */
     if (rce_flags & RCE_SRTP) {
@@ -45,6 +52,9 @@ rtp_error_t uvgrtp::srtcp::handle_rtcp_encryption(int rce_flags, uint32_t packet
 rtp_error_t uvgrtp::srtcp::handle_rtcp_decryption(int rce_flags, uint32_t ssrc,
     uint8_t* packet, size_t packet_size)
 {
+    if ((rce_flags & RCE_SRTP) && use_aead_)
+        return decrypt_aead(ssrc, packet, packet_size);
+
     auto ret = RTP_OK;
     auto srtpi = (*(uint32_t*)&packet[packet_size - UVG_SRTCP_INDEX_LENGTH - UVG_AUTH_TAG_LENGTH]);
 
@@ -54,6 +64,11 @@ rtp_error_t uvgrtp::srtcp::handle_rtcp_decryption(int rce_flags, uint32_t ssrc,
             return RTP_AUTH_TAG_MISMATCH;
         }
 
+        if (is_replayed_packet(srtpi & 0x7fffffff)) {
+            UVG_LOG_ERROR("Replayed packet received, discarding!");
+            return RTP_INVALID_VALUE;
+        }
+
         if (((srtpi >> 31) & 0x1) && !(rce_flags & RCE_SRTP_NULL_CIPHER)) {
             if (decrypt(ssrc, srtpi & 0x7fffffff, packet, packet_size) != RTP_OK) {
                 UVG_LOG_ERROR("Failed to decrypt RTCP Sender Report");
@@ -77,15 +92,79 @@ rtp_error_t uvgrtp::srtcp::encrypt(uint32_t ssrc, uint64_t seq, uint8_t *buffer,
         return RTP_INVALID_VALUE;
     }
 
-    uvgrtp::crypto::aes::ctr ctr(local_srtp_ctx_->enc_key, local_srtp_ctx_->n_e, iv);
-    ctr.encrypt(buffer, buffer, len);
+    local_srtp_ctx_->cipher->set_iv(iv);
+    local_srtp_ctx_->cipher->encrypt(buffer, buffer, len);
+
+    return RTP_OK;
+}
+
+rtp_error_t uvgrtp::srtcp::encrypt_aead(uint32_t ssrc, uint32_t index, uint8_t *packet, size_t size)
+{
+    /* The packet is laid out as header and sender SSRC, ciphertext, tag and E flag with the SRTCP index.
+     * The first 8 bytes and the last word are authenticated but not encrypted */
+    size_t ct_len   = size - 8 - UVG_AEAD_TAG_LENGTH - UVG_SRTCP_INDEX_LENGTH;
+    uint32_t esrtcp = htonl((1u << 31) | (index & 0x7fffffff));
+
+    memcpy(&packet[size - UVG_SRTCP_INDEX_LENGTH], &esrtcp, sizeof(uint32_t));
+
+    uint8_t iv[UVG_AEAD_IV_LENGTH] = { 0 };
+    create_aead_iv(iv, ssrc, index & 0x7fffffff, local_srtp_ctx_->salt_key);
+
+    auto& gcm = *local_srtp_ctx_->aead;
+
+    gcm.set_iv(iv, UVG_AEAD_IV_LENGTH);
+    gcm.authenticate(packet, 8);
+    gcm.authenticate(&packet[size - UVG_SRTCP_INDEX_LENGTH], UVG_SRTCP_INDEX_LENGTH);
+    gcm.encrypt(&packet[8], &packet[8], ct_len);
+    gcm.final(&packet[8 + ct_len], UVG_AEAD_TAG_LENGTH);
+
+    return RTP_OK;
+}
+
+rtp_error_t uvgrtp::srtcp::decrypt_aead(uint32_t ssrc, uint8_t *packet, size_t size)
+{
+    if (size < 8 + UVG_AEAD_TAG_LENGTH + UVG_SRTCP_INDEX_LENGTH) {
+        UVG_LOG_ERROR("Received SRTCP packet that has too small size");
+        return RTP_INVALID_VALUE;
+    }
+
+    size_t ct_len   = size - 8 - UVG_AEAD_TAG_LENGTH - UVG_SRTCP_INDEX_LENGTH;
+    uint32_t esrtcp = 0;
+
+    memcpy(&esrtcp, &packet[size - UVG_SRTCP_INDEX_LENGTH], sizeof(uint32_t));
+    esrtcp = ntohl(esrtcp);
+
+    if (!(esrtcp >> 31)) {
+        UVG_LOG_ERROR("Received unencrypted SRTCP packet with AES-GCM");
+        return RTP_INVALID_VALUE;
+    }
+
+    uint8_t aad[8 + UVG_SRTCP_INDEX_LENGTH] = { 0 };
+    memcpy(aad, packet, 8);
+    memcpy(&aad[8], &packet[size - UVG_SRTCP_INDEX_LENGTH], UVG_SRTCP_INDEX_LENGTH);
+
+    uint8_t iv[UVG_AEAD_IV_LENGTH] = { 0 };
+    create_aead_iv(iv, ssrc, esrtcp & 0x7fffffff, remote_srtp_ctx_->salt_key);
+
+    uint8_t *tag = &packet[8 + ct_len];
+
+    if (!remote_srtp_ctx_->aead->decrypt(&packet[8], &packet[8], ct_len,
+            iv, UVG_AEAD_IV_LENGTH, aad, sizeof(aad), tag, UVG_AEAD_TAG_LENGTH)) {
+        UVG_LOG_ERROR("SRTCP authentication tag mismatch!");
+        return RTP_AUTH_TAG_MISMATCH;
+    }
+
+    if (is_replayed_packet(esrtcp & 0x7fffffff)) {
+        UVG_LOG_ERROR("Replayed packet received, discarding!");
+        return RTP_INVALID_VALUE;
+    }
 
     return RTP_OK;
 }
 
 rtp_error_t uvgrtp::srtcp::add_auth_tag(uint8_t *buffer, size_t len)
 {
-    auto hmac_sha1 = uvgrtp::crypto::hmac::sha1(local_srtp_ctx_->auth_key, UVG_AES_KEY_LENGTH);
+    auto& hmac_sha1 = *local_srtp_ctx_->auth;
 
     hmac_sha1.update(buffer, len - UVG_AUTH_TAG_LENGTH);
     hmac_sha1.update((uint8_t *)&local_srtp_ctx_->roc, sizeof(local_srtp_ctx_->roc));
@@ -97,7 +176,7 @@ rtp_error_t uvgrtp::srtcp::add_auth_tag(uint8_t *buffer, size_t len)
 rtp_error_t uvgrtp::srtcp::verify_auth_tag(uint8_t *buffer, size_t len)
 {
     uint8_t digest[10] = { 0 };
-    auto hmac_sha1     = uvgrtp::crypto::hmac::sha1(remote_srtp_ctx_->auth_key, UVG_AES_KEY_LENGTH);
+    auto& hmac_sha1    = *remote_srtp_ctx_->auth;
 
     hmac_sha1.update(buffer, len - UVG_AUTH_TAG_LENGTH);
     hmac_sha1.update((uint8_t *)&remote_srtp_ctx_->roc, sizeof(remote_srtp_ctx_->roc));
@@ -108,11 +187,6 @@ rtp_error_t uvgrtp::srtcp::verify_auth_tag(uint8_t *buffer, size_t len)
         return RTP_AUTH_TAG_MISMATCH;
     }
 
-    if (is_replayed_packet(digest)) {
-        UVG_LOG_ERROR("Replayed packet received, discarding!");
-        return RTP_INVALID_VALUE;
-    }
-
     return RTP_OK;
 }
 
@@ -125,9 +199,9 @@ rtp_error_t uvgrtp::srtcp::decrypt(uint32_t ssrc, uint32_t seq, uint8_t *buffer,
         return RTP_INVALID_VALUE;
     }
 
-    uvgrtp::crypto::aes::ctr ctr(remote_srtp_ctx_->enc_key, remote_srtp_ctx_->n_e, iv);
+    remote_srtp_ctx_->cipher->set_iv(iv);
 
     /* skip header and sender ssrc */
-    ctr.decrypt(&buffer[8], &buffer[8], size - 8 - UVG_AUTH_TAG_LENGTH - UVG_SRTCP_INDEX_LENGTH);
+    remote_srtp_ctx_->cipher->decrypt(&buffer[8], &buffer[8], size - 8 - UVG_AUTH_TAG_LENGTH - UVG_SRTCP_INDEX_LENGTH);
     return RTP_OK;
 }
@@ -2,6 +2,8 @@
 
 #include "base.hh"
 
+#include <mutex>
+
 namespace uvgrtp {
 
     class srtcp : public base_srtp {
@@ -29,8 +31,14 @@ namespace uvgrtp {
         rtp_error_t encrypt(uint32_t ssrc, uint64_t seq, uint8_t* buffer, size_t len);
         rtp_error_t decrypt(uint32_t ssrc, uint32_t seq, uint8_t* buffer, size_t len);
 
+        /* Encrypt and authenticate the whole RTCP packet with AES-GCM (RFC 7714) */
+        rtp_error_t encrypt_aead(uint32_t ssrc, uint32_t index, uint8_t* packet, size_t size);
+        rtp_error_t decrypt_aead(uint32_t ssrc, uint8_t* packet, size_t size);
+
         rtp_error_t add_auth_tag(uint8_t* buffer, size_t len);
         rtp_error_t verify_auth_tag(uint8_t* buffer, size_t len);
+
+        std::mutex encrypt_mutex_;
     };
 }
 
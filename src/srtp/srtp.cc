@@ -4,28 +4,124 @@
 
 #include "../debug.hh"
 #include "../crypto.hh"
+#include "../thread_pool.hh"
 #include "base.hh"
 #include "global.hh"
 
 #include <cstring>
 #include <iostream>
 
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
 
 #define MAX_OFF 10000
 
 uvgrtp::srtp::srtp(int rce_flags):base_srtp(),
-      authenticate_rtp_(rce_flags& RCE_SRTP_AUTHENTICATE_RTP)
+      authenticate_rtp_(srtp_authenticates(rce_flags))
 {}
 
 uvgrtp::srtp::~srtp()
 {}
 
-rtp_error_t uvgrtp::srtp::encrypt(uint32_t ssrc, uint16_t seq, uint8_t *buffer, size_t len)
+/* XOR "len" bytes of "keystream" to "buffer" a vector register at a time */
+static void xor_keystream(uint8_t *buffer, const uint8_t *keystream, size_t len)
+{
+    size_t i = 0;
+
+#if defined(__x86_64__) || defined(_M_X64)
+    for (; i + 16 <= len; i += 16) {
+        __m128i data = _mm_loadu_si128((const __m128i *)(buffer + i));
+        __m128i key  = _mm_loadu_si128((const __m128i *)(keystream + i));
+        _mm_storeu_si128((__m128i *)(buffer + i), _mm_xor_si128(data, key));
+    }
+#endif
+
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t data, key;
+        memcpy(&data, buffer + i, sizeof(uint64_t));
+        memcpy(&key, keystream + i, sizeof(uint64_t));
+        data ^= key;
+        memcpy(buffer + i, &data, sizeof(uint64_t));
+    }
+
+    for (; i < len; ++i)
+        buffer[i] ^= keystream[i];
+}
+
+rtp_error_t uvgrtp::srtp::encrypt(uvgrtp::crypto::aes::ctr& cipher, uint32_t ssrc, uint64_t index,
+    uint8_t *buffer, size_t len)
 {
     if (use_null_cipher_)
         return RTP_OK;
 
+    if (encrypt_precomputed(ssrc, index, buffer, len))
+        return RTP_OK;
+
     uint8_t iv[UVG_IV_LENGTH] = { 0 };
+
+    if (create_iv(iv, ssrc, index, local_srtp_ctx_->salt_key) != RTP_OK) {
+        UVG_LOG_ERROR("Failed to create IV, unable to encrypt the RTP packet!");
+        return RTP_INVALID_VALUE;
+    }
+
+    cipher.set_iv(iv);
+    cipher.encrypt(buffer, buffer, len);
+
+    return RTP_OK;
+}
+
+rtp_error_t uvgrtp::srtp::encrypt_aead(uvgrtp::crypto::aes::gcm& gcm, uint32_t ssrc, uint64_t index,
+    uvgrtp::buf_vec& buffers)
+{
+    uint8_t iv[UVG_AEAD_IV_LENGTH] = { 0 };
+    create_aead_iv(iv, ssrc, index, local_srtp_ctx_->salt_key);
+
+    /* The RTP header is authenticated and everything between it and the tag is encrypted */
+    gcm.set_iv(iv, UVG_AEAD_IV_LENGTH);
+    gcm.authenticate(buffers[0].second, buffers[0].first);
+
+    for (size_t i = 1; i < buffers.size() - 1; ++i)
+        gcm.encrypt(buffers[i].second, buffers[i].second, buffers[i].first);
+
+    gcm.final(buffers[buffers.size() - 1].second, UVG_AEAD_TAG_LENGTH);
+    return RTP_OK;
+}
+
+rtp_error_t uvgrtp::srtp::decrypt_aead(uvgrtp::frame::rtp_frame *frame, uint64_t index)
+{
+    /* RTP padding is part of the ciphertext, so it cannot be removed before decryption */
+    if (frame->padding_len || frame->payload_len < UVG_AEAD_TAG_LENGTH) {
+        UVG_LOG_ERROR("Invalid SRTP packet for AES-GCM");
+        return RTP_GENERIC_ERROR;
+    }
+
+    size_t hdr_len = frame->dgram_size - frame->payload_len;
+    size_t ct_len  = frame->payload_len - UVG_AEAD_TAG_LENGTH;
+
+    uint8_t iv[UVG_AEAD_IV_LENGTH] = { 0 };
+    create_aead_iv(iv, frame->header.ssrc, index, remote_srtp_ctx_->salt_key);
+
+    const uint8_t *tag = &frame->dgram[hdr_len + ct_len];
+
+    if (!remote_srtp_ctx_->aead->decrypt(frame->payload, &frame->dgram[hdr_len], ct_len,
+            iv, UVG_AEAD_IV_LENGTH, frame->dgram, hdr_len, tag, UVG_AEAD_TAG_LENGTH)) {
+        UVG_LOG_ERROR("Authentication tag mismatch!");
+        return RTP_GENERIC_ERROR;
+    }
+
+    if (is_replayed_packet(index)) {
+        UVG_LOG_ERROR("Replayed packet received, discarding!");
+        return RTP_GENERIC_ERROR;
+    }
+
+    frame->payload_len = ct_len;
+    return RTP_PKT_MODIFIED;
+}
+
+uint64_t uvgrtp::srtp::get_send_index(uint16_t seq)
+{
     uint64_t index = (((uint64_t)local_srtp_ctx_->roc) << 16) + seq;
 
     // Sequence number has wrapped around, update rollover Counter
@@ -35,60 +131,126 @@ rtp_error_t uvgrtp::srtp::encrypt(uint32_t ssrc, uint16_t seq, uint8_t *buffer,
         UVG_LOG_DEBUG("SRTP encryption rollover, rollovers so far: %lu", local_srtp_ctx_->roc);
     }
 
-    if (create_iv(iv, ssrc, index, local_srtp_ctx_->salt_key) != RTP_OK) {
-        UVG_LOG_ERROR("Failed to create IV, unable to encrypt the RTP packet!");
+    return index;
+}
+
+rtp_error_t uvgrtp::srtp::set_keystream_packets(size_t packets, size_t packet_size)
+{
+    if (packets > UVG_KEYSTREAM_MAX_PACKETS || (packets && !packet_size))
         return RTP_INVALID_VALUE;
-    }
 
-    uvgrtp::crypto::aes::ctr ctr(local_srtp_ctx_->enc_key, local_srtp_ctx_->n_e, iv);
-    ctr.encrypt(buffer, buffer, len);
+    if (use_aead() || use_null_cipher())
+        return RTP_NOT_SUPPORTED;
+
+    std::shared_ptr<keystream_ring> ring;
 
+    if (packets) {
+        auto local_ctx = local_srtp_ctx_;
+        uint8_t iv[UVG_IV_LENGTH] = { 0 };
+
+        ring = std::make_shared<keystream_ring>();
+        ring->size      = packets;
+        ring->slot_size = packet_size;
+        ring->slots     = std::unique_ptr<keystream_slot[]>(new keystream_slot[packets]);
+        ring->memory    = std::unique_ptr<uint8_t[]>(new uint8_t[packets * packet_size]);
+        ring->cipher    = std::unique_ptr<uvgrtp::crypto::aes::ctr>(
+            new uvgrtp::crypto::aes::ctr(local_ctx->enc_key, local_ctx->n_e, iv));
+        memcpy(ring->salt, local_ctx->salt_key, UVG_SALT_LENGTH);
+
+        for (size_t i = 0; i < packets; ++i)
+            ring->slots[i].data = &ring->memory[i * packet_size];
+    }
+
+    std::atomic_store(&keystream_, ring);
     return RTP_OK;
 }
 
-rtp_error_t uvgrtp::srtp::recv_packet_handler(void *arg, int rce_flags, frame::rtp_frame **out)
+void uvgrtp::srtp::fill_keystream(std::shared_ptr<keystream_ring> ring)
 {
-    (void)rce_flags;
+    uint32_t ssrc   = ring->ssrc.load(std::memory_order_acquire);
+    uint64_t next   = ring->next_index.load(std::memory_order_acquire);
+    uint64_t filled = ring->filled.load(std::memory_order_relaxed);
+    uint8_t iv[UVG_IV_LENGTH] = { 0 };
 
-    auto srtp  = (uvgrtp::srtp *)arg;
-    auto remote_ctx   = srtp->get_remote_ctx();
-    auto frame = *out;
+    if (ssrc != ring->filled_ssrc.load(std::memory_order_relaxed) || filled < next || filled > next + ring->size)
+        filled = next;
 
-    if (frame->dgram_size < RTP_HDR_SIZE || 
-        (srtp->authenticate_rtp() && frame->dgram_size < RTP_HDR_SIZE + UVG_AUTH_TAG_LENGTH))
-    {
-        UVG_LOG_ERROR("Received SRTP packet that has too small size");
-        return RTP_GENERIC_ERROR;
+    /* A slot that has not been used yet is never overwritten since the packet
+     * may still be encrypted from it, filling continues from it the next time */
+    for (; filled < next + ring->size; ++filled) {
+        keystream_slot& slot = ring->slots[filled % ring->size];
+
+        if (slot.state.load(std::memory_order_acquire) != KEYSTREAM_EMPTY) {
+            if (slot.index == filled && slot.ssrc == ssrc)
+                continue;
+            break;
+        }
+
+        (void)create_iv(iv, ssrc, filled, ring->salt);
+
+        memset(slot.data, 0, ring->slot_size);
+        ring->cipher->set_iv(iv);
+        ring->cipher->encrypt(slot.data, slot.data, ring->slot_size);
+
+        slot.index = filled;
+        slot.ssrc  = ssrc;
+        slot.state.store(KEYSTREAM_READY, std::memory_order_release);
     }
 
-    /* Calculate authentication tag for the packet and compare it against the one we received */
-    if (srtp->authenticate_rtp()) {
-        uint8_t digest[10] = { 0 };
-        auto hmac_sha1     = uvgrtp::crypto::hmac::sha1(remote_ctx->auth_key, UVG_AUTH_LENGTH);
+    ring->filled_ssrc.store(ssrc, std::memory_order_relaxed);
+    ring->filled.store(filled, std::memory_order_relaxed);
+    ring->filling.store(false, std::memory_order_release);
+}
 
-        hmac_sha1.update(frame->dgram, frame->dgram_size - UVG_AUTH_TAG_LENGTH);
-        hmac_sha1.update((uint8_t *)&remote_ctx->roc, sizeof(remote_ctx->roc));
-        hmac_sha1.final((uint8_t *)digest, UVG_AUTH_TAG_LENGTH);
+void uvgrtp::srtp::advance_keystream(uint32_t ssrc, uint64_t index)
+{
+    auto ring = std::atomic_load(&keystream_);
+    if (!ring)
+        return;
 
-        if (memcmp(digest, &frame->dgram[frame->dgram_size - UVG_AUTH_TAG_LENGTH], UVG_AUTH_TAG_LENGTH)) {
-            UVG_LOG_ERROR("Authentication tag mismatch!");
-            return RTP_GENERIC_ERROR;
-        }
+    ring->ssrc.store(ssrc, std::memory_order_relaxed);
+    ring->next_index.store(index + 1, std::memory_order_release);
 
-        if (srtp->is_replayed_packet(digest)) {
-            UVG_LOG_ERROR("Replayed packet received, discarding!");
-            return RTP_GENERIC_ERROR;
-        }
-        frame->payload_len -= UVG_AUTH_TAG_LENGTH;
+    // refill once half of the ring has been used
+    uint64_t filled = ring->filled.load(std::memory_order_relaxed);
+    bool low = ssrc != ring->filled_ssrc.load(std::memory_order_relaxed) ||
+        filled < index + 1 + ring->size / 2;
+
+    if (low && !ring->filling.exchange(true, std::memory_order_acq_rel))
+        uvgrtp::thread_pool::shared().submit([ring]() { fill_keystream(ring); });
+}
+
+bool uvgrtp::srtp::encrypt_precomputed(uint32_t ssrc, uint64_t index, uint8_t *buffer, size_t len)
+{
+    auto ring = std::atomic_load(&keystream_);
+    if (!ring)
+        return false;
+
+    keystream_slot& slot = ring->slots[index % ring->size];
+    int expected = KEYSTREAM_READY;
+
+    if (!slot.state.compare_exchange_strong(expected, KEYSTREAM_BUSY, std::memory_order_acquire))
+        return false;
+
+    // the slot may already hold the keystream of a later packet, which is kept for it
+    if (slot.index > index && slot.ssrc == ssrc) {
+        slot.state.store(KEYSTREAM_READY, std::memory_order_release);
+        return false;
     }
 
-    if (srtp->use_null_cipher())
-        return RTP_PKT_NOT_HANDLED;
+    // the slot is emptied even if the payload does not fit so that the ring keeps being filled
+    bool found = (slot.index == index && slot.ssrc == ssrc && len <= ring->slot_size);
+    if (found)
+        xor_keystream(buffer, slot.data, len);
 
-    uint16_t seq          = frame->header.seq;
-    uint32_t ssrc         = frame->header.ssrc;
-    uint32_t ts           = frame->header.timestamp;
-    uint64_t index        = 0;
+    slot.state.store(KEYSTREAM_EMPTY, std::memory_order_release);
+    return found;
+}
+
+uint64_t uvgrtp::srtp::get_receive_index(uint16_t seq, uint32_t ts)
+{
+    auto remote_ctx = remote_srtp_ctx_;
+    uint64_t index  = 0;
 
     /* as the sequence number approaches 0xffff and is close to wrapping around,
      * special care must be taken to use correct rollover counter as it's
@@ -117,34 +279,85 @@ rtp_error_t uvgrtp::srtp::recv_packet_handler(void *arg, int rce_flags, frame::r
         UVG_LOG_DEBUG("SRTP decryption rollover, rollovers so far: %lu", remote_ctx->roc);
     }
 
+    return index;
+}
+
+rtp_error_t uvgrtp::srtp::recv_packet_handler(void *arg, int rce_flags, frame::rtp_frame **out)
+{
+    (void)rce_flags;
+
+    auto srtp  = (uvgrtp::srtp *)arg;
+    auto remote_ctx   = srtp->get_remote_ctx();
+    auto frame = *out;
+
+    if (frame->dgram_size < RTP_HDR_SIZE || 
+        (srtp->authenticate_rtp() && frame->dgram_size < RTP_HDR_SIZE + UVG_AUTH_TAG_LENGTH))
+    {
+        UVG_LOG_ERROR("Received SRTP packet that has too small size");
+        return RTP_GENERIC_ERROR;
+    }
+
+    uint64_t index = srtp->get_receive_index(frame->header.seq, frame->header.timestamp);
+
+    if (srtp->use_aead())
+        return srtp->decrypt_aead(frame, index);
+
+    /* Calculate authentication tag for the packet and compare it against the one we received */
+    if (srtp->authenticate_rtp()) {
+        uint8_t digest[10] = { 0 };
+        auto& hmac_sha1    = *remote_ctx->auth;
+        uint32_t roc       = (uint32_t)(index >> 16);
+
+        hmac_sha1.update(frame->dgram, frame->dgram_size - UVG_AUTH_TAG_LENGTH);
+        hmac_sha1.update((uint8_t *)&roc, sizeof(roc));
+        hmac_sha1.final((uint8_t *)digest, UVG_AUTH_TAG_LENGTH);
+
+        if (memcmp(digest, &frame->dgram[frame->dgram_size - UVG_AUTH_TAG_LENGTH], UVG_AUTH_TAG_LENGTH)) {
+            UVG_LOG_ERROR("Authentication tag mismatch!");
+            return RTP_GENERIC_ERROR;
+        }
+
+        if (srtp->is_replayed_packet(index)) {
+            UVG_LOG_ERROR("Replayed packet received, discarding!");
+            return RTP_GENERIC_ERROR;
+        }
+        frame->payload_len -= UVG_AUTH_TAG_LENGTH;
+    }
+
+    if (srtp->use_null_cipher())
+        return RTP_PKT_NOT_HANDLED;
+
     uint8_t iv[UVG_IV_LENGTH] = { 0 };
-    if (srtp->create_iv(iv, ssrc, index, remote_ctx->salt_key) != RTP_OK) {
+    if (srtp->create_iv(iv, frame->header.ssrc, index, remote_ctx->salt_key) != RTP_OK) {
         UVG_LOG_ERROR("Failed to create IV, unable to encrypt the RTP packet!");
         return RTP_GENERIC_ERROR;
     }
 
-    uvgrtp::crypto::aes::ctr ctr(remote_ctx->enc_key, remote_ctx->n_e, iv);
-    ctr.decrypt(frame->payload, frame->payload, frame->payload_len);
+    remote_ctx->cipher->set_iv(iv);
+    remote_ctx->cipher->decrypt(frame->payload, frame->payload, frame->payload_len);
 
     return RTP_PKT_MODIFIED;
 }
 
-rtp_error_t uvgrtp::srtp::send_packet_handler(void *arg, uvgrtp::buf_vec& buffers)
+rtp_error_t uvgrtp::srtp::protect(uvgrtp::buf_vec& buffers, uint64_t index, uvgrtp::crypto::aes::ctr *cipher,
+    uvgrtp::crypto::hmac::sha1 *auth, uvgrtp::crypto::aes::gcm *aead)
 {
-    auto srtp       = (uvgrtp::srtp *)arg;
     auto frame      = (uvgrtp::frame::rtp_frame *)buffers.at(0).second;
-    auto local_ctx   = srtp->get_local_ctx();
-    auto off        = srtp->authenticate_rtp() ? 2 : 1;
+    auto off        = authenticate_rtp() ? 2 : 1;
     auto data       = buffers.at(buffers.size() - off);
-    auto hmac_sha1  = uvgrtp::crypto::hmac::sha1(local_ctx->auth_key, UVG_AUTH_LENGTH);
+    auto roc        = (uint32_t)(index >> 16);
     rtp_error_t ret = RTP_OK;
 
-    if (srtp->use_null_cipher())
+    if (use_aead())
+        return encrypt_aead(*aead, ntohl(frame->header.ssrc), index, buffers);
+
+    if (use_null_cipher())
         goto authenticate;
 
-    ret = srtp->encrypt(
+    ret = encrypt(
+        *cipher,
         ntohl(frame->header.ssrc),
-        ntohs(frame->header.seq),
+        index,
         data.second,
         data.first
     );
@@ -155,15 +368,86 @@ rtp_error_t uvgrtp::srtp::send_packet_handler(void *arg, uvgrtp::buf_vec& buffer
     }
 
 authenticate:
-    if (!srtp->authenticate_rtp())
+    if (!authenticate_rtp())
         return RTP_OK;
 
     for (size_t i = 0; i < buffers.size() - 1; ++i)
-        hmac_sha1.update((uint8_t *)buffers[i].second, buffers[i].first);
+        auth->update((uint8_t *)buffers[i].second, buffers[i].first);
+
+    auth->update((uint8_t *)&roc, sizeof(roc));
+    auth->final((uint8_t *)buffers[buffers.size() - 1].second, UVG_AUTH_TAG_LENGTH);
+
+    return ret;
+}
+
+std::unique_ptr<uvgrtp::srtp::send_transforms> uvgrtp::srtp::acquire_transforms()
+{
+    {
+        std::lock_guard<std::mutex> lk(transforms_mtx_);
+
+        if (!transforms_.empty()) {
+            std::unique_ptr<send_transforms> transforms = std::move(transforms_.back());
+            transforms_.pop_back();
+            return transforms;
+        }
+    }
+
+    auto local_ctx  = local_srtp_ctx_;
+    auto transforms = std::unique_ptr<send_transforms>(new send_transforms());
+
+    if (use_aead()) {
+        transforms->aead = std::unique_ptr<uvgrtp::crypto::aes::gcm>(
+            new uvgrtp::crypto::aes::gcm(local_ctx->enc_key, local_ctx->n_e));
+        return transforms;
+    }
+
+    uint8_t iv[UVG_IV_LENGTH] = { 0 };
+
+    transforms->cipher = std::unique_ptr<uvgrtp::crypto::aes::ctr>(
+        new uvgrtp::crypto::aes::ctr(local_ctx->enc_key, local_ctx->n_e, iv));
+    transforms->auth = std::unique_ptr<uvgrtp::crypto::hmac::sha1>(
+        new uvgrtp::crypto::hmac::sha1(local_ctx->auth_key, UVG_AUTH_LENGTH));
+
+    return transforms;
+}
+
+void uvgrtp::srtp::release_transforms(std::unique_ptr<send_transforms> transforms)
+{
+    std::lock_guard<std::mutex> lk(transforms_mtx_);
+    transforms_.push_back(std::move(transforms));
+}
+
+rtp_error_t uvgrtp::srtp::send_packet_handler(void *arg, uvgrtp::buf_vec& buffers)
+{
+    auto srtp      = (uvgrtp::srtp *)arg;
+    auto frame     = (uvgrtp::frame::rtp_frame *)buffers.at(0).second;
+    auto local_ctx = srtp->get_local_ctx();
+    auto index     = srtp->get_send_index(ntohs(frame->header.seq));
+
+    srtp->advance_keystream(ntohl(frame->header.ssrc), index);
+    return srtp->protect(buffers, index, local_ctx->cipher.get(), local_ctx->auth.get(), local_ctx->aead.get());
+}
+
+rtp_error_t uvgrtp::srtp::send_prepare_handler(void *arg, uvgrtp::buf_vec& buffers, uint64_t& index)
+{
+    auto srtp  = (uvgrtp::srtp *)arg;
+    auto frame = (uvgrtp::frame::rtp_frame *)buffers.at(0).second;
+
+    index = srtp->get_send_index(ntohs(frame->header.seq));
+    srtp->advance_keystream(ntohl(frame->header.ssrc), index);
+    return RTP_OK;
+}
+
+rtp_error_t uvgrtp::srtp::send_batch_handler(void *arg, uvgrtp::buf_vec *packets, const uint64_t *indices, size_t count)
+{
+    auto srtp       = (uvgrtp::srtp *)arg;
+    auto transforms = srtp->acquire_transforms();
+    rtp_error_t ret = RTP_OK;
 
-    hmac_sha1.update((uint8_t *)&local_ctx->roc, sizeof(local_ctx->roc));
-    hmac_sha1.final((uint8_t *)buffers[buffers.size() - 1].second, UVG_AUTH_TAG_LENGTH);
+    for (size_t i = 0; i < count && ret == RTP_OK; ++i)
+        ret = srtp->protect(packets[i], indices[i], transforms->cipher.get(), transforms->auth.get(), transforms->aead.get());
 
+    srtp->release_transforms(std::move(transforms));
     return ret;
 }
 
@@ -2,6 +2,9 @@
 
 #include "base.hh"
 
+#include <atomic>
+#include <mutex>
+
 namespace uvgrtp {
 
     namespace frame {
@@ -19,9 +22,101 @@ namespace uvgrtp {
             /* Encrypt the payload of an RTP packet and add authentication tag (if enabled) */
             static rtp_error_t send_packet_handler(void *arg, buf_vec& buffers);
 
+            /* send_packet_handler() split for RCE_PARALLEL_SRTP: the prepare handler assigns
+             * the packet index of each packet in order and the batch handler encrypts and
+             * authenticates a run of packets with the indices. Batch handlers may run at the same time */
+            static rtp_error_t send_prepare_handler(void *arg, buf_vec& buffers, uint64_t& index);
+            static rtp_error_t send_batch_handler(void *arg, buf_vec *packets, const uint64_t *indices, size_t count);
+
+            /* Compute the keystream of the next "packets" packets ahead of time, "packet_size"
+             * bytes for each. Zero stops computing the keystream ahead of time
+             *
+             * Return RTP_OK on success
+             * Return RTP_INVALID_VALUE if "packets" is larger than UVG_KEYSTREAM_MAX_PACKETS
+             * Return RTP_NOT_SUPPORTED if the packets are not encrypted with AES-CM */
+            rtp_error_t set_keystream_packets(size_t packets, size_t packet_size);
+
         private:
+            enum {
+                KEYSTREAM_EMPTY = 0, /* slot can be filled */
+                KEYSTREAM_READY = 1, /* slot contains the keystream of "index" */
+                KEYSTREAM_BUSY  = 2  /* slot is being used to encrypt a packet */
+            };
+
+            struct keystream_slot {
+                std::atomic<int> state{KEYSTREAM_EMPTY};
+                uint64_t index = 0;
+                uint32_t ssrc  = 0;
+                uint8_t *data  = nullptr;
+            };
+
+            /* Keystream of the upcoming packets, the keystream of packet "index" is in slot
+             * "index % size". The slots are filled by a worker of the shared pool which holds
+             * a reference to the ring so that the ring outlives the stream if needed */
+            struct keystream_ring {
+                std::unique_ptr<keystream_slot[]> slots;
+                std::unique_ptr<uint8_t[]> memory;
+                size_t size      = 0;
+                size_t slot_size = 0;
+
+                /* only used by the worker filling the ring */
+                std::unique_ptr<uvgrtp::crypto::aes::ctr> cipher;
+                uint8_t salt[UVG_SALT_LENGTH] = {};
+
+                /* SSRC and index of the next packet to be sent and
+                 * the index up to which the ring has been filled for that SSRC */
+                std::atomic<uint32_t> ssrc{0};
+                std::atomic<uint64_t> next_index{0};
+                std::atomic<uint32_t> filled_ssrc{0};
+                std::atomic<uint64_t> filled{0};
+
+                /* is a worker filling the ring or about to */
+                std::atomic<bool> filling{false};
+            };
+
+            /* Fill the empty slots of "ring" for the packets after the next packet to be sent */
+            static void fill_keystream(std::shared_ptr<keystream_ring> ring);
+
+            /* Tell the ring that packet "index" of "ssrc" is being sent and start filling it if needed */
+            void advance_keystream(uint32_t ssrc, uint64_t index);
+
+            /* Encrypt "buffer" with the keystream computed ahead of time for packet "index"
+             *
+             * Return false if the ring does not have the keystream, in which case
+             * the packet must be encrypted normally */
+            bool encrypt_precomputed(uint32_t ssrc, uint64_t index, uint8_t *buffer, size_t len);
+
+            /* Session key transforms of the local context. The sending thread uses the ones
+             * of the context and each worker of RCE_PARALLEL_SRTP takes its own set */
+            struct send_transforms {
+                std::unique_ptr<uvgrtp::crypto::aes::ctr> cipher;
+                std::unique_ptr<uvgrtp::crypto::hmac::sha1> auth;
+                std::unique_ptr<uvgrtp::crypto::aes::gcm> aead;
+            };
+
+            /* Encrypt and authenticate the packet "buffers" which has the packet index "index" */
+            rtp_error_t protect(buf_vec& buffers, uint64_t index, uvgrtp::crypto::aes::ctr *cipher,
+                uvgrtp::crypto::hmac::sha1 *auth, uvgrtp::crypto::aes::gcm *aead);
+
+            /* Get a set of transforms from the cache or create a new one if the cache is empty.
+             * Sets are returned to the cache with release_transforms() */
+            std::unique_ptr<send_transforms> acquire_transforms();
+            void release_transforms(std::unique_ptr<send_transforms> transforms);
+
             /* TODO:  */
-            rtp_error_t encrypt(uint32_t ssrc, uint16_t seq, uint8_t* buffer, size_t len);
+            rtp_error_t encrypt(uvgrtp::crypto::aes::ctr& cipher, uint32_t ssrc, uint64_t index, uint8_t* buffer, size_t len);
+
+            /* Encrypt the payload buffers of the packet with AES-GCM and write the tag to the last buffer */
+            rtp_error_t encrypt_aead(uvgrtp::crypto::aes::gcm& gcm, uint32_t ssrc, uint64_t index, buf_vec& buffers);
+
+            /* Decrypt and verify the received packet "frame" with AES-GCM */
+            rtp_error_t decrypt_aead(frame::rtp_frame *frame, uint64_t index);
+
+            /* Return the packet index of an outgoing packet and update the rollover counter */
+            uint64_t get_send_index(uint16_t seq);
+
+            /* Return the packet index of a received packet and update the rollover counter */
+            uint64_t get_receive_index(uint16_t seq, uint32_t ts);
 
             /* Has RTP packet authentication been enabled? */
             bool authenticate_rtp() const;
@@ -32,6 +127,13 @@ namespace uvgrtp {
              * The authentication tag will occupy the last 8 bytes of the RTP packet */
             bool authenticate_rtp_;
 
+            /* transforms of the workers that are not protecting packets at the moment */
+            std::vector<std::unique_ptr<send_transforms>> transforms_;
+            std::mutex transforms_mtx_;
+
+            /* RCC_SRTP_KEYSTREAM_PACKETS, nullptr if the keystream is not computed ahead of time.
+             * May be replaced while sending so it is accessed with std::atomic_load() */
+            std::shared_ptr<keystream_ring> keystream_;
     };
 }
 
@@ -0,0 +1,87 @@
+#include "thread_pool.hh"
+
+#include <algorithm>
+
+uvgrtp::thread_pool::thread_pool(unsigned int threads):
+    threads_(),
+    mtx_(),
+    cv_(),
+    tasks_(),
+    should_stop_(false)
+{
+    if (threads == 0)
+    {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        threads_.emplace_back(&uvgrtp::thread_pool::run, this);
+    }
+}
+
+uvgrtp::thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        should_stop_ = true;
+    }
+    cv_.notify_all();
+
+    for (auto& thread : threads_)
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+}
+
+void uvgrtp::thread_pool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void uvgrtp::thread_pool::submit(void (*task)(void *), void *arg)
+{
+    submit([task, arg]() { task(arg); });
+}
+
+size_t uvgrtp::thread_pool::thread_count() const
+{
+    return threads_.size();
+}
+
+uvgrtp::thread_pool& uvgrtp::thread_pool::shared()
+{
+    static thread_pool instance(0);
+    return instance;
+}
+
+void uvgrtp::thread_pool::run()
+{
+    while (true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            cv_.wait(lk, [this] { return should_stop_ || !tasks_.empty(); });
+
+            // the queued tasks are finished before stopping since their submitters may be waiting for them
+            if (tasks_.empty())
+            {
+                return;
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        task();
+    }
+}
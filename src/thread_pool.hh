@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace uvgrtp {
+
+    /* Fixed pool of worker threads for splitting the CPU-heavy work of one frame
+     *
+     * Tasks are run in the order they were submitted by whichever worker is free.
+     * A task must not wait for another task of the pool to finish, since that task may be
+     * queued behind it. The caller is responsible for waiting until its tasks have finished
+     * before the data they use goes out of scope, for example with std::packaged_task
+     * or a counter the tasks decrement */
+    class thread_pool {
+        public:
+            /* Create a pool of "threads" workers, 0 uses the number of hardware threads */
+            thread_pool(unsigned int threads);
+            ~thread_pool();
+
+            /* Queue "task" to be run by one of the workers */
+            void submit(std::function<void()> task);
+
+            /* Queue "task" to be called with "arg" by one of the workers. The call is
+             * small enough to be queued without allocating memory for it */
+            void submit(void (*task)(void *), void *arg);
+
+            size_t thread_count() const;
+
+            /* Pool shared by all media streams of the process, created on first use */
+            static thread_pool& shared();
+
+        private:
+            void run();
+
+            std::vector<std::thread> threads_;
+
+            std::mutex mtx_;
+            std::condition_variable cv_;
+            std::deque<std::function<void()>> tasks_;
+            bool should_stop_;
+    };
+}
+
+namespace uvg_rtp = uvgrtp;
@@ -0,0 +1,398 @@
+#include "uring.hh"
+
+#include "debug.hh"
+
+#ifdef UVGRTP_HAVE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <ctime>
+#endif
+
+#include <cstring>
+#include <algorithm>
+
+// io_uring accepts at most this many entries in a provided buffer ring
+constexpr unsigned int MAX_BUFFER_RING_ENTRIES = 32768;
+
+#ifdef UVGRTP_HAVE_IO_URING
+static inline int sys_io_uring_setup(unsigned int entries, struct io_uring_params *p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int sys_io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete,
+    unsigned int flags, void *arg, size_t arg_size)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size);
+}
+
+static inline int sys_io_uring_register(int fd, unsigned int opcode, void *arg, unsigned int nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+#endif
+
+uvgrtp::uring::uring():
+    ring_fd_(-1),
+    sq_ring_(nullptr),
+    sq_ring_size_(0),
+    sqes_(nullptr),
+    sqes_size_(0),
+    sq_head_(nullptr),
+    sq_tail_(nullptr),
+    sq_array_(nullptr),
+    sq_mask_(0),
+    sq_entries_(0),
+    sq_local_tail_(0),
+    to_submit_(0),
+    cq_ring_(nullptr),
+    cq_ring_size_(0),
+    cqes_(nullptr),
+    cq_head_(nullptr),
+    cq_tail_(nullptr),
+    cq_mask_(0),
+    buf_ring_(nullptr),
+    buf_ring_size_(0),
+    buf_mask_(0),
+    buf_tail_(0),
+    buf_pending_(0)
+{}
+
+uvgrtp::uring::~uring()
+{
+    destroy();
+}
+
+bool uvgrtp::uring::supported()
+{
+#ifdef UVGRTP_HAVE_IO_URING
+    uvgrtp::uring probe;
+    return probe.init(2, 4) == RTP_OK;
+#else
+    return false;
+#endif
+}
+
+rtp_error_t uvgrtp::uring::init(unsigned int sq_entries, unsigned int cq_entries)
+{
+#ifdef UVGRTP_HAVE_IO_URING
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    if (cq_entries > sq_entries)
+    {
+        params.flags |= IORING_SETUP_CQSIZE;
+        params.cq_entries = cq_entries;
+    }
+
+    if ((ring_fd_ = sys_io_uring_setup(sq_entries, &params)) < 0)
+    {
+        UVG_LOG_DEBUG("io_uring_setup(2) failed: %s", strerror(errno));
+        ring_fd_ = -1;
+        return RTP_NOT_SUPPORTED;
+    }
+
+    // timeouts are given to io_uring_enter(2) as an extended argument
+    if (!(params.features & IORING_FEAT_EXT_ARG))
+    {
+        UVG_LOG_DEBUG("The kernel is too old for io_uring support");
+        destroy();
+        return RTP_NOT_SUPPORTED;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ring_fd_, IORING_OFF_SQ_RING);
+
+    if (sq_ring_ == MAP_FAILED)
+    {
+        log_platform_error("mmap(2) failed");
+        sq_ring_ = nullptr;
+        destroy();
+        return RTP_NOT_SUPPORTED;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        cq_ring_ = sq_ring_;
+    }
+    else
+    {
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_fd_, IORING_OFF_CQ_RING);
+
+        if (cq_ring_ == MAP_FAILED)
+        {
+            log_platform_error("mmap(2) failed");
+            cq_ring_ = nullptr;
+            destroy();
+            return RTP_NOT_SUPPORTED;
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ring_fd_, IORING_OFF_SQES);
+
+    if (sqes == MAP_FAILED)
+    {
+        log_platform_error("mmap(2) failed");
+        destroy();
+        return RTP_NOT_SUPPORTED;
+    }
+    sqes_ = (struct io_uring_sqe *)sqes;
+
+    uint8_t *sq = (uint8_t *)sq_ring_;
+    sq_head_    = (unsigned int *)(sq + params.sq_off.head);
+    sq_tail_    = (unsigned int *)(sq + params.sq_off.tail);
+    sq_array_   = (unsigned int *)(sq + params.sq_off.array);
+    sq_mask_    = *(unsigned int *)(sq + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+
+    // submission queue entries are used in order, so the indirection array is an identity mapping
+    for (unsigned int i = 0; i < sq_entries_; ++i)
+    {
+        sq_array_[i] = i;
+    }
+    sq_local_tail_ = *sq_tail_;
+
+    uint8_t *cq = (uint8_t *)cq_ring_;
+    cq_head_ = (unsigned int *)(cq + params.cq_off.head);
+    cq_tail_ = (unsigned int *)(cq + params.cq_off.tail);
+    cq_mask_ = *(unsigned int *)(cq + params.cq_off.ring_mask);
+    cqes_    = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    return RTP_OK;
+#else
+    (void)sq_entries;
+    (void)cq_entries;
+    return RTP_NOT_SUPPORTED;
+#endif
+}
+
+void uvgrtp::uring::destroy()
+{
+#ifdef UVGRTP_HAVE_IO_URING
+    if (buf_ring_)
+    {
+        munmap(buf_ring_, buf_ring_size_);
+        buf_ring_ = nullptr;
+    }
+
+    if (sqes_)
+    {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+
+    if (cq_ring_ && cq_ring_ != sq_ring_)
+    {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    cq_ring_ = nullptr;
+
+    if (sq_ring_)
+    {
+        munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = nullptr;
+    }
+
+    // closing the ring also unregisters the buffer ring
+    if (ring_fd_ >= 0)
+    {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+#endif
+}
+
+io_uring_sqe *uvgrtp::uring::get_sqe()
+{
+#ifdef UVGRTP_HAVE_IO_URING
+    unsigned int head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+
+    if (sq_local_tail_ - head >= sq_entries_)
+        return nullptr;
+
+    struct io_uring_sqe *sqe = &sqes_[sq_local_tail_ & sq_mask_];
+    memset(sqe, 0, sizeof(*sqe));
+
+    ++sq_local_tail_;
+    ++to_submit_;
+
+    return sqe;
+#else
+    return nullptr;
+#endif
+}
+
+rtp_error_t uvgrtp::uring::submit_and_wait(unsigned int wait_nr, int timeout_ms)
+{
+#ifdef UVGRTP_HAVE_IO_URING
+    // make the prepared entries visible to the kernel
+    __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+
+    struct __kernel_timespec ts;
+    ts.tv_sec  = timeout_ms / 1000;
+    ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts         = (timeout_ms >= 0) ? (uint64_t)(uintptr_t)&ts : 0;
+
+    unsigned int flags = IORING_ENTER_EXT_ARG;
+    if (wait_nr)
+    {
+        flags |= IORING_ENTER_GETEVENTS;
+    }
+
+    int ret = sys_io_uring_enter(ring_fd_, to_submit_, wait_nr, flags, &arg, sizeof(arg));
+
+    if (ret < 0)
+    {
+        if (errno == ETIME || errno == EINTR)
+            return RTP_INTERRUPTED;
+
+        log_platform_error("io_uring_enter(2) failed");
+        return RTP_GENERIC_ERROR;
+    }
+
+    // the kernel consumes the submissions in order
+    to_submit_ -= std::min((unsigned int)ret, to_submit_);
+
+    return RTP_OK;
+#else
+    (void)wait_nr;
+    (void)timeout_ms;
+    return RTP_NOT_SUPPORTED;
+#endif
+}
+
+unsigned int uvgrtp::uring::discard_unsubmitted()
+{
+#ifdef UVGRTP_HAVE_IO_URING
+    // without SQPOLL the kernel only consumes entries inside io_uring_enter(2),
+    // so everything past the head is still ours
+    unsigned int head      = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    unsigned int discarded = sq_local_tail_ - head;
+
+    sq_local_tail_ = head;
+    __atomic_store_n(sq_tail_, head, __ATOMIC_RELEASE);
+    to_submit_ = 0;
+
+    return discarded;
+#else
+    return 0;
+#endif
+}
+
+bool uvgrtp::uring::next_completion(io_uring_cqe& cqe)
+{
+#ifdef UVGRTP_HAVE_IO_URING
+    unsigned int head = *cq_head_;
+
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE))
+        return false;
+
+    cqe = cqes_[head & cq_mask_];
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+#else
+    (void)cqe;
+    return false;
+#endif
+}
+
+rtp_error_t uvgrtp::uring::register_buffer_ring(uint16_t group, unsigned int entries)
+{
+    if (entries == 0 || entries > MAX_BUFFER_RING_ENTRIES)
+        return RTP_INVALID_VALUE;
+
+#ifdef UVGRTP_HAVE_IO_URING
+    unsigned int size = 1;
+    while (size < entries)
+        size <<= 1;
+
+    buf_ring_size_ = size * sizeof(struct io_uring_buf);
+
+    // the buffer ring must be page aligned
+    buf_ring_ = mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf_ring_ == MAP_FAILED)
+    {
+        log_platform_error("mmap(2) failed");
+        buf_ring_ = nullptr;
+        return RTP_GENERIC_ERROR;
+    }
+
+    memset(buf_ring_, 0, buf_ring_size_);
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr    = (uint64_t)(uintptr_t)buf_ring_;
+    reg.ring_entries = size;
+    reg.bgid         = group;
+
+    if (sys_io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        UVG_LOG_DEBUG("Registering the buffer ring failed: %s", strerror(errno));
+        munmap(buf_ring_, buf_ring_size_);
+        buf_ring_ = nullptr;
+        return RTP_GENERIC_ERROR;
+    }
+
+    buf_mask_    = size - 1;
+    buf_tail_    = 0;
+    buf_pending_ = 0;
+
+    return RTP_OK;
+#else
+    (void)group;
+    return RTP_NOT_SUPPORTED;
+#endif
+}
+
+void uvgrtp::uring::provide_buffer(uint8_t *buf, unsigned int len, uint16_t bid)
+{
+#ifdef UVGRTP_HAVE_IO_URING
+    struct io_uring_buf *entry = &((struct io_uring_buf *)buf_ring_)[(uint16_t)(buf_tail_ + buf_pending_) & buf_mask_];
+
+    entry->addr = (uint64_t)(uintptr_t)buf;
+    entry->len  = len;
+    entry->bid  = bid;
+
+    ++buf_pending_;
+#else
+    (void)buf;
+    (void)len;
+    (void)bid;
+#endif
+}
+
+void uvgrtp::uring::commit_buffers()
+{
+#ifdef UVGRTP_HAVE_IO_URING
+    if (!buf_pending_)
+        return;
+
+    /* The tail of the ring overlays the reserved field of the first buffer. struct io_uring_buf_ring
+     * is not used since in C++ its flexible array member does not start at offset zero */
+    struct io_uring_buf *bufs = (struct io_uring_buf *)buf_ring_;
+
+    buf_tail_ += buf_pending_;
+    buf_pending_ = 0;
+
+    __atomic_store_n(&bufs[0].resv, buf_tail_, __ATOMIC_RELEASE);
+#endif
+}
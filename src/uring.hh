@@ -0,0 +1,110 @@
+#pragma once
+
+#include "uvgrtp/util.hh"
+
+#ifdef UVGRTP_HAVE_IO_URING
+#include <linux/io_uring.h>
+#else
+struct io_uring_sqe;
+struct io_uring_cqe;
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+namespace uvgrtp {
+
+    /* Minimal io_uring instance built directly on top of the system calls
+     *
+     * uvgRTP does not depend on liburing, so this only implements what the socket and
+     * reception flow need: getting and submitting submission queue entries, reaping completions
+     * and a provided buffer ring from which multishot receives pick their buffers.
+     *
+     * An instance must only be used by one thread at a time.
+     *
+     * If uvgRTP was built without io_uring support, init() returns RTP_NOT_SUPPORTED
+     * and callers should use the regular system calls instead */
+    class uring {
+        public:
+            uring();
+            ~uring();
+
+            /* Create the io_uring instance with room for "sq_entries" submissions and "cq_entries" completions
+             *
+             * Return RTP_OK on success
+             * Return RTP_NOT_SUPPORTED if io_uring is not supported by the build or the kernel */
+            rtp_error_t init(unsigned int sq_entries, unsigned int cq_entries);
+
+            /* Return a cleared submission queue entry or nullptr if the submission queue is full */
+            io_uring_sqe *get_sqe();
+
+            /* Submit the prepared entries and wait until at least "wait_nr" completions are available
+             * or "timeout_ms" has passed. A negative timeout waits indefinitely
+             *
+             * Return RTP_OK on success
+             * Return RTP_INTERRUPTED if the wait timed out or was interrupted
+             * Return RTP_GENERIC_ERROR if io_uring_enter(2) failed */
+            rtp_error_t submit_and_wait(unsigned int wait_nr, int timeout_ms);
+
+            /* Withdraw the prepared entries the kernel has not consumed yet, for example after
+             * submit_and_wait() failed, so that they are never submitted
+             *
+             * Return the number of entries withdrawn */
+            unsigned int discard_unsubmitted();
+
+            /* Copy the next completion to "cqe" and remove it from the completion queue
+             *
+             * Return true if there was a completion */
+            bool next_completion(io_uring_cqe& cqe);
+
+            /* Register a ring of "entries" buffers, rounded up to a power of two,
+             * from which receives with IOSQE_BUFFER_SELECT and "group" pick their buffers
+             *
+             * Return RTP_OK on success
+             * Return RTP_INVALID_VALUE if "entries" is too large
+             * Return RTP_GENERIC_ERROR if the registration failed */
+            rtp_error_t register_buffer_ring(uint16_t group, unsigned int entries);
+
+            /* Add a buffer to the end of the buffer ring. The kernel sees the buffers after commit_buffers() */
+            void provide_buffer(uint8_t *buf, unsigned int len, uint16_t bid);
+            void commit_buffers();
+
+            /* Does the running kernel support io_uring */
+            static bool supported();
+
+        private:
+            void destroy();
+
+            int ring_fd_;
+
+            // submission queue
+            void *sq_ring_;
+            size_t sq_ring_size_;
+            io_uring_sqe *sqes_;
+            size_t sqes_size_;
+            unsigned int *sq_head_;
+            unsigned int *sq_tail_;
+            unsigned int *sq_array_;
+            unsigned int sq_mask_;
+            unsigned int sq_entries_;
+            unsigned int sq_local_tail_;
+            unsigned int to_submit_;
+
+            // completion queue
+            void *cq_ring_;
+            size_t cq_ring_size_;
+            io_uring_cqe *cqes_;
+            unsigned int *cq_head_;
+            unsigned int *cq_tail_;
+            unsigned int cq_mask_;
+
+            // provided buffer ring
+            void *buf_ring_;
+            size_t buf_ring_size_;
+            unsigned int buf_mask_;
+            uint16_t buf_tail_;
+            uint16_t buf_pending_;
+    };
+}
+
+namespace uvg_rtp = uvgrtp;
@@ -1,5 +1,18 @@
 #include "test_common.hh"
 
+#include "../src/pool.hh"
+#include "../src/rtp.hh"
+#include "../src/socket.hh"
+#include "../src/formats/media.hh"
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
 
 /* TODO: 1) Test only sending, 2) test sending with different configuration, 3) test receiving with different configurations, and 
  * 4) test sending and receiving within same test while checking frame size */
@@ -344,6 +357,461 @@ TEST(RTPTests, rtp_poll)
     cleanup_sess(ctx, sess);
 }
 
+TEST(RTPTests, rtp_frame_queue)
+{
+    // Tests that the frame queue of pull_frame() is bounded and drops frames according to the policy
+    std::cout << "Starting RTP frame queue test" << std::endl;
+    uvgrtp::context ctx;
+    uvgrtp::session* sess = ctx.create_session(REMOTE_ADDRESS);
+
+    uvgrtp::media_stream* sender = nullptr;
+    uvgrtp::media_stream* receiver = nullptr;
+
+    int flags = RCE_NO_FLAGS;
+    if (sess)
+    {
+        sender = sess->create_stream(RECEIVE_PORT, SEND_PORT, RTP_FORMAT_GENERIC, flags);
+        receiver = sess->create_stream(SEND_PORT, RECEIVE_PORT, RTP_FORMAT_GENERIC, flags);
+    }
+
+    EXPECT_NE(nullptr, sender);
+    EXPECT_NE(nullptr, receiver);
+
+    if (sender && receiver)
+    {
+        const int queue_size = 5;
+        const int test_packets = 10;
+        const size_t frame_size = 100;
+
+        EXPECT_EQ(RTP_INVALID_VALUE, receiver->configure_ctx(RCC_FRAME_QUEUE_SIZE, 0));
+        EXPECT_EQ(RTP_INVALID_VALUE, receiver->configure_ctx(RCC_FRAME_QUEUE_POLICY, 5));
+        EXPECT_EQ(RTP_OK, receiver->configure_ctx(RCC_FRAME_QUEUE_SIZE, queue_size));
+
+        std::vector<uint16_t> last_seqs;
+
+        for (int policy : { RFQ_DROP_OLDEST, RFQ_DROP_NEWEST })
+        {
+            EXPECT_EQ(RTP_OK, receiver->configure_ctx(RCC_FRAME_QUEUE_POLICY, policy));
+
+            std::unique_ptr<uint8_t[]> test_frame = create_test_packet(RTP_FORMAT_GENERIC, 0, false, frame_size, RTP_NO_FLAGS);
+            send_packets(std::move(test_frame), frame_size, sess, sender, test_packets, 0, false, RTP_NO_FLAGS, false);
+
+            // let the receiver fill the queue before pulling anything
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            std::vector<uint16_t> seqs;
+            while (uvgrtp::frame::rtp_frame* frame = receiver->pull_frame(100))
+            {
+                seqs.push_back(frame->header.seq);
+                process_rtp_frame(frame);
+            }
+
+            EXPECT_EQ(queue_size, (int)seqs.size());
+            for (size_t i = 1; i < seqs.size(); ++i)
+            {
+                EXPECT_EQ((uint16_t)(seqs[i - 1] + 1), seqs[i]);
+            }
+
+            // drop newest keeps the first frames of the second burst
+            if (policy == RFQ_DROP_NEWEST && !seqs.empty() && !last_seqs.empty())
+            {
+                EXPECT_EQ((uint16_t)(last_seqs.back() + 1), seqs.front());
+            }
+
+            last_seqs = seqs;
+        }
+    }
+
+    cleanup_ms(sess, sender);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+}
+
+TEST(RTPTests, rtp_reactor)
+{
+    // Tests that the streams of a context can be served by a shared pool of I/O threads
+    std::cout << "Starting RTP reactor test" << std::endl;
+    uvgrtp::context ctx;
+
+#ifdef __linux__
+    EXPECT_EQ(RTP_OK, ctx.enable_reactor(2));
+    EXPECT_EQ(RTP_INVALID_VALUE, ctx.enable_reactor(2));
+#else
+    if (ctx.enable_reactor(2) != RTP_OK)
+    {
+        std::cout << "Reactor not supported on this platform, skipping" << std::endl;
+        return;
+    }
+#endif
+
+    uvgrtp::session* sess = ctx.create_session(REMOTE_ADDRESS);
+
+    // more streams than there are I/O threads
+    const int stream_pairs = 4;
+    const int test_packets = 10;
+    const size_t frame_size = 100;
+
+    std::vector<uvgrtp::media_stream*> senders;
+    std::vector<uvgrtp::media_stream*> receivers;
+
+    if (sess)
+    {
+        for (int i = 0; i < stream_pairs; ++i)
+        {
+            uint16_t sender_port = SEND_PORT + 10 + 4 * i;
+            uint16_t receiver_port = sender_port + 2;
+
+            senders.push_back(sess->create_stream(sender_port, receiver_port, RTP_FORMAT_GENERIC, RCE_NO_FLAGS));
+            receivers.push_back(sess->create_stream(receiver_port, sender_port, RTP_FORMAT_GENERIC, RCE_NO_FLAGS));
+
+            EXPECT_NE(nullptr, senders.back());
+            EXPECT_NE(nullptr, receivers.back());
+        }
+    }
+
+    for (int i = 0; i < (int)senders.size(); ++i)
+    {
+        if (!senders[i] || !receivers[i])
+            continue;
+
+        for (int j = 0; j < test_packets; ++j)
+        {
+            std::unique_ptr<uint8_t[]> test_frame = create_test_packet(RTP_FORMAT_GENERIC, 0, false, frame_size, RTP_NO_FLAGS);
+            EXPECT_EQ(RTP_OK, senders[i]->push_frame(std::move(test_frame), frame_size, RTP_NO_FLAGS));
+        }
+    }
+
+    for (auto receiver : receivers)
+    {
+        if (!receiver)
+            continue;
+
+        int received = 0;
+        while (uvgrtp::frame::rtp_frame* frame = receiver->pull_frame(200))
+        {
+            EXPECT_EQ(frame_size, frame->payload_len);
+            process_rtp_frame(frame);
+            ++received;
+        }
+
+        EXPECT_EQ(test_packets, received);
+    }
+
+    for (int i = 0; i < (int)senders.size(); ++i)
+    {
+        cleanup_ms(sess, senders[i]);
+        cleanup_ms(sess, receivers[i]);
+    }
+    cleanup_sess(ctx, sess);
+}
+
+static void udp_gro_test(int rce_flags, uint16_t receiver_port)
+{
+#if defined(__linux__) && defined(UDP_SEGMENT)
+    uvgrtp::context ctx;
+    uvgrtp::session* sess = ctx.create_session(REMOTE_ADDRESS);
+
+    const uint16_t sender_port = receiver_port + 2;
+
+    uvgrtp::media_stream* receiver = nullptr;
+
+    EXPECT_NE(nullptr, sess);
+    if (sess)
+    {
+        receiver = sess->create_stream(receiver_port, sender_port, RTP_FORMAT_GENERIC, rce_flags);
+    }
+
+    EXPECT_NE(nullptr, receiver);
+
+    int sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+    EXPECT_GE(sock, 0);
+
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(sender_port);
+    local.sin_addr.s_addr = inet_addr(REMOTE_ADDRESS);
+
+    sockaddr_in remote = local;
+    remote.sin_port = htons(receiver_port);
+
+    EXPECT_EQ(0, ::bind(sock, (sockaddr*)&local, sizeof(local)));
+
+    // build equally sized RTP packets back to back and have the kernel send them as separate datagrams
+    const int test_packets = 10;
+    const size_t packet_size = 500;
+    const size_t header_size = 12;
+
+    std::vector<uint8_t> packets(test_packets * packet_size);
+    for (int i = 0; i < test_packets; ++i)
+    {
+        uint8_t* packet = packets.data() + i * packet_size;
+        memset(packet, 'a' + i, packet_size);
+
+        packet[0] = 2 << 6;
+        packet[1] = 96;
+        packet[2] = 0;
+        packet[3] = (uint8_t)i;
+        memset(packet + 4, 0, 4);
+        memset(packet + 8, 0x11, 4);
+    }
+
+    uint16_t segment_size = (uint16_t)packet_size;
+    char control[CMSG_SPACE(sizeof(segment_size))] = {};
+
+    iovec iov = { packets.data(), packets.size() };
+    msghdr msg = {};
+    msg.msg_name = &remote;
+    msg.msg_namelen = sizeof(remote);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(segment_size));
+    memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+
+    if (receiver && sock >= 0 && ::sendmsg(sock, &msg, 0) < 0)
+    {
+        std::cout << "UDP GSO not supported by the kernel, skipping" << std::endl;
+        cleanup_ms(sess, receiver);
+        cleanup_sess(ctx, sess);
+        ::close(sock);
+        return;
+    }
+
+    int received = 0;
+    while (receiver)
+    {
+        uvgrtp::frame::rtp_frame* frame = receiver->pull_frame(200);
+        if (!frame)
+            break;
+
+        EXPECT_EQ(packet_size - header_size, frame->payload_len);
+        if (frame->payload_len == packet_size - header_size)
+        {
+            EXPECT_EQ('a' + received, frame->payload[0]);
+            EXPECT_EQ('a' + received, frame->payload[frame->payload_len - 1]);
+        }
+
+        process_rtp_frame(frame);
+        ++received;
+    }
+
+    EXPECT_EQ(test_packets, received);
+
+    ::close(sock);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+#else
+    (void)rce_flags;
+    (void)receiver_port;
+    std::cout << "UDP GRO not supported on this platform, skipping" << std::endl;
+#endif
+}
+
+TEST(RTPTests, rtp_udp_gro)
+{
+    // Tests that datagrams coalesced by UDP GRO are split back into individual RTP packets
+    std::cout << "Starting RTP UDP GRO test" << std::endl;
+    udp_gro_test(RCE_UDP_GRO, SEND_PORT + 30);
+}
+
+TEST(RTPTests, rtp_udp_gro_io_uring)
+{
+    // Tests that the io_uring receiver gets the segment size of coalesced datagrams from the kernel
+    std::cout << "Starting RTP UDP GRO io_uring test" << std::endl;
+    udp_gro_test(RCE_UDP_GRO | RCE_IO_URING, SEND_PORT + 34);
+}
+
+TEST(RTPTests, rtp_arrival_time)
+{
+    // Tests that received frames carry the time the packet arrived
+    std::cout << "Starting RTP arrival time test" << std::endl;
+    uvgrtp::context ctx;
+    uvgrtp::session* sess = ctx.create_session(REMOTE_ADDRESS);
+
+    uvgrtp::media_stream* sender = nullptr;
+    uvgrtp::media_stream* receiver = nullptr;
+
+    const uint16_t sender_port = SEND_PORT + 40;
+    const uint16_t receiver_port = sender_port + 2;
+
+    EXPECT_NE(nullptr, sess);
+    if (sess)
+    {
+        sender = sess->create_stream(sender_port, receiver_port, RTP_FORMAT_GENERIC, RCE_NO_FLAGS);
+        receiver = sess->create_stream(receiver_port, sender_port, RTP_FORMAT_GENERIC, RCE_NO_FLAGS);
+    }
+
+    EXPECT_NE(nullptr, sender);
+    EXPECT_NE(nullptr, receiver);
+
+    if (sender && receiver)
+    {
+        const int test_packets = 10;
+        const size_t frame_size = 100;
+
+        uint64_t send_start = uvgrtp::clock::ntp::now();
+
+        for (int i = 0; i < test_packets; ++i)
+        {
+            std::unique_ptr<uint8_t[]> test_frame = create_test_packet(RTP_FORMAT_GENERIC, 0, false, frame_size, RTP_NO_FLAGS);
+            EXPECT_EQ(RTP_OK, sender->push_frame(std::move(test_frame), frame_size, RTP_NO_FLAGS));
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        // the frames are pulled after all of them have been sent, the arrival time must still be when they arrived
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        uint64_t pull_start = uvgrtp::clock::ntp::now();
+
+        int received = 0;
+        uint64_t previous = 0;
+
+        while (uvgrtp::frame::rtp_frame* frame = receiver->pull_frame(200))
+        {
+            EXPECT_GE(frame->arrival_ntp, send_start);
+            EXPECT_LE(frame->arrival_ntp, pull_start);
+            EXPECT_GE(frame->arrival_ntp, previous);
+
+            previous = frame->arrival_ntp;
+            process_rtp_frame(frame);
+            ++received;
+        }
+
+        EXPECT_EQ(test_packets, received);
+    }
+
+    cleanup_ms(sess, sender);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+}
+
+TEST(RTPTests, rtp_frame_pool)
+{
+    // Tests that freed frames and payloads are reused instead of going back to the heap
+    std::cout << "Starting RTP frame pool test" << std::endl;
+
+    void* block = uvgrtp::pool::alloc(1000);
+    EXPECT_NE(nullptr, block);
+    EXPECT_EQ(0u, (uintptr_t)block % 16);
+    uvgrtp::pool::release(block);
+
+    // same size class
+    EXPECT_EQ(block, uvgrtp::pool::alloc(600));
+    uvgrtp::pool::release(block);
+
+    // too large for the pool
+    void* large = uvgrtp::pool::alloc(1000000);
+    EXPECT_NE(nullptr, large);
+    memset(large, 0, 1000000);
+    uvgrtp::pool::release(large);
+
+    uvgrtp::frame::rtp_frame* frame = uvgrtp::frame::alloc_rtp_frame(1400);
+    EXPECT_NE(nullptr, frame);
+
+    if (frame)
+    {
+        uint8_t* payload = frame->payload;
+        memset(frame->payload, 'a', frame->payload_len);
+
+        // a payload the application has attached itself is freed with delete[]
+        uvgrtp::frame::rtp_frame* own = uvgrtp::frame::alloc_rtp_frame();
+        own->payload = new uint8_t[100];
+        own->payload_len = 100;
+        EXPECT_EQ(RTP_OK, uvgrtp::frame::dealloc_frame(own));
+
+        EXPECT_EQ(RTP_OK, uvgrtp::frame::dealloc_frame(frame));
+
+        frame = uvgrtp::frame::alloc_rtp_frame(1400);
+        EXPECT_EQ(payload, frame->payload);
+        EXPECT_EQ(RTP_OK, uvgrtp::frame::dealloc_frame(frame));
+    }
+
+    // frames are often freed on another thread than where they were allocated
+    std::vector<uvgrtp::frame::rtp_frame*> frames;
+    for (int i = 0; i < 1000; ++i)
+    {
+        frames.push_back(uvgrtp::frame::alloc_rtp_frame(100 + i));
+    }
+
+    std::thread releaser([&frames]() {
+        for (auto f : frames)
+        {
+            EXPECT_EQ(RTP_OK, uvgrtp::frame::dealloc_frame(f));
+        }
+    });
+    releaser.join();
+}
+
+TEST(RTPTests, rtp_ring_buffer_resize)
+{
+    // Tests resizing the reception ring buffer while receiving, with frames still pointing to the old ring
+    std::cout << "Starting RTP ring buffer resize test" << std::endl;
+    uvgrtp::context ctx;
+    uvgrtp::session* sess = ctx.create_session(REMOTE_ADDRESS);
+
+    uvgrtp::media_stream* sender = nullptr;
+    uvgrtp::media_stream* receiver = nullptr;
+
+    const uint16_t sender_port = SEND_PORT + 50;
+    const uint16_t receiver_port = sender_port + 2;
+
+    EXPECT_NE(nullptr, sess);
+    if (sess)
+    {
+        sender = sess->create_stream(sender_port, receiver_port, RTP_FORMAT_GENERIC, RCE_NO_FLAGS);
+        receiver = sess->create_stream(receiver_port, sender_port, RTP_FORMAT_GENERIC, RCE_ZERO_COPY_RECEIVE);
+    }
+
+    EXPECT_NE(nullptr, sender);
+    EXPECT_NE(nullptr, receiver);
+
+    std::vector<uvgrtp::frame::rtp_frame*> frames;
+    const int test_packets = 20;
+    const size_t frame_size = 1000;
+
+    if (sender && receiver)
+    {
+        for (int round = 0; round < 3; ++round)
+        {
+            for (int i = 0; i < test_packets; ++i)
+            {
+                std::unique_ptr<uint8_t[]> test_frame = std::unique_ptr<uint8_t[]>(new uint8_t[frame_size]);
+                memset(test_frame.get(), 'a' + round, frame_size);
+                EXPECT_EQ(RTP_OK, sender->push_frame(std::move(test_frame), frame_size, RTP_NO_FLAGS));
+            }
+
+            int received = 0;
+            while (uvgrtp::frame::rtp_frame* frame = receiver->pull_frame(100))
+            {
+                EXPECT_EQ(frame_size, frame->payload_len);
+                EXPECT_EQ('a' + round, frame->payload[0]);
+                frames.push_back(frame);
+                ++received;
+            }
+            EXPECT_EQ(test_packets, received);
+
+            // the new ring is taken into use once the old one has been processed
+            EXPECT_EQ(RTP_OK, receiver->configure_ctx(RCC_RING_BUFFER_SIZE, 40000 + round * 100000));
+            EXPECT_EQ(RTP_OK, receiver->configure_ctx(RCC_MTU_SIZE, 1400 - round * 100));
+        }
+    }
+
+    cleanup_ms(sess, sender);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+
+    // the frames keep the memory of the rings alive
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        EXPECT_EQ('a' + (int)(i / test_packets), frames[i]->payload[frame_size - 1]);
+        (void)uvgrtp::frame::dealloc_frame(frames[i]);
+    }
+}
+
 TEST(RTPTests, send_large_amounts)
 {
     // Tests sending large amounts of data to make sure nothing breaks because of it
@@ -384,4 +852,88 @@ TEST(RTPTests, send_large_amounts)
     cleanup_ms(sess, sender);
     cleanup_ms(sess, receiver);
     cleanup_sess(ctx, sess);
-}
\ No newline at end of file
+}
+
+static uvgrtp::frame::rtp_frame* create_generic_fragment(uint16_t seq, uint32_t ts, bool marker)
+{
+    uvgrtp::frame::rtp_frame* frame = uvgrtp::frame::alloc_rtp_frame(1000);
+    memset(frame->payload, (int)(seq & 0xff), frame->payload_len);
+
+    frame->header.version = 2;
+    frame->header.marker = marker;
+    frame->header.seq = seq;
+    frame->header.timestamp = ts;
+
+    return frame;
+}
+
+TEST(RTPTests, rtp_generic_reassembly_loss)
+{
+    std::cout << "Starting generic fragment loss test" << std::endl;
+    auto ssrc = std::make_shared<std::atomic<std::uint32_t>>(1);
+    auto rtp = std::make_shared<uvgrtp::rtp>(RTP_FORMAT_GENERIC, ssrc);
+    auto socket = std::shared_ptr<uvgrtp::socket>(new uvgrtp::socket(0));
+    uvgrtp::formats::media format(socket, rtp, RCE_FRAGMENT_GENERIC);
+    uvgrtp::formats::media_frame_info_t* minfo = format.get_media_frame_info();
+
+    const int flags = RCE_FRAGMENT_GENERIC;
+    uvgrtp::frame::rtp_frame* frame = nullptr;
+
+    // a fragment reordered within the frame still completes it, across the sequence number wrap-around
+    uint16_t seq = 65530;
+    frame = create_generic_fragment(seq + 1, 1000, false);
+    EXPECT_EQ(RTP_OK, format.packet_handler(minfo, flags, &frame));
+    frame = create_generic_fragment(seq + 0, 1000, false);
+    EXPECT_EQ(RTP_OK, format.packet_handler(minfo, flags, &frame));
+    for (uint16_t i = 2; i < 9; ++i)
+    {
+        frame = create_generic_fragment(seq + i, 1000, i == 8);
+        EXPECT_EQ(i == 8 ? RTP_PKT_READY : RTP_OK, format.packet_handler(minfo, flags, &frame));
+    }
+
+    EXPECT_NE(nullptr, frame);
+    if (frame)
+    {
+        EXPECT_EQ(9000, frame->payload_len);
+        for (uint16_t i = 0; i < 9; ++i)
+        {
+            EXPECT_EQ((uint8_t)((uint16_t)(seq + i) & 0xff), frame->payload[i * 1000]);
+        }
+        (void)uvgrtp::frame::dealloc_frame(frame);
+    }
+    EXPECT_EQ(0, minfo->frames.buffered());
+    seq += 9;
+
+    // the second fragment is lost and the stream moves on, so the frame is dropped
+    uint16_t lost_seq = seq + 1;
+    frame = create_generic_fragment(seq, 2000, false);
+    EXPECT_EQ(RTP_OK, format.packet_handler(minfo, flags, &frame));
+    frame = create_generic_fragment(seq + 2, 2000, true);
+    EXPECT_EQ(RTP_OK, format.packet_handler(minfo, flags, &frame));
+    seq += 3;
+
+    for (int i = 0; i < 100; ++i, ++seq)
+    {
+        frame = create_generic_fragment(seq, 3000 + i, true);
+        EXPECT_EQ(RTP_PKT_READY, format.packet_handler(minfo, flags, &frame));
+        (void)uvgrtp::frame::dealloc_frame(frame);
+    }
+
+    EXPECT_EQ(0, minfo->frames.buffered());
+    EXPECT_EQ(0u, minfo->frames.unfinished_frames());
+
+    frame = create_generic_fragment(lost_seq, 2000, false);
+    EXPECT_EQ(RTP_GENERIC_ERROR, format.packet_handler(minfo, flags, &frame));
+
+    // unfinished frames are limited by the memory limit
+    rtp->set_reassembly_limit(10000);
+
+    for (int i = 0; i < 20; ++i, ++seq)
+    {
+        frame = create_generic_fragment(seq, 4000, false);
+        EXPECT_EQ(RTP_OK, format.packet_handler(minfo, flags, &frame));
+        EXPECT_GE(10000, minfo->frames.buffered());
+    }
+
+    // the destructor frees the fragments of the unfinished frame
+}
@@ -197,6 +197,70 @@ TEST(RTCP_double_bind_test, rtcp) {
     cleanup(ctx, local_session, remote_session, local_stream, remote_stream);
 }
 
+TEST(RTCPTests, rtcp_reactor) {
+    // Tests that the RTCP reports are sent and received by the I/O threads of the reactor
+    std::cout << "Starting uvgRTP RTCP reactor test" << std::endl;
+
+    uvgrtp::context ctx;
+    if (ctx.enable_reactor(1) != RTP_OK)
+    {
+        std::cout << "Reactor not supported on this platform, skipping" << std::endl;
+        return;
+    }
+
+    uvgrtp::session* local_session = ctx.create_session(REMOTE_ADDRESS);
+    uvgrtp::session* remote_session = ctx.create_session(LOCAL_INTERFACE);
+
+    int flags = RCE_RTCP | RCE_HOLEPUNCH_KEEPALIVE;
+
+    uvgrtp::media_stream* local_stream = nullptr;
+    if (local_session)
+    {
+        local_stream = local_session->create_stream(LOCAL_PORT, REMOTE_PORT, RTP_FORMAT_GENERIC, flags);
+    }
+
+    uvgrtp::media_stream* remote_stream = nullptr;
+    if (remote_session)
+    {
+        remote_stream = remote_session->create_stream(REMOTE_PORT, LOCAL_PORT, RTP_FORMAT_GENERIC, flags);
+    }
+
+    EXPECT_NE(nullptr, local_stream);
+    EXPECT_NE(nullptr, remote_stream);
+
+    std::atomic<int> reports(0);
+    if (local_stream)
+    {
+        EXPECT_EQ(RTP_OK, local_stream->get_rtcp()->install_receiver_hook(
+            [&reports](std::unique_ptr<uvgrtp::frame::rtcp_receiver_report> frame) {
+                EXPECT_NE(nullptr, frame);
+                ++reports;
+            }));
+    }
+
+    if (remote_stream)
+    {
+        EXPECT_EQ(RTP_OK, remote_stream->get_rtcp()->install_sender_hook(
+            [&reports](std::unique_ptr<uvgrtp::frame::rtcp_sender_report> frame) {
+                EXPECT_NE(nullptr, frame);
+                ++reports;
+            }));
+    }
+
+    if (local_stream)
+    {
+        std::unique_ptr<uint8_t[]> test_frame = std::unique_ptr<uint8_t[]>(new uint8_t[PAYLOAD_LEN]);
+        memset(test_frame.get(), 'b', PAYLOAD_LEN);
+
+        // the reports are sent every "interval" starting from half an interval, which is at most 5 seconds
+        send_packets(std::move(test_frame), PAYLOAD_LEN, local_session, local_stream, FRAME_RATE * 7, PACKET_INTERVAL_MS, true, RTP_NO_FLAGS);
+    }
+
+    EXPECT_LT(0, reports.load());
+
+    cleanup(ctx, local_session, remote_session, local_stream, remote_stream);
+}
+
 void receiver_hook(uvgrtp::frame::rtcp_receiver_report* frame)
 {
     std::cout << std::endl << "RTCP receiver report! ----------" << std::endl;
@@ -1,5 +1,9 @@
 #include "test_common.hh"
 
+#include "../src/formats/h265.hh"
+#include "../src/rtp.hh"
+
+#include <algorithm>
 #include <numeric>
 
 constexpr uint16_t SEND_PORT = 9100;
@@ -440,4 +444,625 @@ TEST(FormatTests, h266_fragmentation)
     cleanup_ms(sess, sender);
     cleanup_ms(sess, receiver);
     cleanup_sess(ctx, sess);
-}
\ No newline at end of file
+}
+
+TEST(FormatTests, h265_zero_copy)
+{
+    std::cout << "Starting H265 zero-copy receive test" << std::endl;
+    uvgrtp::context ctx;
+    uvgrtp::session* sess = ctx.create_session(LOCAL_ADDRESS);
+
+    uvgrtp::media_stream* sender = nullptr;
+    uvgrtp::media_stream* receiver = nullptr;
+
+    if (sess)
+    {
+        sender = sess->create_stream(SEND_PORT, RECEIVE_PORT, RTP_FORMAT_H265, RCE_NO_FLAGS);
+        receiver = sess->create_stream(RECEIVE_PORT, SEND_PORT, RTP_FORMAT_H265, RCE_ZERO_COPY_RECEIVE);
+    }
+
+    EXPECT_NE(nullptr, sender);
+    EXPECT_NE(nullptr, receiver);
+
+    if (sender && receiver)
+    {
+        // single NAL units are returned without copying, fragmented ones keep their fragments alive until reassembly
+        std::vector<size_t> test_sizes = { 100, 1000, 5000, 100, 25000 };
+        std::vector<uvgrtp::frame::rtp_frame*> frames;
+
+        for (auto& size : test_sizes)
+        {
+            std::unique_ptr<uint8_t[]> intra_frame = create_test_packet(RTP_FORMAT_H265, 19, true, size, RTP_NO_FLAGS);
+            std::unique_ptr<uint8_t[]> expected = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
+            memcpy(expected.get(), intra_frame.get(), size);
+
+            EXPECT_EQ(RTP_OK, sender->push_frame(std::move(intra_frame), size, RTP_NO_FLAGS));
+
+            uvgrtp::frame::rtp_frame* frame = receiver->pull_frame(1000);
+            EXPECT_NE(nullptr, frame);
+
+            if (frame)
+            {
+                EXPECT_EQ(size, frame->payload_len);
+                if (frame->payload_len == size)
+                {
+                    // start code and NAL unit data, the NAL header of fragmented units is rebuilt by the receiver
+                    EXPECT_EQ(0, memcmp(expected.get(), frame->payload, 4));
+                    EXPECT_EQ(0, memcmp(expected.get() + 6, frame->payload + 6, size - 6));
+                }
+
+                // hold onto the frames so that the ring buffer has to move on to new memory
+                frames.push_back(frame);
+            }
+        }
+
+        for (auto& frame : frames)
+        {
+            EXPECT_EQ(2, frame->header.version);
+            (void)uvgrtp::frame::dealloc_frame(frame);
+        }
+    }
+
+    cleanup_ms(sess, sender);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+}
+
+TEST(FormatTests, h265_io_uring)
+{
+    std::cout << "Starting H265 io_uring test" << std::endl;
+    uvgrtp::context ctx;
+    uvgrtp::session* sess = ctx.create_session(LOCAL_ADDRESS);
+
+    uvgrtp::media_stream* sender = nullptr;
+    uvgrtp::media_stream* receiver = nullptr;
+
+    // falls back to regular system calls if io_uring is not available
+    if (sess)
+    {
+        sender = sess->create_stream(SEND_PORT, RECEIVE_PORT, RTP_FORMAT_H265, RCE_IO_URING);
+        receiver = sess->create_stream(RECEIVE_PORT, SEND_PORT, RTP_FORMAT_H265, RCE_IO_URING | RCE_ZERO_COPY_RECEIVE);
+    }
+
+    EXPECT_NE(nullptr, sender);
+    EXPECT_NE(nullptr, receiver);
+
+    if (sender && receiver)
+    {
+        // the fragmented frames are sent as linked requests and wrap the ring buffer around several times
+        std::vector<size_t> test_sizes = { 100, 5000 };
+        for (int i = 0; i < 40; ++i)
+        {
+            test_sizes.push_back(400000);
+        }
+        test_sizes.push_back(100);
+
+        for (auto& size : test_sizes)
+        {
+            std::unique_ptr<uint8_t[]> intra_frame = create_test_packet(RTP_FORMAT_H265, 19, true, size, RTP_NO_FLAGS);
+            std::unique_ptr<uint8_t[]> expected = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
+            memcpy(expected.get(), intra_frame.get(), size);
+
+            EXPECT_EQ(RTP_OK, sender->push_frame(std::move(intra_frame), size, RTP_NO_FLAGS));
+
+            uvgrtp::frame::rtp_frame* frame = receiver->pull_frame(1000);
+            EXPECT_NE(nullptr, frame);
+
+            if (frame)
+            {
+                EXPECT_EQ(size, frame->payload_len);
+                if (frame->payload_len == size)
+                {
+                    // start code and NAL unit data, the NAL header of fragmented units is rebuilt by the receiver
+                    EXPECT_EQ(0, memcmp(expected.get(), frame->payload, 4));
+                    EXPECT_EQ(0, memcmp(expected.get() + 6, frame->payload + 6, size - 6));
+                }
+
+                (void)uvgrtp::frame::dealloc_frame(frame);
+            }
+        }
+    }
+
+    cleanup_ms(sess, sender);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+}
+
+TEST(FormatTests, h265_udp_gso)
+{
+    std::cout << "Starting H265 UDP GSO test" << std::endl;
+    uvgrtp::context ctx;
+    uvgrtp::session* sess = ctx.create_session(LOCAL_ADDRESS);
+
+    uvgrtp::media_stream* sender = nullptr;
+    uvgrtp::media_stream* receiver = nullptr;
+
+    // falls back to sending the packets one by one if GSO is not available
+    if (sess)
+    {
+        sender = sess->create_stream(SEND_PORT, RECEIVE_PORT, RTP_FORMAT_H265, RCE_UDP_GSO);
+        receiver = sess->create_stream(RECEIVE_PORT, SEND_PORT, RTP_FORMAT_H265, RCE_UDP_GRO);
+    }
+
+    EXPECT_NE(nullptr, sender);
+    EXPECT_NE(nullptr, receiver);
+
+    if (sender && receiver)
+    {
+        // the fragments of the large frames are sent as GSO buffers and coalesced again by GRO
+        std::vector<size_t> test_sizes = { 100, 5000 };
+        for (int i = 0; i < 10; ++i)
+        {
+            test_sizes.push_back(400000);
+        }
+        test_sizes.push_back(100);
+
+        for (auto& size : test_sizes)
+        {
+            std::unique_ptr<uint8_t[]> intra_frame = create_test_packet(RTP_FORMAT_H265, 19, true, size, RTP_NO_FLAGS);
+            std::unique_ptr<uint8_t[]> expected = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
+            memcpy(expected.get(), intra_frame.get(), size);
+
+            EXPECT_EQ(RTP_OK, sender->push_frame(std::move(intra_frame), size, RTP_NO_FLAGS));
+
+            uvgrtp::frame::rtp_frame* frame = receiver->pull_frame(1000);
+            EXPECT_NE(nullptr, frame);
+
+            if (frame)
+            {
+                EXPECT_EQ(size, frame->payload_len);
+                if (frame->payload_len == size)
+                {
+                    // start code and NAL unit data, the NAL header of fragmented units is rebuilt by the receiver
+                    EXPECT_EQ(0, memcmp(expected.get(), frame->payload, 4));
+                    EXPECT_EQ(0, memcmp(expected.get() + 6, frame->payload + 6, size - 6));
+                }
+
+                (void)uvgrtp::frame::dealloc_frame(frame);
+            }
+        }
+    }
+
+    cleanup_ms(sess, sender);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+}
+
+// push "size" bytes of "data" as one frame with "sender_flags" and return the payloads of the received frames
+static std::vector<std::vector<uint8_t>> send_and_receive_h265(int sender_flags, const uint8_t* data, size_t size,
+    size_t expected_frames)
+{
+    std::vector<std::vector<uint8_t>> received;
+
+    uvgrtp::context ctx;
+    uvgrtp::session* sess = ctx.create_session(LOCAL_ADDRESS);
+
+    uvgrtp::media_stream* sender = nullptr;
+    uvgrtp::media_stream* receiver = nullptr;
+
+    if (sess)
+    {
+        sender = sess->create_stream(SEND_PORT, RECEIVE_PORT, RTP_FORMAT_H265, sender_flags);
+        receiver = sess->create_stream(RECEIVE_PORT, SEND_PORT, RTP_FORMAT_H265, RCE_NO_H26X_PREPEND_SC);
+    }
+
+    EXPECT_NE(nullptr, sender);
+    EXPECT_NE(nullptr, receiver);
+
+    if (sender && receiver)
+    {
+        EXPECT_EQ(RTP_OK, sender->configure_ctx(RCC_MTU_SIZE, 60000));
+        EXPECT_EQ(RTP_OK, receiver->configure_ctx(RCC_MTU_SIZE, 60000));
+
+        std::unique_ptr<uint8_t[]> frame_data = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
+        memcpy(frame_data.get(), data, size);
+
+        EXPECT_EQ(RTP_OK, sender->push_frame(std::move(frame_data), size, RTP_NO_FLAGS));
+
+        for (size_t i = 0; i < expected_frames; ++i)
+        {
+            uvgrtp::frame::rtp_frame* frame = receiver->pull_frame(1000);
+            EXPECT_NE(nullptr, frame);
+
+            if (!frame)
+                break;
+
+            received.emplace_back(frame->payload, frame->payload + frame->payload_len);
+            (void)uvgrtp::frame::dealloc_frame(frame);
+        }
+    }
+
+    cleanup_ms(sess, sender);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+
+    return received;
+}
+
+TEST(FormatTests, h265_parallel_scl)
+{
+    std::cout << "Starting H265 parallel SCL test" << std::endl;
+
+    const size_t size = 1200000;
+    std::unique_ptr<uint8_t[]> frame_data = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
+    memset(frame_data.get(), 'b', size);
+
+    /* Parameter sets, slices with start codes crossing and starting at the boundaries of the 256 KB
+     * chunks scanned by different threads and a small NAL unit at the end which is aggregated with the
+     * parameter sets. The slices are sent as single NAL unit packets because the receiver
+     * reassembles only one fragmented NAL unit per timestamp */
+    std::vector<std::pair<size_t, uint8_t>> start_codes = { { 0, 32 }, { 40, 33 }, { 80, 34 }, { 200, 19 },
+        { size - 40, 39 } };
+    std::vector<size_t> boundary_codes = { 262142, 524287, 786431 };
+
+    for (size_t pos = 50000; pos < size - 40; pos += 50000)
+    {
+        start_codes.push_back({ pos, 1 });
+    }
+    for (auto& pos : boundary_codes)
+    {
+        start_codes.push_back({ pos, 1 });
+    }
+    std::sort(start_codes.begin(), start_codes.end());
+
+    std::vector<std::vector<uint8_t>> nals; // without the start codes
+    size_t nal_start = 0;
+    for (size_t i = 0; i < start_codes.size(); ++i)
+    {
+        size_t pos = start_codes[i].first;
+        uint8_t zeros = (start_codes[i].first == 524287) ? 2 : 3;
+
+        if (i > 0)
+        {
+            nals.emplace_back(frame_data.get() + nal_start, frame_data.get() + start_codes[i].first);
+        }
+
+        set_nal_unit(frame_data.get(), pos, true, zeros, (start_codes[i].second << 1), 1);
+        nal_start = start_codes[i].first + zeros + 1;
+    }
+    nals.emplace_back(frame_data.get() + nal_start, frame_data.get() + size);
+
+    // the NAL units are packetized and aggregated the same way as when the frame is scanned on one thread
+    std::vector<std::vector<uint8_t>> serial = send_and_receive_h265(RCE_NO_FLAGS, frame_data.get(), size, nals.size());
+    std::vector<std::vector<uint8_t>> parallel = send_and_receive_h265(RCE_PARALLEL_SCL, frame_data.get(), size, nals.size());
+
+    EXPECT_EQ(nals.size(), parallel.size());
+    EXPECT_TRUE(serial == parallel);
+
+    // the aggregated NAL units come first, but every NAL unit is received
+    std::sort(nals.begin(), nals.end());
+    std::sort(parallel.begin(), parallel.end());
+    EXPECT_TRUE(nals == parallel);
+}
+
+TEST(FormatTests, h265_scatter_gather)
+{
+    std::cout << "Starting H265 scatter-gather receive test" << std::endl;
+    uvgrtp::context ctx;
+    uvgrtp::session* sess = ctx.create_session(LOCAL_ADDRESS);
+
+    uvgrtp::media_stream* sender = nullptr;
+    uvgrtp::media_stream* receiver = nullptr;
+
+    if (sess)
+    {
+        sender = sess->create_stream(SEND_PORT, RECEIVE_PORT, RTP_FORMAT_H265, RCE_NO_FLAGS);
+        receiver = sess->create_stream(RECEIVE_PORT, SEND_PORT, RTP_FORMAT_H265, RCE_H26X_SCATTER_GATHER);
+    }
+
+    EXPECT_NE(nullptr, sender);
+    EXPECT_NE(nullptr, receiver);
+
+    if (sender && receiver)
+    {
+        // single NAL units are contiguous, fragmented ones are returned as a list of the received payloads
+        std::vector<size_t> test_sizes = { 100, 1000, 5000, 100, 25000 };
+        std::vector<uvgrtp::frame::rtp_frame*> frames;
+        std::vector<std::unique_ptr<uint8_t[]>> expected_frames;
+
+        for (auto& size : test_sizes)
+        {
+            std::unique_ptr<uint8_t[]> intra_frame = create_test_packet(RTP_FORMAT_H265, 19, true, size, RTP_NO_FLAGS);
+
+            // varying data so that fragments in the wrong order are noticed
+            for (size_t i = 6; i < size; ++i)
+            {
+                intra_frame[i] = (uint8_t)(2 + i % 251);
+            }
+
+            std::unique_ptr<uint8_t[]> expected = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
+            memcpy(expected.get(), intra_frame.get(), size);
+
+            EXPECT_EQ(RTP_OK, sender->push_frame(std::move(intra_frame), size, RTP_NO_FLAGS));
+
+            uvgrtp::frame::rtp_frame* frame = receiver->pull_frame(1000);
+            EXPECT_NE(nullptr, frame);
+
+            if (frame)
+            {
+                std::vector<uint8_t> nal_unit;
+
+                if (frame->fragment_count == 0)
+                {
+                    nal_unit.assign(frame->payload, frame->payload + frame->payload_len);
+                }
+                else
+                {
+                    EXPECT_EQ(frame->payload, frame->fragments[0].data);
+                    EXPECT_EQ(frame->payload_len, frame->fragments[0].len);
+
+                    for (size_t i = 0; i < frame->fragment_count; ++i)
+                    {
+                        nal_unit.insert(nal_unit.end(), frame->fragments[i].data,
+                            frame->fragments[i].data + frame->fragments[i].len);
+                    }
+                }
+
+                EXPECT_EQ(size > 1500, frame->fragment_count > 0);
+                EXPECT_EQ(size, nal_unit.size());
+                if (nal_unit.size() == size)
+                {
+                    // start code and NAL unit data, the NAL header of fragmented units is rebuilt by the receiver
+                    EXPECT_EQ(0, memcmp(expected.get(), nal_unit.data(), 4));
+                    EXPECT_EQ(0, memcmp(expected.get() + 6, nal_unit.data() + 6, size - 6));
+                }
+
+                // the fragments must stay valid while earlier frames are held
+                frames.push_back(frame);
+                expected_frames.push_back(std::move(expected));
+            }
+        }
+
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            if (frames[i]->fragment_count > 0)
+            {
+                EXPECT_EQ(0, memcmp(expected_frames[i].get() + 6, frames[i]->fragments[1].data,
+                    frames[i]->fragments[1].len));
+            }
+            (void)uvgrtp::frame::dealloc_frame(frames[i]);
+        }
+    }
+
+    cleanup_ms(sess, sender);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+}
+
+TEST(FormatTests, h265_fragment_window)
+{
+    std::cout << "Starting H265 fragment window test" << std::endl;
+    uvgrtp::context ctx;
+    uvgrtp::session* sess = ctx.create_session(LOCAL_ADDRESS);
+
+    uvgrtp::media_stream* sender = nullptr;
+    uvgrtp::media_stream* receiver = nullptr;
+
+    if (sess)
+    {
+        sender = sess->create_stream(SEND_PORT, RECEIVE_PORT, RTP_FORMAT_H265, RCE_PACE_FRAGMENT_SENDING);
+        receiver = sess->create_stream(RECEIVE_PORT, SEND_PORT, RTP_FORMAT_H265, RCE_NO_FLAGS);
+    }
+
+    EXPECT_NE(nullptr, sender);
+    EXPECT_NE(nullptr, receiver);
+
+    if (sender && receiver)
+    {
+        sender->configure_ctx(RCC_FPS_NUMERATOR, 10);
+        sender->configure_ctx(RCC_FPS_DENOMINATOR, 1);
+
+        receiver->configure_ctx(RCC_UDP_RCV_BUF_SIZE, 40 * 1000 * 1000);
+        receiver->configure_ctx(RCC_RING_BUFFER_SIZE, 40 * 1000 * 1000);
+
+        // the largest frames have more fragments than the initial fragment window can hold
+        std::vector<size_t> test_sizes = { 100000, 3000000, 100000, 3000000 };
+
+        for (auto& size : test_sizes)
+        {
+            std::unique_ptr<uint8_t[]> intra_frame = create_test_packet(RTP_FORMAT_H265, 19, true, size, RTP_NO_FLAGS);
+
+            for (size_t i = 6; i < size; ++i)
+            {
+                intra_frame[i] = (uint8_t)(2 + i % 251);
+            }
+
+            std::unique_ptr<uint8_t[]> expected = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
+            memcpy(expected.get(), intra_frame.get(), size);
+
+            EXPECT_EQ(RTP_OK, sender->push_frame(std::move(intra_frame), size, RTP_NO_FLAGS));
+
+            uvgrtp::frame::rtp_frame* frame = receiver->pull_frame(2000);
+            EXPECT_NE(nullptr, frame);
+
+            if (frame)
+            {
+                EXPECT_EQ(size, frame->payload_len);
+                if (frame->payload_len == size)
+                {
+                    EXPECT_EQ(0, memcmp(expected.get() + 6, frame->payload + 6, size - 6));
+                }
+
+                (void)uvgrtp::frame::dealloc_frame(frame);
+            }
+        }
+    }
+
+    cleanup_ms(sess, sender);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+}
+
+// H265 packet with the given payload header type, "fu_header" is the third byte of the payload
+static uvgrtp::frame::rtp_frame* create_h265_packet(uint16_t seq, uint32_t ts, uint8_t type, uint8_t fu_header)
+{
+    uvgrtp::frame::rtp_frame* frame = uvgrtp::frame::alloc_rtp_frame(100);
+    memset(frame->payload, 'b', frame->payload_len);
+
+    frame->header.version = 2;
+    frame->header.seq = seq;
+    frame->header.timestamp = ts;
+    frame->payload[0] = (uint8_t)(type << 1);
+    frame->payload[1] = 1;
+    frame->payload[2] = fu_header;
+
+    return frame;
+}
+
+TEST(FormatTests, h265_early_loss_detection)
+{
+    std::cout << "Starting H265 early loss detection test" << std::endl;
+    auto ssrc = std::make_shared<std::atomic<std::uint32_t>>(1);
+    auto rtp = std::make_shared<uvgrtp::rtp>(RTP_FORMAT_H265, ssrc);
+    auto socket = std::shared_ptr<uvgrtp::socket>(new uvgrtp::socket(0));
+    uvgrtp::formats::h265 format(socket, rtp, RCE_NO_FLAGS);
+
+    const uint8_t fu_type = 49;
+    const uint8_t idr = 19;
+    const uint8_t trail = 1;
+
+    // fragments 10, 11 and 13 of a frame arrive, 12 is late
+    uvgrtp::frame::rtp_frame* frame = create_h265_packet(10, 1000, fu_type, 0x80 | idr);
+    EXPECT_EQ(RTP_OK, format.packet_handler(RCE_NO_FLAGS, &frame));
+    frame = create_h265_packet(11, 1000, fu_type, idr);
+    EXPECT_EQ(RTP_OK, format.packet_handler(RCE_NO_FLAGS, &frame));
+    frame = create_h265_packet(13, 1000, fu_type, 0x40 | idr);
+    EXPECT_EQ(RTP_OK, format.packet_handler(RCE_NO_FLAGS, &frame));
+
+    // a fragment reordered by a few packets still completes the frame
+    uint16_t seq = 14;
+    for (; seq < 20; ++seq)
+    {
+        frame = create_h265_packet(seq, 2000, trail, 0);
+        EXPECT_EQ(RTP_PKT_READY, format.packet_handler(RCE_NO_FLAGS, &frame));
+        (void)uvgrtp::frame::dealloc_frame(frame);
+    }
+
+    frame = create_h265_packet(12, 1000, fu_type, idr);
+    EXPECT_EQ(RTP_PKT_READY, format.packet_handler(RCE_NO_FLAGS, &frame));
+    EXPECT_EQ(4 + 2 + 4 * (100 - 3), frame->payload_len);
+    (void)uvgrtp::frame::dealloc_frame(frame);
+
+    // the same loss, but the stream moves on further than any packet is reordered
+    frame = create_h265_packet(seq++, 3000, fu_type, 0x80 | idr);
+    EXPECT_EQ(RTP_OK, format.packet_handler(RCE_NO_FLAGS, &frame));
+    uint16_t lost_seq = seq++;
+    frame = create_h265_packet(seq++, 3000, fu_type, 0x40 | idr);
+    EXPECT_EQ(RTP_OK, format.packet_handler(RCE_NO_FLAGS, &frame));
+
+    for (int i = 0; i < 100; ++i, ++seq)
+    {
+        frame = create_h265_packet(seq, 4000, trail, 0);
+        EXPECT_EQ(RTP_PKT_READY, format.packet_handler(RCE_NO_FLAGS, &frame));
+        (void)uvgrtp::frame::dealloc_frame(frame);
+    }
+
+    // the frame was dropped before its deadline, so the late fragment is discarded
+    frame = create_h265_packet(lost_seq, 3000, fu_type, idr);
+    EXPECT_EQ(RTP_GENERIC_ERROR, format.packet_handler(RCE_NO_FLAGS, &frame));
+}
+
+TEST(FormatTests, h265_multiple_fragmented_nal_units)
+{
+    std::cout << "Starting H265 multiple fragmented NAL units test" << std::endl;
+    uvgrtp::context ctx;
+    uvgrtp::session* sess = ctx.create_session(LOCAL_ADDRESS);
+
+    uvgrtp::media_stream* sender = nullptr;
+    uvgrtp::media_stream* receiver = nullptr;
+
+    if (sess)
+    {
+        sender = sess->create_stream(SEND_PORT, RECEIVE_PORT, RTP_FORMAT_H265, RCE_NO_FLAGS);
+        receiver = sess->create_stream(RECEIVE_PORT, SEND_PORT, RTP_FORMAT_H265, RCE_NO_H26X_PREPEND_SC);
+    }
+
+    EXPECT_NE(nullptr, sender);
+    EXPECT_NE(nullptr, receiver);
+
+    if (sender && receiver)
+    {
+        // two NAL units of different types in one frame, both fragmented
+        const size_t nal_size = 20000;
+        const size_t size = 2 * (4 + nal_size);
+        const uint8_t nal_types[2] = { 19, 1 };
+
+        std::unique_ptr<uint8_t[]> frame_data = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
+        memset(frame_data.get(), 'c', size);
+
+        for (size_t i = 0, pos = 0; i < 2; ++i)
+        {
+            size_t start = pos;
+            set_nal_unit(frame_data.get(), pos, true, 3, (nal_types[i] << 1), 1);
+            pos = start + 4 + nal_size;
+        }
+
+        std::unique_ptr<uint8_t[]> expected = std::unique_ptr<uint8_t[]>(new uint8_t[size]);
+        memcpy(expected.get(), frame_data.get(), size);
+
+        EXPECT_EQ(RTP_OK, sender->push_frame(std::move(frame_data), size, RTP_NO_FLAGS));
+
+        /* The receiver reassembles only one fragmented NAL unit per timestamp, but the first one
+         * shows whether its fragmentation units were sent with the headers of the other NAL unit */
+        uvgrtp::frame::rtp_frame* frame = receiver->pull_frame(1000);
+        EXPECT_NE(nullptr, frame);
+
+        if (frame)
+        {
+            EXPECT_EQ(nal_size, frame->payload_len);
+            if (frame->payload_len == nal_size)
+            {
+                EXPECT_EQ(0, memcmp(expected.get() + 4, frame->payload, nal_size));
+            }
+
+            (void)uvgrtp::frame::dealloc_frame(frame);
+        }
+    }
+
+    cleanup_ms(sess, sender);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+}
+
+TEST(FormatTests, h265_aggregation_packet_release)
+{
+    std::cout << "Starting H265 aggregation packet release test" << std::endl;
+    auto ssrc = std::make_shared<std::atomic<std::uint32_t>>(1);
+    auto rtp = std::make_shared<uvgrtp::rtp>(RTP_FORMAT_H265, ssrc);
+    auto socket = std::shared_ptr<uvgrtp::socket>(new uvgrtp::socket(0));
+    uvgrtp::formats::h265 format(socket, rtp, RCE_NO_H26X_PREPEND_SC);
+
+    // an aggregation packet of two 10 byte NAL units
+    const uint8_t ap_type = 48;
+    const size_t nal_size = 10;
+    uvgrtp::frame::rtp_frame* frame = uvgrtp::frame::alloc_rtp_frame(2 + 2 * (2 + nal_size));
+
+    frame->header.version = 2;
+    frame->payload[0] = (uint8_t)(ap_type << 1);
+    frame->payload[1] = 1;
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        uint8_t* nal = frame->payload + 2 + i * (2 + nal_size);
+        nal[0] = 0;
+        nal[1] = (uint8_t)nal_size;
+        memset(nal + 2, 'a' + (int)i, nal_size);
+    }
+
+    // the NAL units are copied out, so the handler frees the aggregation packet itself
+    EXPECT_EQ(RTP_MULTIPLE_PKTS_READY, format.packet_handler(RCE_NO_H26X_PREPEND_SC, &frame));
+    EXPECT_EQ(nullptr, frame);
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        uvgrtp::frame::rtp_frame* nal = nullptr;
+        EXPECT_EQ(RTP_PKT_READY, format.frame_getter(&nal));
+
+        if (nal)
+        {
+            EXPECT_EQ(nal_size, nal->payload_len);
+            EXPECT_EQ('a' + (int)i, nal->payload[nal->payload_len - 1]);
+            (void)uvgrtp::frame::dealloc_frame(nal);
+        }
+    }
+}
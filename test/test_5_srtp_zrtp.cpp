@@ -1,5 +1,10 @@
 #include "test_common.hh"
 
+#include "../src/srtp/srtp.hh"
+#include "../src/crypto.hh"
+
+#include <cstring>
+
 
 // network parameters of example
 constexpr char SENDER_ADDRESS[] = "127.0.0.1";
@@ -21,6 +26,8 @@ void zrtp_sender_func(uvgrtp::session* sender_session, int sender_port, int rece
 void zrtp_receive_func(uvgrtp::session* receiver_session, int sender_port, int receiver_port, unsigned int flags);
 
 void test_user_key(Key_length len);
+void test_aead_user_key(unsigned int flags);
+void test_generic_user_key(unsigned int flags, size_t frame_size, int frames, int keystream_packets = 0);
 
 // User key management test
 
@@ -301,6 +308,376 @@ TEST(EncryptionTests, zrtp_multistream)
     cleanup_sess(ctx, receiver_session);
 }
 
+TEST(EncryptionTests, srtp_aead_gcm_128)
+{
+    test_aead_user_key(0);
+}
+
+TEST(EncryptionTests, srtp_aead_gcm_256)
+{
+    test_aead_user_key(RCE_SRTP_KEYSIZE_256 | RCE_SRTP_REPLAY_PROTECTION);
+}
+
+TEST(EncryptionTests, srtp_replay_window)
+{
+    uvgrtp::context ctx;
+
+    if (!ctx.crypto_enabled())
+    {
+        std::cout << "Please link crypto to uvgRTP library in order to tests its SRTP replay protection!" << std::endl;
+        FAIL();
+        return;
+    }
+
+    uint8_t key[16] = { 0 };
+    uint8_t salt[SALT_SIZE_BYTES] = { 0 };
+
+    int flags = RCE_SRTP | RCE_SRTP_KMNGMNT_USER | RCE_SRTP_AUTHENTICATE_RTP | RCE_SRTP_REPLAY_PROTECTION;
+    uvgrtp::srtp srtp(flags);
+    ASSERT_EQ(RTP_OK, srtp.init(uvgrtp::SRTP, flags, key, key, salt, salt));
+
+    EXPECT_FALSE(srtp.is_replayed_packet(100));
+    EXPECT_TRUE(srtp.is_replayed_packet(100));
+
+    // reordered packets within the window are accepted once
+    EXPECT_FALSE(srtp.is_replayed_packet(99));
+    EXPECT_TRUE(srtp.is_replayed_packet(99));
+
+    // default window is 128 packets
+    EXPECT_FALSE(srtp.is_replayed_packet(300));
+    EXPECT_TRUE(srtp.is_replayed_packet(150));
+    EXPECT_FALSE(srtp.is_replayed_packet(200));
+
+    EXPECT_EQ(RTP_INVALID_VALUE, srtp.set_replay_window(32));
+    EXPECT_EQ(RTP_INVALID_VALUE, srtp.set_replay_window(2048));
+    EXPECT_EQ(RTP_OK, srtp.set_replay_window(1024));
+
+    // the packets that were skipped when the window moved past them are not marked as received
+    EXPECT_FALSE(srtp.is_replayed_packet(150));
+    EXPECT_TRUE(srtp.is_replayed_packet(150));
+    EXPECT_TRUE(srtp.is_replayed_packet(200));
+
+    // a jump larger than the window forgets everything before it
+    EXPECT_FALSE(srtp.is_replayed_packet((1ull << 32) + 5));
+    EXPECT_TRUE(srtp.is_replayed_packet(300));
+    EXPECT_FALSE(srtp.is_replayed_packet((1ull << 32) + 4));
+}
+
+TEST(EncryptionTests, srtp_aead_gcm_salt)
+{
+    uvgrtp::context ctx;
+
+    if (!ctx.crypto_enabled())
+    {
+        std::cout << "Please link crypto to uvgRTP library in order to tests its SRTP support!" << std::endl;
+        FAIL();
+        return;
+    }
+
+    uint8_t key[16] = { 0 };
+    uint8_t salt[SALT_SIZE_BYTES] = { 0 };
+    uint8_t padded_salt[SALT_SIZE_BYTES] = { 0 };
+
+    for (int i = 0; i < 12; ++i)
+    {
+        salt[i] = padded_salt[i] = (uint8_t)(i + 1);
+    }
+
+    // RFC 7714 salts are 96 bits, so the last two bytes must not change the session keys
+    salt[12] = 0xab;
+    salt[13] = 0xcd;
+
+    int flags = RCE_SRTP | RCE_SRTP_KMNGMNT_USER | RCE_SRTP_AEAD_AES_GCM;
+    uvgrtp::srtp srtp(flags);
+    uvgrtp::srtp padded_srtp(flags);
+    ASSERT_EQ(RTP_OK, srtp.init(uvgrtp::SRTP, flags, key, key, salt, salt));
+    ASSERT_EQ(RTP_OK, padded_srtp.init(uvgrtp::SRTP, flags, key, key, padded_salt, padded_salt));
+
+    EXPECT_EQ(0, memcmp(srtp.get_local_ctx()->enc_key, padded_srtp.get_local_ctx()->enc_key, sizeof(key)));
+    EXPECT_EQ(0, memcmp(srtp.get_local_ctx()->salt_key, padded_srtp.get_local_ctx()->salt_key, 12));
+}
+
+TEST(EncryptionTests, srtp_parallel)
+{
+    // several batches of packets per frame so that sending is pipelined with encryption
+    test_generic_user_key(RCE_PARALLEL_SRTP | RCE_SRTP_AUTHENTICATE_RTP, 600000, 5);
+}
+
+TEST(EncryptionTests, srtp_parallel_aead_gcm)
+{
+    test_generic_user_key(RCE_PARALLEL_SRTP | RCE_SRTP_AEAD_AES_GCM, 600000, 5);
+}
+
+TEST(EncryptionTests, srtp_keystream)
+{
+    // the ring is refilled while waiting for each frame to be received
+    test_generic_user_key(RCE_SRTP_AUTHENTICATE_RTP, 100000, 10, 128);
+}
+
+TEST(EncryptionTests, srtp_keystream_parallel)
+{
+    test_generic_user_key(RCE_PARALLEL_SRTP | RCE_SRTP_AUTHENTICATE_RTP, 600000, 5, 512);
+}
+
+TEST(EncryptionTests, crypto_backends)
+{
+    uvgrtp::context ctx;
+
+    if (!ctx.crypto_enabled())
+    {
+        std::cout << "Please link crypto to uvgRTP library in order to tests its crypto backends!" << std::endl;
+        FAIL();
+        return;
+    }
+
+    std::vector<uvgrtp::crypto::backend::library *> libs = uvgrtp::crypto::backend::available();
+    ASSERT_FALSE(libs.empty());
+    EXPECT_EQ(uvgrtp::crypto::backend::selected(), libs.front());
+
+    for (uvgrtp::crypto::backend::library *lib : libs)
+    {
+        std::cout << "Testing crypto backend " << lib->name() << std::endl;
+
+        // RFC 3711 B.2 AES-CM keystream
+        const uint8_t ctr_key[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                                      0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+        const uint8_t ctr_iv[16]  = { 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+                                      0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0x00, 0x00 };
+        const uint8_t keystream[32] = { 0xe0, 0x3e, 0xad, 0x09, 0x35, 0xc9, 0x5e, 0x80,
+                                        0xe1, 0x66, 0xb1, 0x6d, 0xd9, 0x2b, 0x4e, 0xb4,
+                                        0xd2, 0x35, 0x13, 0x16, 0x2b, 0x02, 0xd0, 0xf7,
+                                        0x2a, 0x43, 0xa2, 0xfe, 0x4a, 0x5f, 0x97, 0xab };
+        uint8_t zeros[32] = { 0 };
+        uint8_t out[32]   = { 0 };
+
+        auto ctr = lib->aes_ctr(ctr_key, sizeof(ctr_key), ctr_iv);
+        ctr->encrypt(out, zeros, sizeof(zeros));
+        EXPECT_EQ(0, memcmp(out, keystream, sizeof(keystream)));
+
+        // restarting from the IV gives the same keystream, also when split over several calls
+        ctr->set_iv(ctr_iv);
+        ctr->encrypt(out, zeros, 5);
+        ctr->encrypt(out + 5, zeros, 27);
+        EXPECT_EQ(0, memcmp(out, keystream, sizeof(keystream)));
+
+        ctr->set_iv(ctr_iv);
+        ctr->decrypt(out, keystream, sizeof(keystream));
+        EXPECT_EQ(0, memcmp(out, zeros, sizeof(zeros)));
+
+        // RFC 2202 HMAC-SHA1 test case 2 and RFC 4231 HMAC-SHA256 test case 2
+        const char *jefe = "Jefe";
+        const char *msg  = "what do ya want for nothing?";
+        const uint8_t sha1_mac[20] = { 0xef, 0xfc, 0xdf, 0x6a, 0xe5, 0xeb, 0x2f, 0xa2, 0xd2, 0x74,
+                                       0x16, 0xd5, 0xf1, 0x84, 0xdf, 0x9c, 0x25, 0x9a, 0x7c, 0x79 };
+        const uint8_t sha256_mac[32] = { 0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e,
+                                         0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7,
+                                         0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83,
+                                         0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43 };
+
+        auto hmac_sha1 = lib->hmac_sha1((const uint8_t *)jefe, strlen(jefe));
+        EXPECT_EQ(sizeof(sha1_mac), hmac_sha1->size());
+
+        // final() keeps the key for the next message
+        for (int i = 0; i < 2; ++i)
+        {
+            hmac_sha1->update((const uint8_t *)msg, strlen(msg));
+            hmac_sha1->final(out, sizeof(sha1_mac));
+            EXPECT_EQ(0, memcmp(out, sha1_mac, sizeof(sha1_mac)));
+        }
+
+        // SRTP authentication tags are truncated to 10 bytes
+        memset(out, 0, sizeof(out));
+        hmac_sha1->update((const uint8_t *)msg, 10);
+        hmac_sha1->update((const uint8_t *)msg + 10, strlen(msg) - 10);
+        hmac_sha1->final(out, 10);
+        EXPECT_EQ(0, memcmp(out, sha1_mac, 10));
+        EXPECT_EQ(0, out[10]);
+
+        auto hmac_sha256 = lib->hmac_sha256((const uint8_t *)jefe, strlen(jefe));
+        hmac_sha256->update((const uint8_t *)msg, strlen(msg));
+        hmac_sha256->final(out, hmac_sha256->size());
+        EXPECT_EQ(0, memcmp(out, sha256_mac, sizeof(sha256_mac)));
+
+        // FIPS 180-2 SHA-256 of "abc"
+        const uint8_t abc_hash[32] = { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+                                       0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+                                       0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+                                       0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad };
+
+        auto sha = lib->sha256();
+        for (int i = 0; i < 2; ++i)
+        {
+            sha->update((const uint8_t *)"abc", 3);
+            sha->final(out, sha->size());
+            EXPECT_EQ(0, memcmp(out, abc_hash, sizeof(abc_hash)));
+        }
+
+        // GCM test case 2 of the original specification, then a round trip with associated data
+        const uint8_t gcm_ct[16]  = { 0x03, 0x88, 0xda, 0xce, 0x60, 0xb6, 0xa3, 0x92,
+                                      0xf3, 0x28, 0xc2, 0xb9, 0x71, 0xb2, 0xfe, 0x78 };
+        const uint8_t gcm_tag[16] = { 0xab, 0x6e, 0x47, 0xd4, 0x2c, 0xec, 0x13, 0xbd,
+                                      0xf5, 0x3a, 0x67, 0xb2, 0x12, 0x57, 0xbd, 0xdf };
+        uint8_t gcm_iv[12] = { 0 };
+        uint8_t tag[16]    = { 0 };
+
+        auto gcm = lib->aes_gcm(zeros, 16);
+        gcm->set_iv(gcm_iv, sizeof(gcm_iv));
+        gcm->encrypt(out, zeros, 16);
+        gcm->final(tag, sizeof(tag));
+        EXPECT_EQ(0, memcmp(out, gcm_ct, sizeof(gcm_ct)));
+        EXPECT_EQ(0, memcmp(tag, gcm_tag, sizeof(gcm_tag)));
+
+        uint8_t aad[12]       = { 0x80, 0x60, 0x00, 0x01 };
+        uint8_t plaintext[20] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+        uint8_t decrypted[20] = { 0 };
+        gcm_iv[11] = 1;
+
+        gcm->set_iv(gcm_iv, sizeof(gcm_iv));
+        gcm->authenticate(aad, sizeof(aad));
+        gcm->encrypt(out, plaintext, sizeof(plaintext));
+        gcm->final(tag, sizeof(tag));
+
+        EXPECT_TRUE(gcm->decrypt(decrypted, out, sizeof(plaintext), gcm_iv, sizeof(gcm_iv),
+                                 aad, sizeof(aad), tag, sizeof(tag)));
+        EXPECT_EQ(0, memcmp(decrypted, plaintext, sizeof(plaintext)));
+
+        aad[3] ^= 1;
+        EXPECT_FALSE(gcm->decrypt(decrypted, out, sizeof(plaintext), gcm_iv, sizeof(gcm_iv),
+                                  aad, sizeof(aad), tag, sizeof(tag)));
+
+        // both sides of a Diffie-Hellman exchange arrive at the same secret
+        const size_t DH_LEN = 384;
+        std::vector<uint8_t> pk1(DH_LEN), pk2(DH_LEN), ss1(DH_LEN), ss2(DH_LEN);
+
+        auto dh1 = lib->dh3072();
+        auto dh2 = lib->dh3072();
+        dh1->generate_keys();
+        dh2->generate_keys();
+        dh1->get_pk(pk1.data(), DH_LEN);
+        dh2->get_pk(pk2.data(), DH_LEN);
+        dh1->set_remote_pk(pk2.data(), DH_LEN);
+        dh2->set_remote_pk(pk1.data(), DH_LEN);
+        dh1->get_shared_secret(ss1.data(), DH_LEN);
+        dh2->get_shared_secret(ss2.data(), DH_LEN);
+
+        EXPECT_NE(pk1, pk2);
+        EXPECT_EQ(ss1, ss2);
+    }
+
+    // CRC-32 of ZRTP messages does not depend on the backend
+    uint32_t crc = uvgrtp::crypto::crc32::calculate_crc32((const uint8_t *)"123456789", 9);
+    const uint8_t check[4] = { 0x26, 0x39, 0xf4, 0xcb };
+    EXPECT_EQ(0, memcmp(&crc, check, sizeof(check)));
+    EXPECT_TRUE(uvgrtp::crypto::crc32::verify_crc32((const uint8_t *)"123456789", 9, crc));
+}
+
+void test_aead_user_key(unsigned int flags)
+{
+    // several packets per frame so that each of them is decrypted and verified separately
+    test_generic_user_key(flags | RCE_SRTP_AEAD_AES_GCM, 5000, 10);
+}
+
+void test_generic_user_key(unsigned int flags, size_t frame_size, int frames, int keystream_packets)
+{
+    uvgrtp::context ctx;
+
+    if (!ctx.crypto_enabled())
+    {
+        std::cout << "Please link crypto to uvgRTP library in order to tests its SRTP support!" << std::endl;
+        FAIL();
+        return;
+    }
+
+    uint8_t key[32] = { 0 };
+    uint8_t salt[SALT_SIZE_BYTES] = { 0 };
+
+    for (int i = 0; i < 32; ++i)
+        key[i] = i * 3;
+
+    for (int i = 0; i < SALT_SIZE_BYTES; ++i)
+        salt[i] = i * 5;
+
+    flags |= RCE_SRTP | RCE_SRTP_KMNGMNT_USER | RCE_FRAGMENT_GENERIC;
+
+    uvgrtp::session* sess = ctx.create_session(RECEIVER_ADDRESS, SENDER_ADDRESS);
+    uvgrtp::media_stream* sender = nullptr;
+    uvgrtp::media_stream* receiver = nullptr;
+
+    if (sess)
+    {
+        sender   = sess->create_stream(SENDER_PORT + 10, RECEIVER_PORT + 10, RTP_FORMAT_GENERIC, flags);
+        receiver = sess->create_stream(RECEIVER_PORT + 10, SENDER_PORT + 10, RTP_FORMAT_GENERIC, flags);
+    }
+
+    ASSERT_NE(nullptr, sender);
+    ASSERT_NE(nullptr, receiver);
+    EXPECT_EQ(RTP_OK, sender->add_srtp_ctx(key, salt));
+    EXPECT_EQ(RTP_OK, receiver->add_srtp_ctx(key, salt));
+
+    if (keystream_packets)
+        EXPECT_EQ(RTP_OK, sender->configure_ctx(RCC_SRTP_KEYSTREAM_PACKETS, keystream_packets));
+
+    for (int i = 0; i < frames; ++i)
+    {
+        std::unique_ptr<uint8_t[]> frame(new uint8_t[frame_size]);
+        for (size_t j = 0; j < frame_size; ++j)
+            frame[j] = (uint8_t)(i + j);
+
+        EXPECT_EQ(RTP_OK, sender->push_frame(std::move(frame), frame_size, RTP_NO_FLAGS));
+
+        uvgrtp::frame::rtp_frame* received = receiver->pull_frame(1000);
+        ASSERT_NE(nullptr, received);
+        ASSERT_EQ(frame_size, received->payload_len);
+
+        bool matches = true;
+        for (size_t j = 0; j < frame_size; ++j)
+            matches = matches && received->payload[j] == (uint8_t)(i + j);
+
+        EXPECT_TRUE(matches);
+        (void)uvgrtp::frame::dealloc_frame(received);
+    }
+
+    cleanup_ms(sess, sender);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+}
+
+TEST(EncryptionTests, zrtp_aead_gcm)
+{
+    uvgrtp::context ctx;
+
+    if (!ctx.crypto_enabled())
+    {
+        std::cout << "Please link crypto to uvgRTP library in order to tests its ZRTP feature!" << std::endl;
+        FAIL();
+        return;
+    }
+
+    uvgrtp::session* sender_session = ctx.create_session(RECEIVER_ADDRESS, SENDER_ADDRESS);
+    uvgrtp::session* receiver_session = ctx.create_session(SENDER_ADDRESS, RECEIVER_ADDRESS);
+
+    unsigned zrtp_flags = RCE_SRTP | RCE_SRTP_KMNGMNT_ZRTP | RCE_SRTP_AEAD_AES_GCM;
+
+    std::unique_ptr<std::thread> sender_thread =
+        std::unique_ptr<std::thread>(new std::thread(zrtp_sender_func, sender_session, SENDER_PORT, RECEIVER_PORT, zrtp_flags));
+
+    std::unique_ptr<std::thread> receiver_thread =
+        std::unique_ptr<std::thread>(new std::thread(zrtp_receive_func, receiver_session, SENDER_PORT, RECEIVER_PORT, zrtp_flags));
+
+    if (sender_thread && sender_thread->joinable())
+    {
+        sender_thread->join();
+    }
+
+    if (receiver_thread && receiver_thread->joinable())
+    {
+        receiver_thread->join();
+    }
+
+    cleanup_sess(ctx, sender_session);
+    cleanup_sess(ctx, receiver_session);
+}
+
 void zrtp_sender_func(uvgrtp::session* sender_session, int sender_port, int receiver_port, unsigned int flags)
 {
     std::cout << "Starting ZRTP sender thread" << std::endl;
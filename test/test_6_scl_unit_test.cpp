@@ -3,11 +3,14 @@
 #include <iostream>
 #include <cstdint>
 #include <cstring>
+#include <random>
+#include <vector>
 
 #include "test_common.hh"
 
 #include "../src/formats/h264.hh"
 #include "../src/formats/h266.hh"
+#include "../src/formats/scl.hh"
 
 const int DATA_SIZE = 128;
 const int DATA_VALUE = 128;
@@ -110,4 +113,63 @@ TEST(FormatTests, h266_scl) {
         EXPECT_EQ(4 + offset, (int)out);
         EXPECT_EQ(4, start_len);
     }
-}
\ No newline at end of file
+}
+
+// reference implementation of the start code lookup
+static ssize_t find_start_code_reference(const uint8_t* data, size_t len, size_t offset, uint8_t& start_len)
+{
+    for (size_t pos = offset; pos + 3 <= len; ++pos) {
+        if (data[pos] == 0 && data[pos + 1] == 0 && data[pos + 2] == 1) {
+            start_len = (pos > offset && data[pos - 1] == 0) ? 4 : 3;
+            return (ssize_t)(pos + 3);
+        }
+    }
+    return -1;
+}
+
+static void test_scl_kernel(size_t kernel);
+
+TEST(FormatTests, h26x_scl_random) {
+    for (size_t kernel = 0; kernel < uvgrtp::formats::start_code_lookup_count(); ++kernel) {
+        std::cout << "Testing " << uvgrtp::formats::start_code_lookup_name(kernel) << " SCL against reference" << std::endl;
+        SCOPED_TRACE(uvgrtp::formats::start_code_lookup_name(kernel));
+        test_scl_kernel(kernel);
+    }
+}
+
+static void test_scl_kernel(size_t kernel)
+{
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<int> choice(0, 9);
+
+    for (size_t len = 1; len < 300; ++len) {
+        // start codes and runs of zeros, also across the SIMD block boundaries
+        std::vector<uint8_t> buffer(len);
+        for (auto& b : buffer) {
+            int c = choice(rng);
+            b = (c < 3) ? 0 : (c == 3) ? 1 : (uint8_t)byte(rng);
+        }
+
+        // the lookup must not modify the data
+        const std::vector<uint8_t> original = buffer;
+        const uint8_t* data = buffer.data();
+
+        size_t offset = 0;
+        while (true) {
+            uint8_t start_len = 0;
+            uint8_t expected_len = 0;
+            ssize_t out = uvgrtp::formats::find_start_code(data, len, offset, start_len, kernel);
+            ssize_t expected = find_start_code_reference(data, len, offset, expected_len);
+
+            ASSERT_EQ(expected, out) << "length " << len << ", offset " << offset;
+            if (out < 0)
+                break;
+
+            EXPECT_EQ(expected_len, start_len);
+            offset = (size_t)out;
+        }
+
+        EXPECT_EQ(original, buffer);
+    }
+}
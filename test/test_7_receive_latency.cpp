@@ -0,0 +1,140 @@
+// Benchmarks the per-packet receive latency of the default receive path
+// (receiver thread + processor thread) against RCE_RUN_TO_COMPLETION and the context reactor
+
+#include "test_common.hh"
+
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+
+constexpr char LOCAL_ADDRESS[] = "127.0.0.1";
+constexpr uint16_t SEND_PORT = 9400;
+constexpr uint16_t RECEIVE_PORT = 9402;
+
+constexpr int LATENCY_TEST_PACKETS = 2000;
+constexpr size_t LATENCY_PAYLOAD_LEN = 160; // 20 ms of G.711 audio
+constexpr int LATENCY_PACKET_INTERVAL_US = 200;
+
+struct latency_results {
+    std::mutex mtx;
+    std::vector<int64_t> latencies_ns;
+};
+
+static int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void latency_hook(void* arg, uvgrtp::frame::rtp_frame* frame)
+{
+    int64_t received = now_ns();
+    latency_results* results = (latency_results*)arg;
+
+    if (frame->payload_len >= sizeof(int64_t))
+    {
+        int64_t sent = 0;
+        memcpy(&sent, frame->payload, sizeof(int64_t));
+
+        std::lock_guard<std::mutex> lk(results->mtx);
+        results->latencies_ns.push_back(received - sent);
+    }
+
+    (void)uvgrtp::frame::dealloc_frame(frame);
+}
+
+static void measure_latency(int receive_flags, const std::string& name, bool reactor = false)
+{
+    uvgrtp::context ctx;
+
+    if (reactor && ctx.enable_reactor(1) != RTP_OK)
+    {
+        std::cout << "Reactor not supported on this platform, skipping" << std::endl;
+        return;
+    }
+
+    uvgrtp::session* sess = ctx.create_session(LOCAL_ADDRESS);
+
+    uvgrtp::media_stream* sender = nullptr;
+    uvgrtp::media_stream* receiver = nullptr;
+
+    if (sess)
+    {
+        sender = sess->create_stream(SEND_PORT, RECEIVE_PORT, RTP_FORMAT_GENERIC, RCE_NO_FLAGS);
+        receiver = sess->create_stream(RECEIVE_PORT, SEND_PORT, RTP_FORMAT_GENERIC, receive_flags);
+    }
+
+    EXPECT_NE(nullptr, sender);
+    EXPECT_NE(nullptr, receiver);
+
+    // the hook may be called until the receiver has been destroyed
+    latency_results results;
+
+    if (sender && receiver)
+    {
+        results.latencies_ns.reserve(LATENCY_TEST_PACKETS);
+        EXPECT_EQ(RTP_OK, receiver->install_receive_hook(&results, latency_hook));
+
+        // to increase the likelyhood that receiver thread is ready to receive
+        std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < LATENCY_TEST_PACKETS; ++i)
+        {
+            std::unique_ptr<uint8_t[]> packet = std::unique_ptr<uint8_t[]>(new uint8_t[LATENCY_PAYLOAD_LEN]);
+            memset(packet.get(), 'a', LATENCY_PAYLOAD_LEN);
+
+            int64_t sent = now_ns();
+            memcpy(packet.get(), &sent, sizeof(int64_t));
+
+            EXPECT_EQ(RTP_OK, sender->push_frame(std::move(packet), LATENCY_PAYLOAD_LEN, RTP_NO_FLAGS));
+
+            std::this_thread::sleep_until(start + std::chrono::microseconds(LATENCY_PACKET_INTERVAL_US * (i + 1)));
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        std::vector<int64_t> latencies;
+        {
+            std::lock_guard<std::mutex> lk(results.mtx);
+            latencies = results.latencies_ns;
+        }
+
+        // loopback should not lose packets, but leave room for a loaded test machine
+        EXPECT_GE(latencies.size(), (size_t)(LATENCY_TEST_PACKETS * 9 / 10));
+
+        if (!latencies.empty())
+        {
+            std::sort(latencies.begin(), latencies.end());
+            double mean = std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+
+            std::cout << name << ": " << latencies.size() << "/" << LATENCY_TEST_PACKETS << " packets"
+                << ", mean " << mean / 1000.0 << " us"
+                << ", median " << latencies[latencies.size() / 2] / 1000.0 << " us"
+                << ", p99 " << latencies[latencies.size() * 99 / 100] / 1000.0 << " us"
+                << ", max " << latencies.back() / 1000.0 << " us" << std::endl;
+        }
+    }
+
+    cleanup_ms(sess, sender);
+    cleanup_ms(sess, receiver);
+    cleanup_sess(ctx, sess);
+}
+
+TEST(LatencyTests, receive_latency_processor_thread)
+{
+    std::cout << "Starting receive latency test with a separate processor thread" << std::endl;
+    measure_latency(RCE_NO_FLAGS, "Processor thread");
+}
+
+TEST(LatencyTests, receive_latency_run_to_completion)
+{
+    std::cout << "Starting receive latency test with run-to-completion" << std::endl;
+    measure_latency(RCE_RUN_TO_COMPLETION, "Run-to-completion");
+}
+
+TEST(LatencyTests, receive_latency_reactor)
+{
+    std::cout << "Starting receive latency test with the context reactor" << std::endl;
+    measure_latency(RCE_NO_FLAGS, "Reactor", true);
+}